@@ -21,15 +21,28 @@ settings.add("exec.space_prefix", true, "Whitespace prefix matches files",
 matching and will do normal files matching instead.]])
 
 --------------------------------------------------------------------------------
-local function get_environment_paths()
-    local paths = os.getenv("path"):explode(";")
+local pathext_list
+local pathext_patterns
+
+local function get_exec_patterns(name)
+    -- os.getenvlist() returns the same table until PATHEXT changes so patterns
+    -- for the common case of an empty name can be made once and reused.
+    local exts = os.getenvlist("pathext")
+    if name == "" and exts == pathext_list then
+        return pathext_patterns
+    end
+
+    local patterns = {}
+    for i, ext in ipairs(exts) do
+        patterns[i] = name.."*"..ext
+    end
 
-    -- Append slashes.
-    for i = 1, #paths, 1 do
-        paths[i] = paths[i].."/"
+    if name == "" then
+        pathext_list = exts
+        pathext_patterns = patterns
     end
 
-    return paths
+    return patterns
 end
 
 --------------------------------------------------------------------------------
@@ -74,7 +87,7 @@ function exec_generator:generate(line_state, match_builder)
     local match_dirs = settings.get("exec.dirs")
     local match_cwd = settings.get("exec.cwd")
 
-    local paths = nil
+    local match_path = false
     local text = line_state:getword(1)
     local text_dir = path.getdirectory(text) or ""
     if #text_dir == 0 then
@@ -82,10 +95,8 @@ function exec_generator:generate(line_state, match_builder)
         local aliases = os.getaliases()
         match_builder:addmatches(aliases)
 
-        -- Add environment's PATH variable as paths to search.
-        if settings.get("exec.path") then
-            paths = get_environment_paths()
-        end
+        -- Search the directories in the environment's PATH variable.
+        match_path = settings.get("exec.path")
     else
         -- 'text' is an absolute or relative path so override settings and
         -- match current directory and its directories too.
@@ -93,24 +104,18 @@ function exec_generator:generate(line_state, match_builder)
         match_cwd = true
     end
 
-    if not paths then
-        paths = {}
+    -- Search for files ending in one of PATHEXT's extensions.
+    local added = false
+    if match_path then
+        local count = match_builder:addglob(os.getenvlist("path"), get_exec_patterns(""))
+        added = (count > 0)
     end
 
     -- Should we also consider the path referenced by 'text'?
     if match_cwd then
-        table.insert(paths, text)
-    end
-
-    -- Search 'paths' for files ending in 'suffices' and look for matches
-    local added = false
-    local suffices = os.getenv("pathext"):explode(";")
-    for _, suffix in ipairs(suffices) do
-        for _, dir in ipairs(paths) do
-            for _, file in ipairs(os.globfiles(dir.."*"..suffix)) do
-                added = match_builder:addmatch(file) or added
-            end
-        end
+        local patterns = get_exec_patterns(path.getname(text))
+        local count = match_builder:addglob({ text_dir }, patterns)
+        added = added or (count > 0)
     end
 
     -- Lastly we may wish to consider directories too.
@@ -5,8 +5,132 @@
 clink = clink or {}
 local prompt_filters = {}
 local prompt_filters_unsorted = false
+local prompt_in = ""
 
+-- Coroutines of prompt filters that are allowed to yield while waiting on I/O.
+local async_coroutines = setmetatable({}, { __mode = "k" })
 
+-- Keeps io.popenyield()'s processes alive for as long as their output's open.
+local spawned_outputs = setmetatable({}, { __mode = "k" })
+
+local _prompt_filter = {}
+_prompt_filter.__index = _prompt_filter
+
+
+
+--------------------------------------------------------------------------------
+local function profile(category, id_func, func, ...)
+    -- clink._profile() only exists when Lua scripts are being profiled.
+    local profile = clink._profile
+    if profile then
+        return profile(category, id_func, func, ...)
+    end
+
+    return func(...)
+end
+
+--------------------------------------------------------------------------------
+local function get_cache_key(filter, prompt)
+    -- Filters that declare cache keys are only run when the prompt they're given
+    -- or one of the keys has changed.
+    local keys = filter._cache_keys
+    if not keys then
+        return
+    end
+
+    local parts = { prompt }
+    for _, key in ipairs(keys) do
+        local value
+        if key.kind == "cwd" then
+            value = os.getcwd()
+        elseif key.kind == "env" then
+            value = os.getenv(key.value)
+        elseif key.kind == "file" then
+            value = os._getfiletime(key.value)
+        end
+
+        table.insert(parts, tostring(value))
+    end
+
+    return table.concat(parts, "\0")
+end
+
+--------------------------------------------------------------------------------
+local function resume_filter(filter, ...)
+    -- A filter's state is either finished ('result') or waiting on a coroutine
+    -- in which case the last values it yielded are used as a placeholder.
+    local ret = table.pack(profile("filter", filter.filter, coroutine.resume,
+        filter._coroutine, ...))
+    if not ret[1] then
+        filter._coroutine = nil
+        error(ret[2], 0)
+    end
+
+    local state = { ret[2], ret[3] }
+    if coroutine.status(filter._coroutine) == "dead" then
+        filter._coroutine = nil
+        filter._result = state
+
+        if filter._run_key then
+            filter._cache_key = filter._run_key
+            filter._cache_state = state
+        end
+    elseif ret.n > 1 or not filter._placeholder then
+        filter._placeholder = state
+    end
+end
+
+--------------------------------------------------------------------------------
+local function apply_filters(prompt)
+    local pending = false
+    for _, filter in ipairs(prompt_filters) do
+        local state = filter._result
+        if not state and not filter._coroutine then
+            local cache_key = get_cache_key(filter, prompt)
+            if cache_key and cache_key == filter._cache_key then
+                state = filter._cache_state
+            else
+                -- Filters are run as coroutines so that they may yield.
+                filter._run_key = cache_key
+                filter._coroutine = coroutine.create(filter.filter)
+                async_coroutines[filter._coroutine] = true
+                resume_filter(filter, filter, prompt)
+                state = filter._result
+            end
+        end
+
+        if not state then
+            state = filter._placeholder
+            pending = true
+        end
+
+        -- Only async filters' results persist. The others are rerun each time.
+        if filter._placeholder == nil then
+            filter._result = nil
+        end
+
+        local filtered, onwards = state[1], state[2]
+        if filtered ~= nil then
+            if onwards == false then return filtered, pending end
+            prompt = filtered
+        end
+    end
+
+    return prompt, pending
+end
+
+--------------------------------------------------------------------------------
+local function pcall_filters(impl, ...)
+    local ok, ret, pending = pcall(impl, ...)
+    if not ok then
+        print("")
+        print(ret)
+        print(debug.traceback())
+        return false
+    end
+
+    return ret, pending
+end
 
 --------------------------------------------------------------------------------
 function clink._filter_prompt(prompt)
@@ -18,38 +142,114 @@ function clink._filter_prompt(prompt)
         prompt_filters_unsorted = false
     end
 
-    -- Protected call to prompt filters.
-    local impl = function(prompt)
+    -- Abandon any coroutines still running from the previous prompt.
+    for _, filter in ipairs(prompt_filters) do
+        filter._coroutine = nil
+        filter._result = nil
+        filter._placeholder = nil
+        filter._run_key = nil
+    end
+
+    prompt_in = prompt
+    return pcall_filters(apply_filters, prompt)
+end
+
+--------------------------------------------------------------------------------
+function clink._resume_prompt_filters()
+    -- Resumes filters that yielded. Returns the newly filtered prompt if any of
+    -- them have progressed (or nil otherwise), and if any are still pending.
+    local impl = function()
+        local changed = false
+        local pending = false
         for _, filter in ipairs(prompt_filters) do
-            local filtered, onwards = filter:filter(prompt)
-            if filtered ~= nil then
-                if onwards == false then return filtered end
-                prompt = filtered
+            if filter._coroutine then
+                local before = filter._placeholder
+                resume_filter(filter)
+
+                if filter._coroutine then
+                    local after = filter._placeholder
+                    changed = changed or (before[1] ~= after[1]) or (before[2] ~= after[2])
+                    pending = true
+                else
+                    changed = true
+                end
             end
         end
 
-        return prompt
-    end
+        if not changed then
+            return nil, pending
+        end
 
-    local ok, ret = pcall(impl, prompt)
-    if not ok then
-        print("")
-        print(ret)
-        print(debug.traceback())
-        return false
+        return apply_filters(prompt_in)
     end
 
-    return ret
+    return pcall_filters(impl)
 end
 
 --------------------------------------------------------------------------------
 --- -name:  clink.promptfilter
 --- -arg:   [priority:integer]
 --- -ret:   table
+--- Creates a prompt filter. Its filter(prompt) method is called with the prompt
+--- and returns the filtered prompt (and false to stop further filtering). The
+--- method may yield (see io.popenyield()) in which case any value it yields is
+--- used as a placeholder and the prompt is redrawn once the filter finishes.
 function clink.promptfilter(priority)
     if priority == nil then priority = 999 end
 
-    local ret = { _priority = priority }
+    local ret = setmetatable({ _priority = priority }, _prompt_filter)
     table.insert(prompt_filters, ret)
     return ret
 end
+
+
+
+--------------------------------------------------------------------------------
+--- -name:  promptfilter:addcachekey
+--- -arg:   kind:string
+--- -arg:   [value:string]
+--- -ret:   self
+--- -show:  local pf = clink.promptfilter(50)
+--- -show:  pf:addcachekey("cwd"):addcachekey("file", ".git/HEAD")
+--- Declares something that the filter's result depends on. When a filter has
+--- cache keys its previous result is reused as long as its input prompt and all
+--- of the keys are unchanged. The 'kind' is one of; "cwd" (the current
+--- directory), "env" (the environment variable named 'value'), or "file" (the
+--- last write time of the file at path 'value').
+function _prompt_filter:addcachekey(kind, value)
+    self._cache_keys = self._cache_keys or {}
+    table.insert(self._cache_keys, { kind = kind, value = value })
+    self._cache_key = nil
+    return self
+end
+
+--------------------------------------------------------------------------------
+--- -name:  io.popenyield
+--- -arg:   command:string
+--- -ret:   file
+--- Like io.popen(command) but when called from a prompt filter it runs the
+--- command in the background and yields until the command has finished. The
+--- command's output is returned as a file opened for reading. Elsewhere this
+--- behaves exactly like io.popen().
+function io.popenyield(command)
+    local co = coroutine.running()
+    if not co or not async_coroutines[co] then
+        return io.popen(command)
+    end
+
+    local spawned = os._spawn(command)
+    if not spawned then
+        return io.popen(command)
+    end
+
+    while not spawned:isdone() do
+        coroutine.yield()
+    end
+
+    local file = io.open(spawned:getoutputpath())
+    if file then
+        spawned_outputs[file] = spawned
+    end
+
+    return file
+end
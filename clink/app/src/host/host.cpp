@@ -10,6 +10,7 @@
 #include "utils/scroller.h"
 
 #include <core/globber.h>
+#include <core/log.h>
 #include <core/os.h>
 #include <core/path.h>
 #include <core/settings.h>
@@ -21,7 +22,9 @@
 #include <lua/lua_script_loader.h>
 #include <lua/lua_state.h>
 #include <lua/lua_match_generator.h>
+#include <lua/lua_profiler.h>
 #include <terminal/terminal.h>
+#include <terminal/terminal_in.h>
 
 extern "C" {
 #include <lua.h>
@@ -44,6 +47,54 @@ static setting_bool g_add_history_cmd(
 
 
 
+//------------------------------------------------------------------------------
+static long long get_ticks()
+{
+    LARGE_INTEGER ticks;
+    QueryPerformanceCounter(&ticks);
+    return ticks.QuadPart;
+}
+
+//------------------------------------------------------------------------------
+static void record_startup(long long ticks)
+{
+    // How long the first line took to be ready for input, for 'clink info'.
+    LARGE_INTEGER freq;
+    QueryPerformanceFrequency(&freq);
+    double ms = (ticks * 1000.0) / double(freq.QuadPart);
+
+    LOG("Startup took %.2f ms", ms);
+
+    str<280> startup_path;
+    app_context::get()->get_startup_path(startup_path);
+    if (FILE* out = fopen(startup_path.c_str(), "wt"))
+    {
+        fprintf(out, "%.2f ms\n", ms);
+        fclose(out);
+    }
+}
+
+//------------------------------------------------------------------------------
+static void dump_profile(const lua_profiler& profiler)
+{
+    str<> report;
+    profiler.report(report);
+    if (report.empty())
+        return;
+
+    LOG("Lua profile:\n%s", report.c_str());
+
+    str<280> profile_path;
+    app_context::get()->get_profile_path(profile_path);
+    if (FILE* out = fopen(profile_path.c_str(), "wt"))
+    {
+        fputs(report.c_str(), out);
+        fclose(out);
+    }
+}
+
+
+
 //------------------------------------------------------------------------------
 host::host(const char* name)
 : m_name(name)
@@ -53,11 +104,53 @@ host::host(const char* name)
 //------------------------------------------------------------------------------
 host::~host()
 {
+    destroy_lua();
+}
+
+//------------------------------------------------------------------------------
+bool host::load_settings(const char* settings_file)
+{
+    // Settings are only reloaded if the file's been touched since last time.
+    long long settings_time = os::get_file_time(settings_file);
+    if (m_settings_time == settings_time)
+        return false;
+
+    m_settings_time = settings_time;
+    settings::load(settings_file);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+void host::load_lua(const char* settings_file)
+{
+    destroy_lua();
+
+    // Set up Lua and load scripts into it.
+    m_lua = new host_lua();
+    m_prompt_filter = new prompt_filter(*m_lua);
+    initialise_lua(*m_lua);
+    m_lua->load_scripts();
+
+    // Unfortunately we need to load settings again because some settings don't
+    // exist until after Lua's up and running. But.. we can't load Lua scripts
+    // without loading settings first. [TODO: find a better way]
+    settings::load(settings_file);
+}
+
+//------------------------------------------------------------------------------
+void host::destroy_lua()
+{
+    delete m_prompt_filter;
+    delete m_lua;
+    m_prompt_filter = nullptr;
+    m_lua = nullptr;
 }
 
 //------------------------------------------------------------------------------
 bool host::edit_line(const char* prompt, str_base& out)
 {
+    long long start_ticks = get_ticks();
+
     const app_context* app = app_context::get();
     app->update_env();
 
@@ -71,7 +164,7 @@ bool host::edit_line(const char* prompt, str_base& out)
     // Load Clink's settings.
     str<288> settings_file;
     app_context::get()->get_settings_path(settings_file);
-    settings::load(settings_file.c_str());
+    bool settings_changed = load_settings(settings_file.c_str());
 
     // Set up the string comparison mode.
     int cmp_mode;
@@ -83,23 +176,23 @@ bool host::edit_line(const char* prompt, str_base& out)
     }
     str_compare_scope compare(cmp_mode);
 
-    // Set up Lua and load scripts into it.
-    host_lua lua;
-    prompt_filter prompt_filter(lua);
-    initialise_lua(lua);
-    lua.load_scripts();
-
-    // Unfortunately we need to load settings again because some settings don't
-    // exist until after Lua's up and running. But.. we can't load Lua scripts
-    // without loading settings first. [TODO: find a better way]
-    settings::load(settings_file.c_str());
+    // The Lua state lives across lines. It is only rebuilt if settings changed
+    // (they may affect how Lua's set up) or if any of the scripts have changed.
+    if (m_lua == nullptr || settings_changed || m_lua->is_stale())
+        load_lua(settings_file.c_str());
+    host_lua& lua = *m_lua;
 
     line_editor::desc desc = {};
     initialise_editor_desc(desc);
 
+    // Readline's state after loading the inputrc files is cached here.
+    str<288> snapshot_path;
+    app->get_snapshot_path(snapshot_path);
+    desc.snapshot_path = snapshot_path.c_str();
+
     // Filter the prompt.
     str<256> filtered_prompt;
-    prompt_filter.filter(prompt, filtered_prompt);
+    m_prompt_filter->filter(prompt, filtered_prompt);
     desc.prompt = filtered_prompt.c_str();
 
     // Set the terminal that will handle all IO while editing.
@@ -113,6 +206,9 @@ bool host::edit_line(const char* prompt, str_base& out)
     editor_module* completer = tab_completer_create();
     editor->add_module(*completer);
 
+    editor_module* menu = menu_completer_create();
+    editor->add_module(*menu);
+
     scroller_module scroller;
     editor->add_module(scroller);
 
@@ -125,10 +221,31 @@ bool host::edit_line(const char* prompt, str_base& out)
     m_history.initialise();
     m_history.load_rl_history();
 
+    if (!m_startup_recorded)
+    {
+        record_startup(get_ticks() - start_ticks);
+        m_startup_recorded = true;
+    }
+
+    // Drive the editor ourselves rather than using edit() so that prompt filters
+    // waiting on I/O can be resumed while waiting for input. The prompt's then
+    // redrawn as they finish.
+    auto edit = [&] () -> bool {
+        while (editor->update())
+        {
+            if (m_prompt_filter->resume(filtered_prompt))
+                editor->set_prompt(filtered_prompt.c_str());
+
+            terminal.in->select(m_prompt_filter->is_pending() ? 50 : -1);
+        }
+
+        return editor->get_line(out.data(), out.size());
+    };
+
     bool ret = false;
     while (1)
     {
-        if (ret = editor->edit(out.data(), out.size()))
+        if (ret = edit())
         {
             // Handle history event expansion.
             if (m_history.expand(out.c_str(), out) == history_db::expand_print)
@@ -155,7 +272,14 @@ bool host::edit_line(const char* prompt, str_base& out)
     }
 
     line_editor_destroy(editor);
+    menu_completer_destroy(menu);
     tab_completer_destroy(completer);
     terminal_destroy(terminal);
+
+    // If Lua's being profiled make the results so far available to 'clink profile'.
+    const lua_state& state = lua;
+    if (const lua_profiler* profiler = state.get_profiler())
+        dump_profile(*profiler);
+
     return ret;
 }
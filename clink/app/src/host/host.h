@@ -7,7 +7,9 @@
 
 #include <lib/line_editor.h>
 
+class host_lua;
 class lua_state;
+class prompt_filter;
 class str_base;
 
 //------------------------------------------------------------------------------
@@ -27,6 +29,13 @@ protected:
 
 private:
     void            filter_prompt(const char* in, str_base& out);
+    bool            load_settings(const char* settings_file);
+    void            load_lua(const char* settings_file);
+    void            destroy_lua();
     const char*     m_name;
     history_db      m_history;
+    host_lua*       m_lua = nullptr;
+    prompt_filter*  m_prompt_filter = nullptr;
+    long long       m_settings_time = 0;
+    bool            m_startup_recorded = false;
 };
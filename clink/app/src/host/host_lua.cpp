@@ -10,6 +10,7 @@
 #include <core/path.h>
 #include <core/settings.h>
 #include <core/str.h>
+#include <core/str_hash.h>
 #include <core/str_tokeniser.h>
 
 extern "C" {
@@ -54,6 +55,8 @@ host_lua::operator match_generator& ()
 //------------------------------------------------------------------------------
 void host_lua::load_scripts()
 {
+    m_scripts_stamp = get_scripts_stamp();
+
     const char* setting_clink_path = g_clink_path.get();
     load_scripts(setting_clink_path);
 
@@ -80,12 +83,62 @@ void host_lua::load_script(const char* path)
     str<280> buffer;
     path::join(path, "*.lua", buffer);
 
+    str<280> cache_dir;
+    app_context::get()->get_script_cache_dir(cache_dir);
+
     globber lua_globs(buffer.c_str());
     lua_globs.directories(false);
 
     while (lua_globs.next(buffer))
-        m_state.do_file(buffer.c_str());
+        m_state.do_file(buffer.c_str(), cache_dir.c_str());
 }
 
 
 
+
+//------------------------------------------------------------------------------
+bool host_lua::is_stale() const
+{
+    // Scripts are stale if any have been added, removed or modified, or if the
+    // paths they're loaded from have changed.
+    return (get_scripts_stamp() != m_scripts_stamp);
+}
+
+//------------------------------------------------------------------------------
+unsigned int host_lua::get_scripts_stamp()
+{
+    unsigned int stamp = get_scripts_stamp(g_clink_path.get(), 0);
+
+    str<256> env_clink_path;
+    os::get_env("clink_path", env_clink_path);
+    return get_scripts_stamp(env_clink_path.c_str(), stamp);
+}
+
+//------------------------------------------------------------------------------
+unsigned int host_lua::get_scripts_stamp(const char* paths, unsigned int stamp)
+{
+    if (paths == nullptr || paths[0] == '\0')
+        return stamp;
+
+    stamp ^= str_hash(paths);
+
+    str<280> token;
+    str_tokeniser tokens(paths, ";");
+    while (tokens.next(token))
+    {
+        str<280> buffer;
+        path::join(token.c_str(), "*.lua", buffer);
+
+        globber lua_globs(buffer.c_str());
+        lua_globs.directories(false);
+
+        while (lua_globs.next(buffer))
+        {
+            long long time = os::get_file_time(buffer.c_str());
+            stamp = (stamp * 33) ^ str_hash(buffer.c_str());
+            stamp = (stamp * 33) ^ (unsigned int)(time ^ (time >> 32));
+        }
+    }
+
+    return stamp;
+}
@@ -14,10 +14,14 @@ public:
                         operator lua_state& ();
                         operator match_generator& ();
     void                load_scripts();
+    bool                is_stale() const;
 
 private:
     void                load_scripts(const char* paths);
     void                load_script(const char* path);
+    static unsigned int get_scripts_stamp();
+    static unsigned int get_scripts_stamp(const char* paths, unsigned int stamp);
     lua_state           m_state;
     lua_match_generator m_generator;
+    unsigned int        m_scripts_stamp = 0;
 };
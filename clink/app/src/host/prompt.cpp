@@ -165,7 +165,8 @@ void prompt_filter::filter(const char* in, str_base& out)
 
     lua_pushstring(state, in);
 
-    if (lua_pcall(state, 1, 1, 0) != 0)
+    m_pending = false;
+    if (lua_pcall(state, 1, 2, 0) != 0)
     {
         puts(lua_tostring(state, -1));
         lua_pop(state, 2);
@@ -173,10 +174,50 @@ void prompt_filter::filter(const char* in, str_base& out)
     }
 
     // Collect the filtered prompt.
-    const char* prompt = lua_tostring(state, -1);
+    const char* prompt = lua_tostring(state, -2);
     out = prompt;
 
-    lua_pop(state, 2);
+    // Filters that yielded are waiting on something. They're resumed later on.
+    m_pending = (lua_toboolean(state, -1) != 0);
+
+    lua_pop(state, 3);
+}
+
+//------------------------------------------------------------------------------
+bool prompt_filter::resume(str_base& out)
+{
+    if (!m_pending)
+        return false;
+
+    lua_State* state = m_lua.get_state();
+
+    lua_getglobal(state, "clink");
+    lua_pushliteral(state, "_resume_prompt_filters");
+    lua_rawget(state, -2);
+
+    m_pending = false;
+    if (lua_pcall(state, 0, 2, 0) != 0)
+    {
+        puts(lua_tostring(state, -1));
+        lua_pop(state, 2);
+        return false;
+    }
+
+    // Returns nil if nothing's changed since the last time.
+    bool changed = (lua_type(state, -2) == LUA_TSTRING);
+    if (changed)
+        out = lua_tostring(state, -2);
+
+    m_pending = (lua_toboolean(state, -1) != 0);
+
+    lua_pop(state, 3);
+    return changed;
+}
+
+//------------------------------------------------------------------------------
+bool prompt_filter::is_pending() const
+{
+    return m_pending;
 }
 
 
@@ -43,9 +43,12 @@ class prompt_filter
 public:
                     prompt_filter(lua_state& lua);
     void            filter(const char* in, str_base& out);
+    bool            resume(str_base& out);
+    bool            is_pending() const;
 
 private:
     lua_state&      m_lua;
+    bool            m_pending = false;
 };
 
 //------------------------------------------------------------------------------
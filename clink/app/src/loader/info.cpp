@@ -5,6 +5,7 @@
 #include "utils/app_context.h"
 #include "version.h"
 
+#include <core/base.h>
 #include <core/str.h>
 #include <core/os.h>
 #include <core/path.h>
@@ -21,6 +22,8 @@ int clink_info(int argc, char** argv)
         { "log",        &app_context::get_log_path },
         { "settings",   &app_context::get_settings_path },
         { "history",    &app_context::get_history_path },
+        { "profile",    &app_context::get_profile_path },
+        { "snapshot",   &app_context::get_snapshot_path },
     };
 
     const auto* context = app_context::get();
@@ -38,6 +41,20 @@ int clink_info(int argc, char** argv)
         printf("%-*s : %s\n", spacing, info.name, out.c_str());
     }
 
+    // How long the most recent session took to be ready for its first line.
+    {
+        str<280> startup_path;
+        context->get_startup_path(startup_path);
+
+        char buffer[64] = "(unknown)\n";
+        if (FILE* in = fopen(startup_path.c_str(), "rt"))
+        {
+            fgets(buffer, sizeof_array(buffer), in);
+            fclose(in);
+        }
+        printf("%-*s : %s", spacing, "startup", buffer);
+    }
+
     // Inputrc environment variables.
     const char* env_vars[] = {
         "clink_inputrc",
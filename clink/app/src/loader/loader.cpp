@@ -20,6 +20,7 @@ int draw_test(int, char**);
 int history(int, char**);
 int inject(int, char**);
 int input_echo(int, char**);
+int profile(int, char**);
 int set(int, char**);
 int testbed(int, char**);
 
@@ -53,6 +54,7 @@ static void show_usage()
         "set",             "Adjust Clink's settings",
         "history",         "List and operate on the command history",
         "info",            "Prints information about Clink",
+        "profile",         "Show where Lua scripts spend their time",
         "echo",            "Echo key sequences",
         "",                "('<verb> --help' for more details)",
         "Options:",        "",
@@ -80,6 +82,7 @@ static int dispatch_verb(const char* verb, int argc, char** argv)
         "history",   history,
         "info",      clink_info,
         "inject",    inject,
+        "profile",   profile,
         "set",       set,
         "testbed",   testbed,
     };
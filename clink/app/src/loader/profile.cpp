@@ -0,0 +1,64 @@
+// Copyright (c) 2016 Martin Ridgers
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "utils/app_context.h"
+
+#include <core/base.h>
+#include <core/str.h>
+
+#include <getopt.h>
+
+//------------------------------------------------------------------------------
+void puts_help(const char**, int);
+
+//------------------------------------------------------------------------------
+static void print_help()
+{
+    extern const char* g_clink_header;
+
+    puts(g_clink_header);
+    puts("Usage: profile\n");
+
+    puts("Prints where Lua generators and prompt filters spent their time in the\n"
+        "most recent Clink session that had profiling enabled. Profiling is\n"
+        "enabled with 'clink set lua.profile calls' (or 'sampled' to also sample\n"
+        "which script lines are running). The results are also written to the\n"
+        "log.\n");
+}
+
+//------------------------------------------------------------------------------
+int profile(int argc, char** argv)
+{
+    struct option options[] = {
+        { "help", no_argument, nullptr, 'h' },
+        {}
+    };
+
+    int i;
+    while ((i = getopt_long(argc, argv, "+h", options, nullptr)) != -1)
+    {
+        switch (i)
+        {
+        default:
+        case 'h': print_help(); return 0;
+        }
+    }
+
+    str<280> profile_path;
+    app_context::get()->get_profile_path(profile_path);
+
+    FILE* in = fopen(profile_path.c_str(), "rt");
+    if (in == nullptr)
+    {
+        puts("No profile found. Use 'clink set lua.profile calls' to enable it.");
+        return 1;
+    }
+
+    char buffer[512];
+    while (fgets(buffer, sizeof_array(buffer), in) != nullptr)
+        fputs(buffer, stdout);
+
+    fclose(in);
+    return 0;
+}
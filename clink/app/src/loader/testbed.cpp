@@ -13,16 +13,19 @@ int testbed(int, char**)
     str_compare_scope _(str_compare_scope::relaxed);
 
     editor_module* completer = tab_completer_create();
+    editor_module* menu = menu_completer_create();
 
     line_editor::desc desc;
     line_editor* editor = line_editor_create(desc);
     editor->add_module(*completer);
+    editor->add_module(*menu);
     editor->add_generator(file_match_generator());
 
     char out[64];
     while (editor->edit(out, sizeof_array(out)));
 
     line_editor_destroy(editor);
+    menu_completer_destroy(menu);
     tab_completer_destroy(completer);
     return 0;
 }
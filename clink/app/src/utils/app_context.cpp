@@ -148,6 +148,34 @@ void app_context::get_history_path(str_base& out) const
     path::append(out, "clink_history");
 }
 
+//------------------------------------------------------------------------------
+void app_context::get_script_cache_dir(str_base& out) const
+{
+    get_state_dir(out);
+    path::append(out, "script_cache");
+}
+
+//------------------------------------------------------------------------------
+void app_context::get_profile_path(str_base& out) const
+{
+    get_state_dir(out);
+    path::append(out, "lua_profile.txt");
+}
+
+//------------------------------------------------------------------------------
+void app_context::get_snapshot_path(str_base& out) const
+{
+    get_state_dir(out);
+    path::append(out, "readline_snapshot");
+}
+
+//------------------------------------------------------------------------------
+void app_context::get_startup_path(str_base& out) const
+{
+    get_state_dir(out);
+    path::append(out, "startup_time.txt");
+}
+
 //-----------------------------------------------------------------------------
 void app_context::update_env() const
 {
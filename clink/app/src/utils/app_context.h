@@ -30,6 +30,10 @@ public:
     void        get_log_path(str_base& out) const;
     void        get_settings_path(str_base& out) const;
     void        get_history_path(str_base& out) const;
+    void        get_script_cache_dir(str_base& out) const;
+    void        get_profile_path(str_base& out) const;
+    void        get_snapshot_path(str_base& out) const;
+    void        get_startup_path(str_base& out) const;
     void        update_env() const;
 
 private:
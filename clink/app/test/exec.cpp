@@ -6,6 +6,7 @@
 #include "env_fixture.h"
 #include "line_editor_tester.h"
 
+#include <core/os.h>
 #include <core/path.h>
 #include <core/settings.h>
 #include <core/str_compare.h>
@@ -150,6 +151,23 @@ TEST_CASE("Executable match generation.")
         tester.run();
     }
 
+    SECTION("Environment changes")
+    {
+        tester.set_input("one_");
+        tester.set_expected_matches("one_path.exe", "one_two.py");
+        tester.run();
+
+        // Cached PATH and PATHEXT lists are refreshed when the variables change.
+        str<260> quoted_path;
+        quoted_path << ";\"" << path_env_var.c_str() << "\";";
+        REQUIRE(os::set_env("path", quoted_path.c_str()));
+        REQUIRE(os::set_env("pathext", ".txt"));
+
+        tester.set_input("one_");
+        tester.set_expected_matches("one_three.txt");
+        tester.run();
+    }
+
     SECTION("Current directory")
     {
         settings::find("exec.cwd")->set("1");
@@ -0,0 +1,129 @@
+// Copyright (c) 2016 Martin Ridgers
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "fs_fixture.h"
+
+#include <core/os.h>
+#include <core/str.h>
+#include <host/prompt.h>
+#include <lua/lua_state.h>
+
+//------------------------------------------------------------------------------
+TEST_CASE("Prompt filters")
+{
+    static const char* empty_fs[] = { nullptr };
+    fs_fixture fs(empty_fs);
+
+    if (FILE* out = fopen("output.txt", "wt"))
+    {
+        fputs("branch", out);
+        fclose(out);
+    }
+
+    lua_state lua;
+    prompt_filter filter(lua);
+
+    str<> out;
+
+    SECTION("Sync")
+    {
+        REQUIRE(lua.do_string("\
+            local pf = clink.promptfilter(10)\
+            function pf:filter(prompt) return '[' .. prompt .. ']' end\
+        "));
+
+        filter.filter("abc", out);
+        REQUIRE(out.equals("[abc]"));
+        REQUIRE(!filter.is_pending());
+        REQUIRE(!filter.resume(out));
+    }
+
+    SECTION("Async")
+    {
+        // A fake process that takes a few polls to finish.
+        REQUIRE(lua.do_string("\
+            os._spawn = function(command)\
+                local polls = 0\
+                return {\
+                    isdone = function() polls = polls + 1 return polls > 3 end,\
+                    getoutputpath = function() return 'output.txt' end,\
+                }\
+            end\
+            \
+            local pf = clink.promptfilter(10)\
+            function pf:filter(prompt)\
+                coroutine.yield(prompt .. ' (...)')\
+                local file = io.popenyield('git branch')\
+                local line = file:read('*l')\
+                file:close()\
+                return prompt .. ' (' .. line .. ')'\
+            end\
+            \
+            local sync = clink.promptfilter(20)\
+            function sync:filter(prompt) return prompt .. '>' end\
+        "));
+
+        filter.filter("abc", out);
+        REQUIRE(out.equals("abc (...)>"));
+        REQUIRE(filter.is_pending());
+
+        int resumes = 0;
+        while (filter.is_pending() && !filter.resume(out))
+            ++resumes;
+
+        REQUIRE(resumes == 3);
+        REQUIRE(out.equals("abc (branch)>"));
+        REQUIRE(!filter.is_pending());
+
+        // A new prompt abandons the previous one and restarts filters.
+        filter.filter("xyz", out);
+        REQUIRE(out.equals("xyz (...)>"));
+        REQUIRE(filter.is_pending());
+    }
+
+    SECTION("Cache keys")
+    {
+        REQUIRE(lua.do_string("\
+            runs = 0\
+            local pf = clink.promptfilter(10)\
+            pf:addcachekey('cwd'):addcachekey('file', 'output.txt')\
+            function pf:filter(prompt) runs = runs + 1 return prompt .. runs end\
+        "));
+
+        filter.filter("abc", out);
+        REQUIRE(out.equals("abc1"));
+
+        // Nothing's changed so the previous result is reused.
+        filter.filter("abc", out);
+        REQUIRE(out.equals("abc1"));
+
+        // Different input.
+        filter.filter("xyz", out);
+        REQUIRE(out.equals("xyz2"));
+
+        // A watched file goes away.
+        REQUIRE(os::unlink("output.txt"));
+        filter.filter("xyz", out);
+        REQUIRE(out.equals("xyz3"));
+
+        // Different current directory.
+        REQUIRE(os::make_dir("sub"));
+        REQUIRE(os::set_current_dir("sub"));
+        filter.filter("xyz", out);
+        REQUIRE(out.equals("xyz4"));
+        REQUIRE(os::set_current_dir(".."));
+    }
+
+    SECTION("Not from a filter")
+    {
+        // Outside of a prompt filter io.popenyield() doesn't yield.
+        REQUIRE(lua.do_string("\
+            os._spawn = function() error('spawned') end\
+            io.popen = function() return io.open('output.txt') end\
+            local file = io.popenyield('git branch')\
+            assert(file:read('*l') == 'branch')\
+            file:close()\
+        "));
+    }
+}
@@ -15,17 +15,19 @@ enum {
     path_type_dir,
 };
 
-int     get_path_type(const char* path);
-int     get_file_size(const char* path);
-void    get_current_dir(str_base& out);
-bool    set_current_dir(const char* dir);
-bool    make_dir(const char* dir);
-bool    remove_dir(const char* dir);
-bool    unlink(const char* path);
-bool    move(const char* src_path, const char* dest_path);
-bool    copy(const char* src_path, const char* dest_path);
-bool    get_temp_dir(str_base& out);
-bool    get_env(const char* name, str_base& out);
-bool    set_env(const char* name, const char* value);
+int       get_path_type(const char* path);
+int       get_file_size(const char* path);
+long long get_file_time(const char* path);
+bool      get_file_info(const char* path, int& size, long long& time);
+void      get_current_dir(str_base& out);
+bool      set_current_dir(const char* dir);
+bool      make_dir(const char* dir);
+bool      remove_dir(const char* dir);
+bool      unlink(const char* path);
+bool      move(const char* src_path, const char* dest_path);
+bool      copy(const char* src_path, const char* dest_path);
+bool      get_temp_dir(str_base& out);
+bool      get_env(const char* name, str_base& out);
+bool      set_env(const char* name, const char* value);
 
 }; // namespace os
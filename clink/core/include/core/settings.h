@@ -13,6 +13,7 @@ namespace settings
 
 setting*            first();
 setting*            find(const char* name);
+unsigned int        get_generation();
 bool                load(const char* file);
 bool                save(const char* file);
 
@@ -13,6 +13,7 @@ public:
     explicit        str_iter_impl(const T* s=(const T*)L"", int len=-1);
     explicit        str_iter_impl(const str_impl<T>& s, int len=-1);
     const T*        get_pointer() const;
+    void            reset_pointer(const T* ptr);
     int             peek();
     int             next();
     bool            more() const;
@@ -43,6 +44,12 @@ template <typename T> const T* str_iter_impl<T>::get_pointer() const
     return m_ptr;
 };
 
+//------------------------------------------------------------------------------
+template <typename T> void str_iter_impl<T>::reset_pointer(const T* ptr)
+{
+    m_ptr = ptr;
+}
+
 //------------------------------------------------------------------------------
 template <typename T> int str_iter_impl<T>::peek()
 {
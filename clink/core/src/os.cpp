@@ -36,6 +36,33 @@ int get_file_size(const char* path)
     return ret;
 }
 
+//------------------------------------------------------------------------------
+long long get_file_time(const char* path)
+{
+    wstr<280> wpath(path);
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if (!GetFileAttributesExW(wpath.c_str(), GetFileExInfoStandard, &data))
+        return -1;
+
+    const FILETIME& time = data.ftLastWriteTime;
+    return ((long long)time.dwHighDateTime << 32) | time.dwLowDateTime;
+}
+
+//------------------------------------------------------------------------------
+bool get_file_info(const char* path, int& size, long long& time)
+{
+    // Size and last write time with a single query, for change detection.
+    wstr<280> wpath(path);
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if (!GetFileAttributesExW(wpath.c_str(), GetFileExInfoStandard, &data))
+        return false;
+
+    const FILETIME& write_time = data.ftLastWriteTime;
+    time = ((long long)write_time.dwHighDateTime << 32) | write_time.dwLowDateTime;
+    size = int(data.nFileSizeLow);
+    return true;
+}
+
 //------------------------------------------------------------------------------
 void get_current_dir(str_base& out)
 {
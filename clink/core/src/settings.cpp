@@ -7,7 +7,71 @@
 #include "str_tokeniser.h"
 
 //------------------------------------------------------------------------------
-static setting* g_setting_list = nullptr;
+// Settings are registered from static constructors so the state here is kept
+// to plain data that's valid before any constructors have run.
+static setting*         g_setting_list = nullptr;
+static unsigned int     g_registry_generation = 0;
+
+//------------------------------------------------------------------------------
+struct setting_index_entry
+{
+    unsigned int        hash;
+    setting*            item;
+};
+
+static setting_index_entry* g_index = nullptr;
+static unsigned int     g_index_mask = 0;
+static unsigned int     g_index_generation = ~0u;
+
+
+
+//------------------------------------------------------------------------------
+static unsigned int hash_name(const char* name)
+{
+    // Names are case insensitive so they're hashed as if they're lower case.
+    unsigned int hash = 5381;
+    while (int c = *name++)
+        hash = ((hash << 5) + hash) ^ tolower(c);
+
+    return hash;
+}
+
+//------------------------------------------------------------------------------
+static void build_index()
+{
+    // An open-addressed hash table of settings, at most half full.
+    unsigned int count = 0;
+    for (auto* iter = settings::first(); iter != nullptr; iter = iter->next())
+        ++count;
+
+    unsigned int size = 16;
+    while (size < count * 2)
+        size <<= 1;
+
+    free(g_index);
+    g_index = (setting_index_entry*)calloc(size, sizeof(setting_index_entry));
+    g_index_mask = size - 1;
+    g_index_generation = g_registry_generation;
+
+    // Settings with duplicate names are found in list order, same as a search.
+    for (auto* iter = settings::first(); iter != nullptr; iter = iter->next())
+    {
+        const char* name = iter->get_name();
+        unsigned int hash = hash_name(name);
+        for (unsigned int i = hash & g_index_mask;; i = (i + 1) & g_index_mask)
+        {
+            setting_index_entry& entry = g_index[i];
+            if (entry.item == nullptr)
+            {
+                entry = { hash, iter };
+                break;
+            }
+
+            if (entry.hash == hash && stricmp(name, entry.item->get_name()) == 0)
+                break;
+        }
+    }
+}
 
 
 
@@ -23,15 +87,27 @@ setting* first()
 //------------------------------------------------------------------------------
 setting* find(const char* name)
 {
-    setting* next = first();
-    do
+    if (g_index_generation != g_registry_generation)
+        build_index();
+
+    unsigned int hash = hash_name(name);
+    for (unsigned int i = hash & g_index_mask;; i = (i + 1) & g_index_mask)
     {
-        if (stricmp(name, next->get_name()) == 0)
-            return next;
+        const setting_index_entry& entry = g_index[i];
+        if (entry.item == nullptr)
+            return nullptr;
+
+        if (entry.hash == hash && stricmp(name, entry.item->get_name()) == 0)
+            return entry.item;
     }
-    while (next = next->next());
+}
 
-    return nullptr;
+//------------------------------------------------------------------------------
+unsigned int get_generation()
+{
+    // Changes whenever a setting is added or removed, so pointers to settings
+    // that are cached against the same generation are still valid.
+    return g_registry_generation;
 }
 
 //------------------------------------------------------------------------------
@@ -186,6 +262,8 @@ setting::setting(
 
     if (m_next != nullptr)
         m_next->m_prev = this;
+
+    ++g_registry_generation;
 }
 
 //------------------------------------------------------------------------------
@@ -198,6 +276,8 @@ setting::~setting()
 
     if (m_next != nullptr)
         m_next->m_prev = m_prev;
+
+    ++g_registry_generation;
 }
 
 //------------------------------------------------------------------------------
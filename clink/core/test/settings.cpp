@@ -2,6 +2,7 @@
 // License: http://opensource.org/licenses/MIT
 
 #include "pch.h"
+#include "fs_fixture.h"
 
 #include <core/base.h>
 #include <core/settings.h>
@@ -149,3 +150,62 @@ TEST_CASE("settings : enum")
     REQUIRE(!test.set("abc"));  REQUIRE(test.get() == 2);
     REQUIRE(!test.set("0abc")); REQUIRE(test.get() == 2);
 }
+
+//------------------------------------------------------------------------------
+TEST_CASE("settings : find")
+{
+    setting_int one("!find.one", "", "", 1);
+    REQUIRE(settings::find("!find.one") == &one);
+    REQUIRE(settings::find("!FIND.One") == &one);
+    REQUIRE(settings::find("!find.two") == nullptr);
+
+    // Lookups keep up with settings coming and going.
+    {
+        setting_int two("!find.two", "", "", 2);
+        REQUIRE(settings::find("!find.two") == &two);
+        REQUIRE(settings::find("!find.one") == &one);
+    }
+
+    REQUIRE(settings::find("!find.two") == nullptr);
+    REQUIRE(settings::find("!find.one") == &one);
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("settings : load")
+{
+    fs_fixture fs;
+
+    auto write_file = [] (const char* content) {
+        FILE* out = fopen("settings", "wt");
+        REQUIRE(out != nullptr);
+        fputs(content, out);
+        fclose(out);
+    };
+
+    setting_int one("!load.one", "", "", 1);
+    write_file("!load.one = 11\n!load.two = 22\n");
+
+    REQUIRE(settings::load("settings"));
+    REQUIRE(one.get() == 11);
+
+    // Loading always resets settings to the file's values, even if the file
+    // hasn't changed, so values set in memory don't outlive a load.
+    REQUIRE(one.set("99"));
+    REQUIRE(settings::load("settings"));
+    REQUIRE(one.get() == 11);
+
+    // Settings not in the file go back to their defaults.
+    write_file("!load.two = 22\n");
+    REQUIRE(one.set("99"));
+    REQUIRE(settings::load("settings"));
+    REQUIRE(one.get() == 1);
+
+    // Settings added since the last load pick up their values too.
+    {
+        setting_int two("!load.two", "", "", 2);
+        REQUIRE(settings::load("settings"));
+        REQUIRE(two.get() == 22);
+    }
+
+    REQUIRE(!settings::load("missing"));
+}
@@ -26,6 +26,7 @@ public:
         const char*     quote_pair = "\"";
         const char*     word_delims = " \t";
         const char*     auto_quote_chars = " ";
+        const char*     snapshot_path = nullptr; // caches inputrc bindings
     };
 
     virtual             ~line_editor() = default;
@@ -34,6 +35,7 @@ public:
     virtual bool        get_line(char* out, int out_size) = 0;
     virtual bool        edit(char* out, int out_size) = 0;
     virtual bool        update() = 0;
+    virtual void        set_prompt(const char* prompt) = 0;
 };
 
 
@@ -43,3 +45,5 @@ line_editor*            line_editor_create(const line_editor::desc& desc);
 void                    line_editor_destroy(line_editor* editor);
 editor_module*          tab_completer_create();
 void                    tab_completer_destroy(editor_module* completer);
+editor_module*          menu_completer_create();
+void                    menu_completer_destroy(editor_module* completer);
@@ -15,6 +15,7 @@ public:
     virtual const char*     get_aux(unsigned int index) const = 0;
     virtual char            get_suffix(unsigned int index) const = 0;
     virtual unsigned int    get_cell_count(unsigned int index) const = 0;
+    virtual unsigned int    get_max_cell_count() const = 0;
     virtual bool            has_aux() const = 0;
     virtual void            get_match_lcd(str_base& out) const = 0;
 };
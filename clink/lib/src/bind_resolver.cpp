@@ -119,6 +119,17 @@ bool bind_resolver::step(unsigned char key)
     return step_impl(key);
 }
 
+//------------------------------------------------------------------------------
+bool bind_resolver::is_unbound(unsigned char key) const
+{
+    // True if no input is pending and 'key' wouldn't start any of the current
+    // group's chords, so it'd fall through to the group's catch-all bind.
+    if (m_key_count || m_pending_input || m_node_index != m_group)
+        return false;
+
+    return !m_binder.find_child(m_group, key);
+}
+
 //------------------------------------------------------------------------------
 bool bind_resolver::step_impl(unsigned char key)
 {
@@ -35,6 +35,7 @@ public:
     void                set_group(int group);
     int                 get_group() const;
     bool                step(unsigned char key);
+    bool                is_unbound(unsigned char key) const;
     binding             next();
     void                reset();
 
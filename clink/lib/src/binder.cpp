@@ -102,7 +102,7 @@ binder::binder()
 }
 
 //------------------------------------------------------------------------------
-int binder::get_group(const char* name)
+int binder::get_group(const char* name) const
 {
     if (name == nullptr || name[0] == '\0')
         return 1;
@@ -308,6 +308,15 @@ binder::group_node* binder::get_group_node(unsigned int index)
     return nullptr;
 }
 
+//------------------------------------------------------------------------------
+const binder::group_node* binder::get_group_node(unsigned int index) const
+{
+    if (index < sizeof_array(m_nodes))
+        return (const group_node*)(m_nodes + index);
+
+    return nullptr;
+}
+
 //------------------------------------------------------------------------------
 int binder::alloc_nodes(unsigned int count)
 {
@@ -12,7 +12,7 @@ class binder
 {
 public:
                         binder();
-    int                 get_group(const char* name=nullptr);
+    int                 get_group(const char* name=nullptr) const;
     int                 create_group(const char* name);
     bool                bind(unsigned int group, const char* chord, editor_module& module, unsigned char id);
 
@@ -53,6 +53,7 @@ private:
     int                 append(int head, unsigned char key);
     const node&         get_node(unsigned int index) const;
     group_node*         get_group_node(unsigned int index);
+    const group_node*   get_group_node(unsigned int index) const;
     int                 alloc_nodes(unsigned int count=1);
     int                 add_module(editor_module& module);
     editor_module*      get_module(unsigned int index) const;
@@ -46,7 +46,7 @@ void line_editor_destroy(line_editor* editor)
 
 //------------------------------------------------------------------------------
 line_editor_impl::line_editor_impl(const desc& desc)
-: m_module(desc.shell_name)
+: m_module(desc.shell_name, desc.snapshot_path)
 , m_desc(desc)
 , m_printer(*desc.output)
 {
@@ -102,6 +102,8 @@ void line_editor_impl::begin_line()
     m_command_offset = 0;
     m_keys_size = 0;
     m_prev_key = ~0u;
+    m_command_prefix.offset = -1;
+    m_match_prefix.offset = -1;
 
     match_pipeline pipeline(m_matches);
     pipeline.reset();
@@ -173,10 +175,13 @@ bool line_editor_impl::update()
     if (!check_flag(flag_init))
         initialise();
 
+    // Terminal output is buffered so it's flushed once everything that a
+    // key press prints has been printed.
     if (!check_flag(flag_editing))
     {
         begin_line();
         update_internal();
+        m_desc.output->flush();
         return true;
     }
 
@@ -186,14 +191,76 @@ bool line_editor_impl::update()
         return false;
 
     update_internal();
+    m_desc.output->flush();
     return true;
 }
 
+//------------------------------------------------------------------------------
+void line_editor_impl::set_prompt(const char* prompt)
+{
+    // The caller owns 'prompt' and must keep it alive while the line's edited.
+    m_desc.prompt = prompt;
+
+    if (check_flag(flag_editing))
+    {
+        m_module.set_prompt(prompt);
+        m_desc.output->flush();
+    }
+}
+
 //------------------------------------------------------------------------------
 void line_editor_impl::update_input()
 {
     int key = m_desc.input->read();
 
+    // Keys that are already queued and that Readline would just insert are
+    // most likely a paste. They're inserted in one go rather than each going
+    // through binding resolution, Readline, and update_internal().
+    if (is_paste_key(key))
+    {
+        int first = key;
+        str<256> paste;
+        do
+        {
+            char c = char(key);
+            paste.concat(&c, 1);
+            key = m_desc.input->read();
+        }
+        while (is_paste_key(key));
+
+        if (paste.length() > 1)
+        {
+            m_buffer.insert(paste.c_str());
+            m_buffer.draw();
+        }
+        else
+            dispatch_input(first);
+
+        if (!check_flag(flag_editing))
+            return;
+    }
+
+    dispatch_input(key);
+}
+
+//------------------------------------------------------------------------------
+bool line_editor_impl::is_paste_key(int key) const
+{
+    // Nul is never pasted as it would terminate the text being inserted.
+    if (key <= 0 || key > 0xff)
+        return false;
+
+    // Only the default group's catch-all is Readline's input. Other groups
+    // (tab completer's query and pager for example) ignore unbound keys.
+    if (m_bind_resolver.get_group() != m_binder.get_group())
+        return false;
+
+    return m_bind_resolver.is_unbound(key) && m_module.is_self_insert(key);
+}
+
+//------------------------------------------------------------------------------
+void line_editor_impl::dispatch_input(int key)
+{
     if (key == terminal_in::input_terminal_resize)
     {
         int columns = m_desc.output->get_columns();
@@ -372,17 +439,46 @@ void line_editor_impl::collect_words()
     }
 
     // The last word is truncated to the longest length returned by the match
-    // generators. This is a little clunky but works well enough.
-    line_state line = get_linestate();
+    // generators. This is a little clunky but works well enough. The result is
+    // remembered for the command's text up to the cursor so keys that leave it
+    // as it is (redraws, match display, etc.) don't ask the generators again.
     end_word = m_words.back();
+    int key_length = end_word->offset + end_word->length - m_command_offset;
+    line_state line = get_linestate();
+    int prefix_length = get_prefix_length(line, command_start, key_length,
+        end_word->offset, m_command_prefix);
+
+    end_word->length = min<unsigned int>(prefix_length, end_word->length);
+}
+
+//------------------------------------------------------------------------------
+// Returns the longest prefix length the generators give for 'line'. 'key' is
+// the text the result depends on; while it and the end word's offset are the
+// same as last time 'memo' answers without asking the generators again.
+int line_editor_impl::get_prefix_length(
+    const line_state& line,
+    const char* key,
+    int key_length,
+    int offset,
+    prefix_memo& memo) const
+{
+    if (memo.offset == offset
+        && memo.key.length() == unsigned(key_length)
+        && !memcmp(memo.key.c_str(), key, key_length))
+        return memo.length;
+
     int prefix_length = 0;
-    const char* word_start = line_buffer + end_word->offset;
     for (const auto* generator : m_generators)
     {
         int i = generator->get_prefix_length(line);
         prefix_length = max(prefix_length, i);
     }
-    end_word->length = min<unsigned int>(prefix_length, end_word->length);
+
+    memo.key.clear();
+    memo.key.concat(key, key_length);
+    memo.offset = offset;
+    memo.length = prefix_length;
+    return prefix_length;
 }
 
 //------------------------------------------------------------------------------
@@ -439,13 +535,8 @@ void line_editor_impl::accept_match(unsigned int index)
         array<word> match_words(&match_word, 1);
         line_state match_line = { match, match_length, 0, match_words };
 
-        int prefix_length = 0;
-        for (const auto* generator : m_generators)
-        {
-            int i = generator->get_prefix_length(match_line);
-            prefix_length = max(prefix_length, i);
-        }
-
+        int prefix_length = get_prefix_length(match_line, match, match_length,
+            0, m_match_prefix);
         if (prefix_length != match_length)
             suffix = m_desc.word_delims[0];
     }
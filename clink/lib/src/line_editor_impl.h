@@ -13,6 +13,7 @@
 #include "rl/rl_buffer.h"
 
 #include <core/array.h>
+#include <core/str.h>
 #include <terminal/printer.h>
 
 //------------------------------------------------------------------------------
@@ -26,6 +27,7 @@ public:
     virtual bool        get_line(char* out, int out_size) override;
     virtual bool        edit(char* out, int out_size) override;
     virtual bool        update() override;
+    virtual void        set_prompt(const char* prompt) override;
 
 private:
     typedef editor_module                       module;
@@ -33,6 +35,13 @@ private:
     typedef fixed_array<match_generator*, 32>   generators;
     typedef fixed_array<word, 72>               words;
 
+    struct prefix_memo
+    {
+        str<64>         key;
+        int             offset;
+        int             length;
+    };
+
     enum flags : unsigned char
     {
         flag_init       = 1 << 0,
@@ -46,8 +55,11 @@ private:
     void                end_line();
     void                find_command_bounds(const char*& start, int& length);
     void                collect_words();
+    int                 get_prefix_length(const line_state& line, const char* key, int key_length, int offset, prefix_memo& memo) const;
     void                update_internal();
     void                update_input();
+    void                dispatch_input(int key);
+    bool                is_paste_key(int key) const;
     void                accept_match(unsigned int index);
     void                append_match_lcd();
     module::context     get_context(const line_state& line) const;
@@ -66,6 +78,8 @@ private:
     matches_impl        m_matches;
     printer             m_printer;
     unsigned int        m_prev_key;
+    prefix_memo         m_command_prefix;
+    prefix_memo         m_match_prefix;
     unsigned short      m_command_offset;
     unsigned char       m_keys_size;
     unsigned char       m_flags = 0;
@@ -0,0 +1,105 @@
+// Copyright (c) 2018 Martin Ridgers
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "match_layout.h"
+#include "matches.h"
+
+#include <core/base.h>
+#include <core/str.h>
+
+//------------------------------------------------------------------------------
+void match_layout::reset()
+{
+    m_valid = false;
+}
+
+//------------------------------------------------------------------------------
+// Returns true if the layout had to be (re)calculated, false if the existing
+// one still stands.
+bool match_layout::update(
+    const matches& matches,
+    int cell_columns,
+    int column_pad,
+    bool vertical)
+{
+    int column_width = matches.get_max_cell_count() + column_pad;
+    if (m_valid
+        && m_cell_columns == cell_columns
+        && m_column_width == column_width
+        && m_vertical == vertical)
+        return false;
+
+    m_match_count = matches.get_match_count();
+    m_cell_columns = cell_columns;
+    m_column_width = column_width;
+    m_vertical = vertical;
+    m_valid = true;
+
+    // The last column doesn't need padding so it's allowed to fit in the pad.
+    m_columns = max(1, (cell_columns + column_pad) / max(1, column_width));
+    m_rows = (m_match_count + m_columns - 1) / m_columns;
+
+    str<288> lcd;
+    matches.get_match_lcd(lcd);
+    m_lcd_length = lcd.length();
+
+    return true;
+}
+
+//------------------------------------------------------------------------------
+int match_layout::get_columns() const
+{
+    return m_columns;
+}
+
+//------------------------------------------------------------------------------
+int match_layout::get_rows() const
+{
+    return m_rows;
+}
+
+//------------------------------------------------------------------------------
+int match_layout::get_column_width() const
+{
+    return m_column_width;
+}
+
+//------------------------------------------------------------------------------
+int match_layout::get_lcd_length() const
+{
+    return m_lcd_length;
+}
+
+//------------------------------------------------------------------------------
+// Returns the index of the match at 'column' and 'row', or -1 if that cell of
+// the grid is empty.
+int match_layout::get_index(int column, int row) const
+{
+    if (unsigned(column) >= unsigned(m_columns) || unsigned(row) >= unsigned(m_rows))
+        return -1;
+
+    int index = m_vertical ? (column * m_rows) + row : (row * m_columns) + column;
+    return (index < m_match_count) ? index : -1;
+}
+
+//------------------------------------------------------------------------------
+// The inverse of get_index(); finds which cell of the grid a match is in.
+bool match_layout::get_position(int index, int& column, int& row) const
+{
+    if (unsigned(index) >= unsigned(m_match_count))
+        return false;
+
+    if (m_vertical)
+    {
+        column = index / m_rows;
+        row = index % m_rows;
+    }
+    else
+    {
+        column = index % m_columns;
+        row = index / m_columns;
+    }
+
+    return true;
+}
@@ -0,0 +1,33 @@
+// Copyright (c) 2018 Martin Ridgers
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+class matches;
+
+//------------------------------------------------------------------------------
+// Arranges matches into a grid of equally wide columns. The layout is worked
+// out once per set of matches (and terminal width) so displaying any part of
+// the grid only touches the matches that are visible.
+class match_layout
+{
+public:
+    void                reset();
+    bool                update(const matches& matches, int cell_columns, int column_pad, bool vertical);
+    int                 get_columns() const;
+    int                 get_rows() const;
+    int                 get_column_width() const;
+    int                 get_lcd_length() const;
+    int                 get_index(int column, int row) const;
+    bool                get_position(int index, int& column, int& row) const;
+
+private:
+    int                 m_match_count = 0;
+    int                 m_cell_columns = 0;
+    int                 m_column_width = 0;
+    int                 m_columns = 0;
+    int                 m_rows = 0;
+    int                 m_lcd_length = 0;
+    bool                m_vertical = true;
+    bool                m_valid = false;
+};
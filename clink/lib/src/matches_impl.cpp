@@ -189,6 +189,12 @@ unsigned int matches_impl::get_cell_count(unsigned int index) const
     return (index < get_match_count()) ? m_infos[index].cell_count : 0;
 }
 
+//------------------------------------------------------------------------------
+unsigned int matches_impl::get_max_cell_count() const
+{
+    return m_max_cell_count;
+}
+
 //------------------------------------------------------------------------------
 bool matches_impl::has_aux() const
 {
@@ -239,6 +245,7 @@ void matches_impl::reset()
     m_infos.clear();
     m_coalesced = false;
     m_count = 0;
+    m_max_cell_count = 0;
     m_has_aux = false;
     m_prefix_included = false;
 }
@@ -285,6 +292,9 @@ void matches_impl::coalesce(unsigned int count_hint)
 {
     match_info* infos = &(m_infos[0]);
 
+    // The widest selected match is noted while we're here so match displays
+    // can be laid out without another pass over all the matches.
+    unsigned char max_cell_count = 0;
     unsigned int j = 0;
     for (int i = 0, n = int(m_infos.size()); i < n && j < count_hint; ++i)
     {
@@ -297,9 +307,12 @@ void matches_impl::coalesce(unsigned int count_hint)
             infos[j] = infos[i];
             infos[i] = temp;
         }
+
+        max_cell_count = max(max_cell_count, infos[j].cell_count);
         ++j;
     }
 
     m_count = j;
+    m_max_cell_count = max_cell_count;
     m_coalesced = true;
 }
@@ -47,6 +47,7 @@ public:
     virtual const char*     get_aux(unsigned int index) const override;
     virtual char            get_suffix(unsigned int index) const override;
     virtual unsigned int    get_cell_count(unsigned int index) const override;
+    virtual unsigned int    get_max_cell_count() const override;
     virtual bool            has_aux() const override;
     bool                    is_prefix_included() const;
     virtual void            get_match_lcd(str_base& out) const override;
@@ -84,6 +85,7 @@ private:
     store_impl              m_store;
     infos                   m_infos;
     unsigned short          m_count = 0;
+    unsigned char           m_max_cell_count = 0;
     bool                    m_coalesced = false;
     bool                    m_has_aux = false;
     bool                    m_prefix_included = false;
@@ -0,0 +1,473 @@
+// Copyright (c) 2018 Martin Ridgers
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "menu_completer.h"
+#include "binder.h"
+#include "line_buffer.h"
+#include "matches.h"
+#include "tab_completer.h"
+
+#include <core/base.h>
+#include <core/settings.h>
+#include <core/str.h>
+#include <terminal/ecma48_iter.h>
+#include <terminal/printer.h>
+#include <terminal/setting_colour.h>
+
+#include <vector>
+
+//------------------------------------------------------------------------------
+editor_module* menu_completer_create()
+{
+    return new menu_completer();
+}
+
+//------------------------------------------------------------------------------
+void menu_completer_destroy(editor_module* completer)
+{
+    delete completer;
+}
+
+
+
+//------------------------------------------------------------------------------
+static setting_str g_key_menu(
+    "match.menu_key",
+    "Opens the completion menu",
+    "Pressing this key shows the matches in a menu below the line being\n"
+    "edited. The arrow keys, Tab and Shift-Tab move the selection, Enter\n"
+    "accepts it, and typing narrows the matches down. (default = Shift-Tab)",
+    "\\e[Z");
+
+static setting_int g_menu_rows(
+    "match.menu_rows",
+    "Rows shown by the completion menu",
+    "The completion menu shows at most this many rows of matches, scrolling\n"
+    "through the rest as the selection moves.",
+    10);
+
+
+
+//------------------------------------------------------------------------------
+enum {
+    bind_id_open,
+    bind_id_next,
+    bind_id_prev,
+    bind_id_up,
+    bind_id_down,
+    bind_id_left,
+    bind_id_right,
+    bind_id_page_up,
+    bind_id_page_down,
+    bind_id_accept,
+    bind_id_cancel,
+    bind_id_other,
+};
+
+
+
+//------------------------------------------------------------------------------
+// Works out the cursor's column and how many rows there are from the cursor's
+// row to the last row of the line being edited, inclusive. The menu is drawn
+// below that and the cursor is always put back where it was.
+static void get_cursor_position(
+    const editor_module::context& context,
+    int& cursor_column,
+    int& rows_below)
+{
+    int columns = max<int>(context.printer.get_columns(), 1);
+
+    const char* prompt = (context.prompt != nullptr) ? context.prompt : "";
+    if (const char* last_line = strrchr(prompt, '\n'))
+        prompt = last_line + 1;
+
+    const char* buffer = context.buffer.get_buffer();
+    unsigned int cursor = context.buffer.get_cursor();
+
+    str<> head;
+    head << prompt;
+    head.concat(buffer, cursor);
+    int cursor_cells = cell_count(head.c_str());
+    int end_cells = cursor_cells + cell_count(buffer + cursor);
+
+    cursor_column = cursor_cells % columns;
+    rows_below = (end_cells / columns) - (cursor_cells / columns) + 1;
+}
+
+//------------------------------------------------------------------------------
+// Formats the escape codes to go from the start of a row to 'column', and
+// from there 'rows' up (or down if negative) and back to the start of a row.
+static void append_move(str_base& out, int rows, int column)
+{
+    str<16> code;
+    if (rows > 0)
+        code.format("\r\x1b[%dA", rows);
+    else if (rows < 0)
+        code.format("\x1b[%dB\r", -rows);
+    else
+        code = "\r";
+    out << code;
+
+    if (column > 0)
+    {
+        code.format("\x1b[%dC", column);
+        out << code;
+    }
+}
+
+//------------------------------------------------------------------------------
+// Adds the runs to print a match's cell in the menu. Cells are padded to the
+// widest match so the selection's highlight is the same size whichever match
+// it's on.
+static void add_cell(
+    std::vector<print_run>& runs,
+    const matches& matches,
+    const match_layout& layout,
+    int index,
+    bool selected)
+{
+    const char* match = matches.get_displayable(index);
+    int length = int(strlen(match));
+    int padding = matches.get_max_cell_count() - matches.get_cell_count(index);
+
+    if (selected)
+    {
+        attributes highlight_attr = g_colour_highlight.get();
+        runs.push_back({ highlight_attr, match, length });
+        runs.push_back({ highlight_attr, nullptr, padding });
+        return;
+    }
+
+    // Padding's in the major colour too so that, with no background colour,
+    // it joins up with the text either side and gets written with it.
+    attributes major_attr = g_colour_major.get();
+    int lcd_length = min(layout.get_lcd_length(), length);
+    runs.push_back({ g_colour_minor.get(), match, lcd_length });
+    runs.push_back({ major_attr, match + lcd_length, length - lcd_length });
+    runs.push_back({ major_attr, nullptr, padding });
+}
+
+
+
+//------------------------------------------------------------------------------
+void menu_completer::bind_input(binder& binder)
+{
+    int default_group = binder.get_group();
+    binder.bind(default_group, g_key_menu.get(), bind_id_open);
+
+    m_bind_group = binder.create_group("menu_complete");
+    binder.bind(m_bind_group, "\t", bind_id_next);
+    binder.bind(m_bind_group, "\\e[Z", bind_id_prev);
+    binder.bind(m_bind_group, "\\e[A", bind_id_up);
+    binder.bind(m_bind_group, "\\e[B", bind_id_down);
+    binder.bind(m_bind_group, "\\e[D", bind_id_left);
+    binder.bind(m_bind_group, "\\e[C", bind_id_right);
+    binder.bind(m_bind_group, "\\e[5~", bind_id_page_up);
+    binder.bind(m_bind_group, "\\e[6~", bind_id_page_down);
+    binder.bind(m_bind_group, "\r", bind_id_accept);
+    binder.bind(m_bind_group, "^C", bind_id_cancel); // ctrl-c
+    binder.bind(m_bind_group, "^G", bind_id_cancel); // ctrl-g
+    binder.bind(m_bind_group, "", bind_id_other);
+}
+
+//------------------------------------------------------------------------------
+void menu_completer::on_begin_line(const context& context)
+{
+    m_open = false;
+    m_window_rows = 0;
+    m_drawn_rows = 0;
+}
+
+//------------------------------------------------------------------------------
+void menu_completer::on_end_line()
+{
+    m_open = false;
+}
+
+//------------------------------------------------------------------------------
+void menu_completer::on_matches_changed(const context& context)
+{
+    // Typing while the menu's open narrows the matches down (or widens them
+    // on a backspace). The line editor only re-selects from the matches it
+    // has when the word being completed hasn't moved, so this is cheap.
+    if (!m_open)
+        return;
+
+    m_layout.reset();
+    m_selected = 0;
+    m_top = 0;
+    update_layout(context);
+    draw(context);
+}
+
+//------------------------------------------------------------------------------
+void menu_completer::on_input(const input& input, result& result, const context& context)
+{
+    if (input.id == bind_id_open)
+    {
+        open(result, context);
+        return;
+    }
+
+    // If the line ended while the menu was open its bindings are still in use.
+    // They're put back and the key's handled as it normally would be.
+    if (!m_open)
+    {
+        if (m_prev_group != -1)
+        {
+            result.set_bind_group(m_prev_group);
+            m_prev_group = -1;
+            result.pass();
+        }
+        return;
+    }
+
+    int match_count = context.matches.get_match_count();
+    switch (input.id)
+    {
+    case bind_id_next:      select((m_selected + 1) % max(match_count, 1), context); break;
+    case bind_id_prev:      select((m_selected + match_count - 1) % max(match_count, 1), context); break;
+    case bind_id_up:        move(0, -1, context);                   break;
+    case bind_id_down:      move(0, 1, context);                    break;
+    case bind_id_left:      move(-1, 0, context);                   break;
+    case bind_id_right:     move(1, 0, context);                    break;
+    case bind_id_page_up:   move(0, -m_window_rows, context);       break;
+    case bind_id_page_down: move(0, m_window_rows, context);        break;
+    case bind_id_cancel:    close(result, context);                 break;
+    case bind_id_other:     edit(input, result, context);           break;
+
+    case bind_id_accept:
+        if (m_selected < match_count)
+            result.accept_match(m_selected);
+        close(result, context);
+        break;
+    }
+}
+
+//------------------------------------------------------------------------------
+void menu_completer::on_terminal_resize(int columns, int rows, const context& context)
+{
+    if (!m_open)
+        return;
+
+    m_layout.reset();
+    update_layout(context);
+    draw(context);
+}
+
+//------------------------------------------------------------------------------
+void menu_completer::open(result& result, const context& context)
+{
+    if (m_open || !context.matches.get_match_count())
+        return;
+
+    m_open = true;
+    m_selected = 0;
+    m_top = 0;
+    m_prev_group = result.set_bind_group(m_bind_group);
+
+    m_layout.reset();
+    update_layout(context);
+    draw(context);
+}
+
+//------------------------------------------------------------------------------
+void menu_completer::close(result& result, const context& context)
+{
+    m_open = false;
+    m_window_rows = 0;
+    draw(context);
+
+    if (m_prev_group != -1)
+    {
+        result.set_bind_group(m_prev_group);
+        m_prev_group = -1;
+    }
+}
+
+//------------------------------------------------------------------------------
+void menu_completer::edit(const input& input, result& result, const context& context)
+{
+    // Printable keys and backspace edit the line, which will change the
+    // matches. Anything else closes the menu and does what it usually would.
+    unsigned char c = input.keys[0];
+    if (c == '\b' || c == 0x7f)
+    {
+        line_buffer& buffer = context.buffer;
+        unsigned int cursor = buffer.get_cursor();
+        if (!cursor)
+            return;
+
+        const char* chars = buffer.get_buffer();
+        unsigned int from = cursor - 1;
+        while (from && (chars[from] & 0xc0) == 0x80)
+            --from;
+
+        buffer.remove(from, cursor);
+        buffer.set_cursor(from);
+        return;
+    }
+
+    if (c >= 0x20)
+    {
+        context.buffer.insert(input.keys);
+        return;
+    }
+
+    close(result, context);
+    result.pass();
+}
+
+//------------------------------------------------------------------------------
+void menu_completer::update_layout(const context& context)
+{
+    // The last column's kept off the terminal's right edge so the cursor
+    // never wraps on to the next row while the menu's drawn.
+    int columns = int(context.printer.get_columns()) - 1;
+    int cell_columns = min<int>(g_max_width.get(), columns);
+    m_layout.update(context.matches, cell_columns, g_column_pad.get(), g_vertical.get());
+
+    int match_count = context.matches.get_match_count();
+    m_selected = clamp(m_selected, 0, max(match_count - 1, 0));
+
+    int rows = m_layout.get_rows();
+    m_window_rows = min(max(g_menu_rows.get(), 1), rows);
+
+    int column, row = 0;
+    m_layout.get_position(m_selected, column, row);
+    m_top = clamp(m_top, row - m_window_rows + 1, row);
+    m_top = clamp(m_top, 0, rows - m_window_rows);
+}
+
+//------------------------------------------------------------------------------
+void menu_completer::select(int index, const context& context)
+{
+    int match_count = context.matches.get_match_count();
+    if (index == m_selected || unsigned(index) >= unsigned(match_count))
+        return;
+
+    int column, row;
+    m_layout.get_position(index, column, row);
+
+    int prev_selected = m_selected;
+    m_selected = index;
+
+    // If the selection's gone off the menu then the menu's scrolled to it.
+    if (row < m_top || row >= m_top + m_window_rows)
+    {
+        m_top = (row < m_top) ? row : (row - m_window_rows + 1);
+        draw(context);
+        return;
+    }
+
+    // Otherwise only the cells that were and now are selected are redrawn.
+    int cursor_column, rows_below;
+    get_cursor_position(context, cursor_column, rows_below);
+
+    const matches& matches = context.matches;
+    int column_width = m_layout.get_column_width();
+
+    str<48> moves[2];
+    std::vector<print_run> runs;
+    runs.reserve(8);
+
+    const int cells[] = { prev_selected, m_selected };
+    for (int i = 0; i < sizeof_array(cells); ++i)
+    {
+        if (!m_layout.get_position(cells[i], column, row))
+            continue;
+
+        int down = rows_below + row - m_top;
+
+        str_base& move = moves[i];
+        append_move(move, -down, column * column_width);
+        int to_cell = move.length();
+        append_move(move, down, cursor_column);
+
+        runs.push_back({ attributes(), move.c_str(), to_cell });
+        add_cell(runs, matches, m_layout, cells[i], cells[i] == m_selected);
+        runs.push_back({ attributes(), move.c_str() + to_cell, int(move.length()) - to_cell });
+    }
+
+    context.printer.print(runs.data(), int(runs.size()));
+}
+
+//------------------------------------------------------------------------------
+void menu_completer::move(int dx, int dy, const context& context)
+{
+    int column, row;
+    if (!m_layout.get_position(m_selected, column, row))
+        return;
+
+    column = clamp(column + dx, 0, m_layout.get_columns() - 1);
+    row = clamp(row + dy, 0, m_layout.get_rows() - 1);
+
+    // The last column can be short. Moving down or paging on to its empty
+    // cells stops at the last match instead.
+    int index = m_layout.get_index(column, row);
+    if (index < 0)
+    {
+        if (dx)
+            return;
+
+        index = context.matches.get_match_count() - 1;
+    }
+
+    select(index, context);
+}
+
+//------------------------------------------------------------------------------
+void menu_completer::draw(const context& context)
+{
+    if (!m_window_rows && !m_drawn_rows)
+        return;
+
+    int cursor_column, rows_below;
+    get_cursor_position(context, cursor_column, rows_below);
+
+    const matches& matches = context.matches;
+    int column_width = m_layout.get_column_width();
+    int pad = column_width - int(matches.get_max_cell_count());
+    attributes major_attr = g_colour_major.get();
+
+    // The whole menu is gathered up and printed in one go. New lines are used
+    // to get to each row so the terminal scrolls if the menu doesn't fit below
+    // the line being edited.
+    std::vector<print_run> runs;
+    runs.reserve(((m_layout.get_columns() * 4) + 1) * m_window_rows + 4);
+
+    str<16> down;
+    if (rows_below > 1)
+        down.format("\x1b[%dB", rows_below - 1);
+    runs.push_back({ attributes(), down.c_str(), int(down.length()) });
+
+    for (int row = m_top, end = m_top + m_window_rows; row < end; ++row)
+    {
+        runs.push_back({ attributes(), "\n\x1b[K", 4 });
+        for (int x = 0, n = m_layout.get_columns(); x < n; ++x)
+        {
+            int index = m_layout.get_index(x, row);
+            if (index < 0)
+                break;
+
+            if (x)
+                runs.push_back({ major_attr, nullptr, pad });
+
+            add_cell(runs, matches, m_layout, index, index == m_selected);
+        }
+    }
+
+    // Clear any rows left over from a bigger menu, then back to the cursor.
+    int rows_drawn = max(m_window_rows, 1);
+    if (!m_window_rows)
+        runs.push_back({ attributes(), "\n", 1 });
+    runs.push_back({ attributes(), "\x1b[J", 3 });
+
+    str<48> back;
+    append_move(back, rows_drawn + rows_below - 1, cursor_column);
+    runs.push_back({ attributes(), back.c_str(), int(back.length()) });
+
+    context.printer.print(runs.data(), int(runs.size()));
+    m_drawn_rows = m_window_rows;
+}
@@ -0,0 +1,35 @@
+// Copyright (c) 2018 Martin Ridgers
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include "editor_module.h"
+#include "match_layout.h"
+
+//------------------------------------------------------------------------------
+class menu_completer
+    : public editor_module
+{
+private:
+    virtual void    bind_input(binder& binder) override;
+    virtual void    on_begin_line(const context& context) override;
+    virtual void    on_end_line() override;
+    virtual void    on_matches_changed(const context& context) override;
+    virtual void    on_input(const input& input, result& result, const context& context) override;
+    virtual void    on_terminal_resize(int columns, int rows, const context& context) override;
+    void            open(result& result, const context& context);
+    void            close(result& result, const context& context);
+    void            edit(const input& input, result& result, const context& context);
+    void            select(int index, const context& context);
+    void            move(int dx, int dy, const context& context);
+    void            update_layout(const context& context);
+    void            draw(const context& context);
+    match_layout    m_layout;
+    int             m_selected = 0;
+    int             m_top = 0;
+    int             m_window_rows = 0;
+    int             m_drawn_rows = 0;
+    int             m_bind_group = -1;
+    int             m_prev_group = -1;
+    bool            m_open = false;
+};
@@ -73,7 +73,7 @@ void rl_buffer::draw()
 {
     if (m_need_draw)
     {
-        rl_redisplay();
+        (*rl_redisplay_function)();
         m_need_draw = false;
     }
 }
@@ -4,14 +4,18 @@
 #include "pch.h"
 #include "rl_module.h"
 #include "line_buffer.h"
+#include "rl_snapshot.h"
 
 #include <core/base.h>
 #include <core/log.h>
+#include <core/os.h>
+#include <core/str_hash.h>
 #include <terminal/ecma48_iter.h>
 #include <terminal/printer.h>
 #include <terminal/terminal_in.h>
 
 extern "C" {
+#include <readline/history.h>
 #include <readline/readline.h>
 #include <readline/rldefs.h>
 #include <readline/xmalloc.h>
@@ -21,7 +25,6 @@ extern "C" {
 static FILE*        null_stream = (FILE*)1;
 void                show_rl_help(printer&);
 extern "C" int      wcwidth(int);
-extern "C" char*    tgetstr(char*, char**);
 static const int    RL_MORE_INPUT_STATES = ~(
                         RL_STATE_CALLBACK|
                         RL_STATE_INITIALIZED|
@@ -34,17 +37,35 @@ extern void         (*rl_fflush_function)(FILE*);
 extern char*        _rl_comment_begin;
 extern int          _rl_convert_meta_chars_to_ascii;
 extern int          _rl_output_meta_chars;
-#if defined(PLATFORM_WINDOWS)
+extern int          _rl_horizontal_scroll_mode;
+extern int          _rl_mark_modified_lines;
 extern int          _rl_vis_botlin;
 extern int          _rl_last_c_pos;
 extern int          _rl_last_v_pos;
-#endif
 } // extern "C"
 
 
 
 //------------------------------------------------------------------------------
-static void load_user_inputrc()
+static void get_rl_prompt(const char* prompt, str_base& out)
+{
+    // Readline needs to be told about parts of the prompt that aren't visible
+    // by enclosing them in a pair of 0x01/0x02 chars.
+    out.clear();
+
+    ecma48_state state;
+    ecma48_iter iter(prompt, state);
+    while (const ecma48_code& code = iter.next())
+    {
+        bool c1 = (code.get_type() == ecma48_code::type_c1);
+        if (c1) out.concat("\x01", 1);
+                out.concat(code.get_pointer(), code.get_length());
+        if (c1) out.concat("\x02", 1);
+    }
+}
+
+//------------------------------------------------------------------------------
+template <typename T> static void for_each_inputrc(T&& callback)
 {
 #if defined(PLATFORM_WINDOWS)
     // Remember to update clink_info() if anything changes in here.
@@ -68,11 +89,8 @@ static void load_user_inputrc()
 
         for (int j = 0; j < 2; ++j)
         {
-            if (!rl_read_init_file(path.c_str()))
-            {
-                LOG("Found Readline inputrc at '%s'", path.c_str());
+            if (callback(path.c_str()))
                 break;
-            }
 
             int dot = path.last_of('.');
             if (dot >= 0)
@@ -82,6 +100,119 @@ static void load_user_inputrc()
 #endif // PLATFORM_WINDOWS
 }
 
+//------------------------------------------------------------------------------
+static unsigned int get_inputrc_signature(const char* shell_name)
+{
+    // Identifies the inputrc files that would be loaded and their versions,
+    // and the build and snapshot format that would read them; another build's
+    // Readline may parse the same files differently. Zero's reserved for when
+    // there's no signature.
+    unsigned int signature = str_hash(shell_name);
+#if defined(CLINK_COMMIT)
+    signature = (signature * 33) ^ str_hash(AS_STR(CLINK_COMMIT));
+#endif
+    signature = (signature * 33) ^ rl_snapshot::get_version();
+    for_each_inputrc([&] (const char* path) {
+        int size;
+        long long time;
+        bool exists = os::get_file_info(path, size, time);
+        if (exists)
+        {
+            signature = (signature * 33) ^ str_hash(path);
+            signature = (signature * 33) ^ unsigned(size);
+            signature = (signature * 33) ^ unsigned(time) ^ unsigned(time >> 32);
+        }
+        return exists;
+    });
+
+    return signature ? signature : 1;
+}
+
+//------------------------------------------------------------------------------
+static bool load_user_inputrc()
+{
+    // Returns false if any of the files include others, as those aren't part
+    // of the signature.
+    bool snapshot_safe = true;
+    for_each_inputrc([&] (const char* path) {
+        if (rl_read_init_file(path))
+            return false;
+
+        LOG("Found Readline inputrc at '%s'", path);
+
+        if (FILE* in = fopen(path, "rt"))
+        {
+            char line[512];
+            while (fgets(line, sizeof_array(line), in) != nullptr)
+                if (strstr(line, "$include") != nullptr)
+                    snapshot_safe = false;
+
+            fclose(in);
+        }
+        return true;
+    });
+
+    return snapshot_safe;
+}
+
+//------------------------------------------------------------------------------
+static unsigned int g_loaded_signature;
+
+static void load_inputrc(const char* shell_name, const char* snapshot_path)
+{
+    // Readline's bindings and variables are global so once the inputrc files
+    // are loaded they only need loading again if they change.
+    unsigned int signature = get_inputrc_signature(shell_name);
+    if (signature == g_loaded_signature)
+        return;
+
+    // Bind extended keys so editing follows Windows' conventions.
+    static const char* ext_key_binds[][2] = {
+        { "\\e[1;5D", "backward-word" },           // ctrl-left
+        { "\\e[1;5C", "forward-word" },            // ctrl-right
+        { "\\e[F",    "end-of-line" },             // end
+        { "\\e[H",    "beginning-of-line" },       // home
+        { "\\e[3~",   "delete-char" },             // del
+        { "\\e[1;5F", "kill-line" },               // ctrl-end
+        { "\\e[1;5H", "backward-kill-line" },      // ctrl-home
+        { "\\e[5~",   "history-search-backward" }, // pgup
+        { "\\e[6~",   "history-search-forward" },  // pgdn
+        { "\\C-z",    "undo" },
+    };
+
+    for (int i = 0; i < sizeof_array(ext_key_binds); ++i)
+        rl_bind_keyseq(ext_key_binds[i][0], rl_named_function(ext_key_binds[i][1]));
+
+    // A snapshot only holds what the inputrc files change so it can only be
+    // made (or used) the first time they're loaded.
+    bool first_load = (g_loaded_signature == 0);
+    g_loaded_signature = signature;
+    if (!first_load || snapshot_path == nullptr)
+    {
+        load_user_inputrc();
+        return;
+    }
+
+    if (rl_snapshot::apply(snapshot_path, signature))
+    {
+        LOG("Applied Readline snapshot '%s'", snapshot_path);
+        return;
+    }
+
+    rl_snapshot base;
+    base.capture();
+
+    if (load_user_inputrc())
+    {
+        rl_snapshot loaded;
+        loaded.capture();
+        if (loaded.save(snapshot_path, signature, base))
+            return;
+    }
+
+    remove(snapshot_path);
+}
+
 
 
 //------------------------------------------------------------------------------
@@ -116,7 +247,7 @@ static void terminal_write_thunk(FILE* stream, const char* chars, int char_count
 
 
 //------------------------------------------------------------------------------
-rl_module::rl_module(const char* shell_name)
+rl_module::rl_module(const char* shell_name, const char* snapshot_path)
 : m_rl_buffer(nullptr)
 , m_prev_group(-1)
 {
@@ -128,7 +259,8 @@ rl_module::rl_module(const char* shell_name)
 
     rl_readline_name = shell_name;
     rl_catch_signals = 0;
-    _rl_comment_begin = savestring("::"); // this will do...
+    if (_rl_comment_begin == nullptr)
+        _rl_comment_begin = savestring("::"); // this will do...
 
     // Readline needs a tweak of it's handling of 'meta' (i.e. IO bytes >=0x80)
     // so that it handles UTF-8 correctly (convert=input, output=output)
@@ -139,31 +271,70 @@ rl_module::rl_module(const char* shell_name)
     rl_completion_entry_function = [](const char*, int) -> char* { return nullptr; };
     rl_completion_display_matches_hook = [](char**, int, int) {};
 
-    // Bind extended keys so editing follows Windows' conventions.
-    static const char* ext_key_binds[][2] = {
-        { "\\e[1;5D", "backward-word" },           // ctrl-left
-        { "\\e[1;5C", "forward-word" },            // ctrl-right
-        { "\\e[F",    "end-of-line" },             // end
-        { "\\e[H",    "beginning-of-line" },       // home
-        { "\\e[3~",   "delete-char" },             // del
-        { "\\e[1;5F", "kill-line" },               // ctrl-end
-        { "\\e[1;5H", "backward-kill-line" },      // ctrl-home
-        { "\\e[5~",   "history-search-backward" }, // pgup
-        { "\\e[6~",   "history-search-forward" },  // pgdn
-        { "\\C-z",    "undo" },
-    };
+    // Clink does the drawing of the line so only what's changed is written.
+    rl_redisplay_function = [] () { rl_module::get()->redisplay(); };
 
-    for (int i = 0; i < sizeof_array(ext_key_binds); ++i)
-        rl_bind_keyseq(ext_key_binds[i][0], rl_named_function(ext_key_binds[i][1]));
+    load_inputrc(shell_name, snapshot_path);
+}
 
-    load_user_inputrc();
+//------------------------------------------------------------------------------
+void rl_module::set_prompt(const char* prompt)
+{
+    str<128> rl_prompt;
+    get_rl_prompt(prompt, rl_prompt);
+    rl_set_prompt(rl_prompt.c_str());
+
+    // A different prompt redraws everything from the top of the prompt down.
+    (*rl_redisplay_function)();
+}
+
+//------------------------------------------------------------------------------
+void rl_module::redisplay()
+{
+    // Horizontal scrolling is left to Readline.
+    if (_rl_horizontal_scroll_mode)
+    {
+        m_shadow.reset();
+        rl_redisplay();
+        return;
+    }
+
+    // Readline zeros the cursor's column when it starts a new line or wants
+    // everything redrawn (see rl_on_new_line()). Otherwise it's kept non-zero.
+    if (_rl_last_c_pos == 0)
+        m_shadow.reset();
+
+    if (rl_outstream == null_stream)
+        return;
+
+    str<128> prompt;
+    if (_rl_mark_modified_lines && current_history() && rl_undo_list)
+        prompt << "*";
+    prompt << rl_display_prompt;
+
+    printer& pter = *(printer*)rl_outstream;
+    m_shadow.draw(pter, prompt.c_str(), rl_line_buffer, rl_end, rl_point);
+
+    // Readline still moves the cursor itself when a line's accepted. Have it
+    // think the line's a single row so it doesn't try to move around it.
+    _rl_last_v_pos = 0;
+    _rl_vis_botlin = 0;
+    _rl_last_c_pos = m_shadow.get_cursor_column() + 1;
 }
 
 //------------------------------------------------------------------------------
-rl_module::~rl_module()
+bool rl_module::is_self_insert(unsigned char key) const
 {
-    free(_rl_comment_begin);
-    _rl_comment_begin = nullptr;
+    // Readline would insert 'key' as is if it isn't part way through a key
+    // sequence, search, numeric argument, etc. and the key's bound to insert.
+    if (m_done || m_prev_group >= 0)
+        return false;
+
+    if (rl_readline_state & (RL_MORE_INPUT_STATES|RL_STATE_OVERWRITE))
+        return false;
+
+    Keymap keymap = rl_get_keymap();
+    return (keymap[key].type == ISFUNC && keymap[key].function == rl_insert);
 }
 
 //------------------------------------------------------------------------------
@@ -182,19 +353,12 @@ void rl_module::on_begin_line(const context& context)
 {
     rl_outstream = (FILE*)(terminal_out*)(&context.printer);
 
-    // Readline needs to be told about parts of the prompt that aren't visible
-    // by enclosing them in a pair of 0x01/0x02 chars.
     str<128> rl_prompt;
+    get_rl_prompt(context.prompt, rl_prompt);
 
-    ecma48_state state;
-    ecma48_iter iter(context.prompt, state);
-    while (const ecma48_code& code = iter.next())
-    {
-        bool c1 = (code.get_type() == ecma48_code::type_c1);
-        if (c1) rl_prompt.concat("\x01", 1);
-                rl_prompt.concat(code.get_pointer(), code.get_length());
-        if (c1) rl_prompt.concat("\x02", 1);
-    }
+    // Installing the handler draws the prompt, so the shadow screen has to be
+    // reset before then or the next redisplay will draw the prompt again.
+    m_shadow.reset();
 
     auto handler = [] (char* line) { rl_module::get()->done(line); };
     rl_callback_handler_install(rl_prompt.c_str(), handler);
@@ -237,7 +401,7 @@ void rl_module::on_input(const input& input, result& result, const context& cont
     {
         virtual void begin() override   {}
         virtual void end() override     {}
-        virtual void select() override  {}
+        virtual void select(int) override {}
         virtual int  read() override    { return *(unsigned char*)(data++); }
         const char*  data;
     } term_in;
@@ -285,6 +449,16 @@ void rl_module::done(const char* line)
     m_done = true;
     m_eof = (line == nullptr);
 
+    // Readline's moved down a row from the cursor. Move below the rest of the
+    // line so what follows doesn't overwrite it.
+    if (rl_outstream != null_stream && !_rl_horizontal_scroll_mode)
+    {
+        printer& pter = *(printer*)rl_outstream;
+        int rows = m_shadow.get_row_count() - m_shadow.get_cursor_row() - 1;
+        for (int i = 0; i < rows; ++i)
+            pter.print("\n", 1);
+    }
+
     // Readline will reset the line state on returning from this call. Here we
     // trick it into reseting something else so we can use rl_line_buffer later.
     static char dummy_buffer = 0;
@@ -299,7 +473,7 @@ void rl_module::on_terminal_resize(int columns, int rows, const context& context
 {
 #if 1
     rl_reset_screen_size();
-    rl_redisplay();
+    (*rl_redisplay_function)();
 #else
     static int prev_columns = columns;
 
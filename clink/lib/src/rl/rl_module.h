@@ -6,6 +6,7 @@
 #include "editor_module.h"
 
 #include <core/singleton.h>
+#include <terminal/shadow_screen.h>
 
 //------------------------------------------------------------------------------
 class rl_module
@@ -13,8 +14,9 @@ class rl_module
     , public singleton<rl_module>
 {
 public:
-                    rl_module(const char* shell_name);
-                    ~rl_module();
+                    rl_module(const char* shell_name, const char* snapshot_path);
+    void            set_prompt(const char* prompt);
+    bool            is_self_insert(unsigned char key) const;
 
 private:
     virtual void    bind_input(binder& binder) override;
@@ -23,7 +25,9 @@ private:
     virtual void    on_matches_changed(const context& context) override;
     virtual void    on_input(const input& input, result& result, const context& context) override;
     virtual void    on_terminal_resize(int columns, int rows, const context& context) override;
+    void            redisplay();
     void            done(const char* line);
+    shadow_screen   m_shadow;
     char*           m_rl_buffer;
     int             m_prev_group;
     int             m_catch_group;
@@ -0,0 +1,453 @@
+// Copyright (c) 2016 Martin Ridgers
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "rl_snapshot.h"
+
+#include <core/base.h>
+#include <core/log.h>
+#include <core/str.h>
+
+#include <algorithm>
+
+extern "C" {
+#include <readline/readline.h>
+#include <readline/rldefs.h>
+#include <readline/xmalloc.h>
+}
+
+//------------------------------------------------------------------------------
+static const unsigned int   g_snapshot_magic = 0x70616e73; // 'snap'
+static const unsigned int   g_snapshot_version = 1;
+static const int            g_max_depth = 16;
+
+// Readline's variables (bind.c's boolean_varlist and string_varlist).
+static const char* const    g_variable_names[] = {
+    "bind-tty-special-chars",
+    "blink-matching-paren",
+    "byte-oriented",
+    "completion-ignore-case",
+    "completion-map-case",
+    "convert-meta",
+    "disable-completion",
+    "echo-control-characters",
+    "enable-keypad",
+    "enable-meta-key",
+    "expand-tilde",
+    "history-preserve-point",
+    "horizontal-scroll-mode",
+    "input-meta",
+    "mark-directories",
+    "mark-modified-lines",
+    "mark-symlinked-directories",
+    "match-hidden-files",
+    "menu-complete-display-prefix",
+    "meta-flag",
+    "output-meta",
+    "page-completions",
+    "prefer-visible-bell",
+    "print-completions-horizontally",
+    "revert-all-at-newline",
+    "show-all-if-ambiguous",
+    "show-all-if-unmodified",
+    "skip-completed-text",
+    "visible-stats",
+    "bell-style",
+    "comment-begin",
+    "completion-display-width",
+    "completion-prefix-display-length",
+    "completion-query-items",
+    "editing-mode",
+    "history-size",
+    "isearch-terminators",
+    "keymap",
+};
+
+//------------------------------------------------------------------------------
+struct snapshot_header
+{
+    unsigned int    magic;
+    unsigned int    version;
+    unsigned int    signature;
+    unsigned int    size;           // of the records that follow
+};
+
+//------------------------------------------------------------------------------
+// Each record is; kind, root keymap, key count, value length (two bytes), the
+// keys then the value. Variables use the "keys" for their name.
+enum
+{
+    record_variable,
+    record_unbind,
+    record_function,
+    record_macro,
+    record_other    = 0x80,         // binding's in the keys' ANYOTHERKEY slot
+    record_size     = 5,
+};
+
+//------------------------------------------------------------------------------
+static Keymap get_root(int index)
+{
+    switch (index)
+    {
+    case 0:     return emacs_standard_keymap;
+    case 1:     return vi_movement_keymap;
+    case 2:     return vi_insertion_keymap;
+    default:    return nullptr;
+    }
+}
+
+//------------------------------------------------------------------------------
+static const char* get_function_name(void* function)
+{
+    rl_initialize_funmap();
+    for (int i = 0; funmap[i] != nullptr; ++i)
+        if ((void*)(funmap[i]->function) == function)
+            return funmap[i]->name;
+
+    return nullptr;
+}
+
+//------------------------------------------------------------------------------
+static void add_record(
+    std::vector<char>& out,
+    int kind,
+    int root,
+    const void* keys,
+    int key_count,
+    const char* value,
+    int value_length)
+{
+    char header[record_size] = {
+        char(kind), char(root), char(key_count),
+        char(value_length & 0xff), char(value_length >> 8)
+    };
+
+    out.insert(out.end(), header, header + record_size);
+    out.insert(out.end(), (const char*)keys, (const char*)keys + key_count);
+    out.insert(out.end(), value, value + value_length);
+}
+
+//------------------------------------------------------------------------------
+static int compare_keys(const unsigned char* lhs, const unsigned char* rhs)
+{
+    // Keys are root, other, count, then 'count' bytes.
+    int length = 3 + min(lhs[2], rhs[2]);
+    if (int ret = memcmp(lhs, rhs, length))
+        return ret;
+
+    return int(lhs[2]) - int(rhs[2]);
+}
+
+
+
+//------------------------------------------------------------------------------
+unsigned int rl_snapshot::get_version()
+{
+    return g_snapshot_version;
+}
+
+//------------------------------------------------------------------------------
+void rl_snapshot::capture()
+{
+    m_bindings.clear();
+    m_variables.clear();
+    m_strings.clear();
+
+    char keys[g_max_depth];
+    for (int i = 0; Keymap root = get_root(i); ++i)
+        capture(root, i, keys, 0);
+
+    auto lambda = [this] (const binding& lhs, const binding& rhs) {
+        return compare_keys(get_key(lhs), get_key(rhs)) < 0;
+    };
+    std::sort(m_bindings.begin(), m_bindings.end(), lambda);
+
+    for (const char* name : g_variable_names)
+    {
+        const char* value = rl_variable_value(name);
+        if (value == nullptr)
+            value = "";
+
+        m_variables.push_back(int(m_strings.size()));
+        m_strings.insert(m_strings.end(), value, value + strlen(value) + 1);
+    }
+}
+
+//------------------------------------------------------------------------------
+void rl_snapshot::capture(Keymap map, int root, char* keys, int depth)
+{
+    for (int i = 0; i < KEYMAP_SIZE; ++i)
+    {
+        const KEYMAP_ENTRY& entry = map[i];
+        if (entry.type == ISKMAP)
+        {
+            if (i != ANYOTHERKEY && depth < g_max_depth)
+            {
+                keys[depth] = char(i);
+                capture(FUNCTION_TO_KEYMAP(map, i), root, keys, depth + 1);
+            }
+            continue;
+        }
+
+        if (entry.function == nullptr)
+            continue;
+
+        // What a sequence's prefix did before it became a keymap is kept in
+        // the keymap's ANYOTHERKEY slot.
+        if (i == ANYOTHERKEY)
+        {
+            if (depth)
+                add_binding(root, true, keys, depth, entry.type, (void*)entry.function);
+            continue;
+        }
+
+        keys[depth] = char(i);
+        add_binding(root, false, keys, depth + 1, entry.type, (void*)entry.function);
+    }
+}
+
+//------------------------------------------------------------------------------
+void rl_snapshot::add_binding(
+    int root,
+    bool other,
+    const char* keys,
+    int key_count,
+    int type,
+    void* function)
+{
+    binding b = { int(m_strings.size()), -1, function, type };
+
+    char key_header[] = { char(root), char(other), char(key_count) };
+    m_strings.insert(m_strings.end(), key_header, key_header + sizeof_array(key_header));
+    m_strings.insert(m_strings.end(), keys, keys + key_count);
+
+    // Macros can be freed when they're rebound so their text's copied.
+    if (type == ISMACR)
+    {
+        const char* macro = (const char*)function;
+        b.macro = int(m_strings.size());
+        m_strings.insert(m_strings.end(), macro, macro + strlen(macro) + 1);
+    }
+
+    m_bindings.push_back(b);
+}
+
+//------------------------------------------------------------------------------
+const unsigned char* rl_snapshot::get_key(const binding& b) const
+{
+    return (const unsigned char*)&m_strings[b.key];
+}
+
+//------------------------------------------------------------------------------
+const rl_snapshot::binding* rl_snapshot::find(const unsigned char* key) const
+{
+    int lo = 0;
+    int hi = int(m_bindings.size());
+    while (lo < hi)
+    {
+        int mid = (lo + hi) >> 1;
+        int cmp = compare_keys(get_key(m_bindings[mid]), key);
+        if (cmp == 0)
+            return &m_bindings[mid];
+
+        if (cmp < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return nullptr;
+}
+
+//------------------------------------------------------------------------------
+bool rl_snapshot::save(const char* path, unsigned int signature, const rl_snapshot& base) const
+{
+    std::vector<char> records;
+
+    // Bindings that have gone are removed first, so that sequences that now
+    // have a keymap where they used to have a function don't inherit it.
+    for (const binding& b : base.m_bindings)
+    {
+        const unsigned char* key = base.get_key(b);
+        if (find(key) == nullptr)
+        {
+            int kind = record_unbind | (key[1] ? record_other : 0);
+            add_record(records, kind, key[0], key + 3, key[2], nullptr, 0);
+        }
+    }
+
+    // Then the bindings that are new or have changed. Those in ANYOTHERKEY
+    // slots go last as they need the keymaps the other bindings make.
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        for (const binding& b : m_bindings)
+        {
+            const unsigned char* key = get_key(b);
+            if (key[1] != pass)
+                continue;
+
+            const binding* prev = base.find(key);
+            bool changed = (prev == nullptr || prev->type != b.type);
+            if (!changed && b.type == ISMACR)
+                changed = (strcmp(&m_strings[b.macro], &base.m_strings[prev->macro]) != 0);
+            else if (!changed)
+                changed = (prev->function != b.function);
+
+            if (!changed)
+                continue;
+
+            int kind = (b.type == ISMACR) ? record_macro : record_function;
+            kind |= pass ? record_other : 0;
+
+            const char* value;
+            if (b.type == ISMACR)
+                value = &m_strings[b.macro];
+            else if ((value = get_function_name(b.function)) == nullptr)
+            {
+                // Can't be written by name so a snapshot isn't possible.
+                LOG("Unable to snapshot Readline binding; unnamed function");
+                return false;
+            }
+
+            int value_length = int(strlen(value));
+            if (value_length > 0xffff)
+                return false;
+
+            add_record(records, kind, key[0], key + 3, key[2], value, value_length);
+        }
+    }
+
+    // Variables are set after the bindings. Some (e.g. convert-meta) change how
+    // key sequences are bound.
+    for (int i = 0, n = sizeof_array(g_variable_names); i < n; ++i)
+    {
+        const char* value = &m_strings[m_variables[i]];
+        if (strcmp(value, &base.m_strings[base.m_variables[i]]) == 0)
+            continue;
+
+        const char* name = g_variable_names[i];
+        add_record(records, record_variable, 0, name, int(strlen(name)), value,
+            int(strlen(value)));
+    }
+
+    FILE* out = fopen(path, "wb");
+    if (out == nullptr)
+        return false;
+
+    snapshot_header header = {
+        g_snapshot_magic,
+        g_snapshot_version,
+        signature,
+        unsigned(records.size()),
+    };
+
+    fwrite(&header, sizeof(header), 1, out);
+    if (!records.empty())
+        fwrite(records.data(), records.size(), 1, out);
+
+    fclose(out);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+bool rl_snapshot::apply(const char* path, unsigned int signature)
+{
+    FILE* in = fopen(path, "rb");
+    if (in == nullptr)
+        return false;
+
+    snapshot_header header;
+    bool ok = (fread(&header, sizeof(header), 1, in) == 1);
+    ok = ok && (header.magic == g_snapshot_magic);
+    ok = ok && (header.version == g_snapshot_version);
+    ok = ok && (header.signature == signature);
+
+    std::vector<char> records(ok ? header.size : 0);
+    if (ok && header.size)
+        ok = (fread(records.data(), header.size, 1, in) == 1);
+
+    fclose(in);
+    if (!ok)
+        return false;
+
+    // Check everything's valid before changing any of Readline's state.
+    const char* end = records.data() + records.size();
+    for (const char* iter = records.data(); iter < end;)
+    {
+        const unsigned char* record = (const unsigned char*)iter;
+        int key_count = record[2];
+        int value_length = record[3] | (record[4] << 8);
+        iter += record_size + key_count + value_length;
+        if (iter > end || get_root(record[1]) == nullptr || key_count == 0)
+            return false;
+
+        if ((record[0] & ~record_other) != record_function)
+            continue;
+
+        str<64> name;
+        name.concat(iter - value_length, value_length);
+        if (rl_named_function(name.c_str()) == nullptr)
+            return false;
+    }
+
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        for (const char* iter = records.data(); iter < end;)
+        {
+            const unsigned char* record = (const unsigned char*)iter;
+            int kind = record[0];
+            int key_count = record[2];
+            int value_length = record[3] | (record[4] << 8);
+            const char* keys = iter + record_size;
+            const char* value = keys + key_count;
+            iter = value + value_length;
+
+            // Bindings then variables (see save()).
+            if ((kind == record_variable) != (pass == 1))
+                continue;
+
+            str<64> value_str;
+            value_str.concat(value, value_length);
+
+            if (kind == record_variable)
+            {
+                str<64> name;
+                name.concat(keys, key_count);
+                rl_variable_bind(name.c_str(), value_str.c_str());
+                continue;
+            }
+
+            // Keys are written as hex escapes so rl_generic_bind() passes any
+            // byte through unchanged.
+            str<64> seq;
+            for (int i = 0; i < key_count; ++i)
+            {
+                str<16> hex;
+                hex.format("\\x%02x", (unsigned char)keys[i]);
+                seq << hex;
+            }
+
+            Keymap map = get_root(record[1]);
+            switch (kind & ~record_other)
+            {
+            case record_unbind:
+                rl_generic_bind(ISFUNC, seq.c_str(), nullptr, map);
+                break;
+
+            case record_function:
+                {
+                    rl_command_func_t* func = rl_named_function(value_str.c_str());
+                    rl_generic_bind(ISFUNC, seq.c_str(), (char*)func, map);
+                }
+                break;
+
+            case record_macro:
+                rl_generic_bind(ISMACR, seq.c_str(), savestring(value_str.c_str()), map);
+                break;
+            }
+        }
+    }
+
+    return true;
+}
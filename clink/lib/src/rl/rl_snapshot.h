@@ -0,0 +1,40 @@
+// Copyright (c) 2016 Martin Ridgers
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <vector>
+
+struct _keymap_entry;
+
+//------------------------------------------------------------------------------
+// A copy of Readline's key bindings and variables. Capturing before and after
+// the user's inputrc files are loaded lets the difference be saved to a file,
+// which later processes apply instead of finding and parsing the inputrc files
+// again. Saved snapshots carry a signature so they're only applied while the
+// inputrc files they came from are unchanged.
+class rl_snapshot
+{
+public:
+    void                capture();
+    bool                save(const char* path, unsigned int signature, const rl_snapshot& base) const;
+    static bool         apply(const char* path, unsigned int signature);
+    static unsigned int get_version();
+
+private:
+    struct binding
+    {
+        int             key;        // offset in m_strings of root/other/length/keys
+        int             macro;      // offset in m_strings or -1
+        void*           function;
+        int             type;
+    };
+
+    void                capture(_keymap_entry* map, int root, char* keys, int depth);
+    void                add_binding(int root, bool other, const char* keys, int key_count, int type, void* function);
+    const unsigned char* get_key(const binding& b) const;
+    const binding*      find(const unsigned char* key) const;
+    std::vector<binding> m_bindings;
+    std::vector<int>    m_variables;    // offsets in m_strings of each value
+    std::vector<char>   m_strings;
+};
@@ -15,6 +15,8 @@
 #include <terminal/printer.h>
 #include <terminal/setting_colour.h>
 
+#include <vector>
+
 //------------------------------------------------------------------------------
 editor_module* tab_completer_create()
 {
@@ -37,13 +39,13 @@ static setting_int g_query_threshold(
     "displaying them all.",
     100);
 
-static setting_bool g_vertical(
+setting_bool g_vertical(
     "match.vertical",
     "Display matches vertically",
     "Toggles the display of ordered matches between columns or rows.",
     true);
 
-static setting_int g_column_pad(
+setting_int g_column_pad(
     "match.column_pad",
     "Space between columns",
     "Adjusts the amount of whitespace padding between columns of matches.",
@@ -85,6 +87,62 @@ setting_colour g_colour_highlight(
 
 
 
+//------------------------------------------------------------------------------
+// Prints one row of the match layout. Rows are gathered into a list of runs so
+// they're printed with one write, and cleared first as they may be going over
+// a previous page.
+static void print_row(
+    printer& printer,
+    const matches& matches,
+    const match_layout& layout,
+    int row,
+    std::vector<print_run>& runs)
+{
+    attributes minor_attr = g_colour_minor.get();
+    attributes major_attr = g_colour_major.get();
+    attributes highlight_attr = g_colour_highlight.get();
+
+    int lcd_length = layout.get_lcd_length();
+    int column_width = layout.get_column_width();
+
+    runs.clear();
+    runs.push_back({ attributes(), "\x1b[K", 3 });
+
+    int prev_index = -1;
+    for (int x = 0, n = layout.get_columns(); x < n; ++x)
+    {
+        int index = layout.get_index(x, row);
+        if (index < 0)
+            break;
+
+        // Pad out from the previous column.
+        if (prev_index >= 0)
+        {
+            int visible_chars = matches.get_cell_count(prev_index);
+            runs.push_back({ attributes(), nullptr, column_width - visible_chars });
+        }
+
+        // Add the match.
+        const char* match = matches.get_displayable(index);
+        const char* post_lcd = match + lcd_length;
+
+        str_iter iter(post_lcd);
+        iter.next();
+        const char* match_tail = iter.get_pointer();
+
+        runs.push_back({ minor_attr, match, lcd_length });
+        runs.push_back({ highlight_attr, post_lcd, int(match_tail - post_lcd) });
+        runs.push_back({ major_attr, match_tail, int(strlen(match_tail)) });
+
+        prev_index = index;
+    }
+
+    runs.push_back({ attributes(), "\n", 1 });
+    printer.print(runs.data(), int(runs.size()));
+}
+
+
+
 //------------------------------------------------------------------------------
 enum {
     bind_id_prompt      = 20,
@@ -140,6 +198,7 @@ void tab_completer::on_end_line()
 void tab_completer::on_matches_changed(const context& context)
 {
     m_waiting = false;
+    m_layout.reset();
 }
 
 //------------------------------------------------------------------------------
@@ -210,14 +269,10 @@ tab_completer::state tab_completer::begin_print(const context& context)
     const matches& matches = context.matches;
     int match_count = matches.get_match_count();
 
-    m_longest = 0;
     m_row = 0;
+    m_window_rows = 0;
 
-    // Get the longest match length.
-    for (int i = 0, n = matches.get_match_count(); i < n; ++i)
-        m_longest = max<int>(matches.get_cell_count(i), m_longest);
-
-    if (!m_longest)
+    if (!matches.get_max_cell_count())
         return state_none;
 
     context.printer.print("\n");
@@ -240,71 +295,54 @@ tab_completer::state tab_completer::print(const context& context, bool single_ro
 {
     auto& printer = context.printer;
 
-    const matches& matches = context.matches;
-
-    attributes minor_attr = g_colour_minor.get();
-    attributes major_attr = g_colour_major.get();
-    attributes highlight_attr = g_colour_highlight.get();
-
-    printer.print("\r");
-
-    int match_count = matches.get_match_count();
-
-    str<288> lcd;
-    matches.get_match_lcd(lcd);
-    int lcd_length = lcd.length();
-
-    // Calculate the number of columns of matches per row.
     int column_pad = g_column_pad.get();
     int cell_columns = min<int>(g_max_width.get(), printer.get_columns());
-    int columns = max(1, (cell_columns + column_pad) / (m_longest + column_pad));
-    int total_rows = (match_count + columns - 1) / columns;
+    if (m_layout.update(context.matches, cell_columns, column_pad, g_vertical.get()))
+    {
+        // A new layout (the terminal was resized say) means what's on screen
+        // can't be scrolled any more so carry on from below it instead.
+        m_row = min(m_row, m_layout.get_rows());
+        m_window_rows = 0;
+    }
+
+    int total_rows = m_layout.get_rows();
+    int page_rows = max(1, int(printer.get_rows()) - 2);
 
-    bool vertical = g_vertical.get();
-    int index_step = vertical ? total_rows : 1;
+    printer.print("\r");
 
-    int max_rows = single_row ? 1 : (total_rows - m_row - 1);
-    max_rows = min<int>(printer.get_rows() - 2 - (m_row != 0), max_rows);
-    for (; max_rows >= 0; --max_rows, ++m_row)
+    // The first page is printed as it always has been. Subsequent pages move
+    // the window down through the matches by repainting it where it is rather
+    // than pushing everything up into the terminal's scrollback.
+    int top;
+    if (m_window_rows)
     {
-        int index = vertical ? m_row : (m_row * columns);
-        for (int x = columns - 1; x >= 0; --x)
-        {
-            if (index >= match_count)
-                continue;
-
-            // Print the match.
-            const char* match = matches.get_displayable(index);
-            const char* post_lcd = match + lcd_length;
-
-            str_iter iter(post_lcd);
-            iter.next();
-            const char* match_tail = iter.get_pointer();
-
-            printer.print(minor_attr, match, lcd_length);
-            printer.print(highlight_attr, post_lcd, int(match_tail - post_lcd));
-            printer.print(major_attr, match_tail, int(strlen(match_tail)));
-
-            // Move the cursor to the next column
-            if (x)
-            {
-                int visible_chars = matches.get_cell_count(index);
-                for (int i = m_longest - visible_chars + column_pad; i >= 0;)
-                {
-                    const char spaces[] = "                ";
-                    printer.print(spaces, min<int>(sizeof_array(spaces) - 1, i));
-                    i -= sizeof_array(spaces) - 1;
-                }
-            }
-
-            index += index_step;
-        }
+        str<16> up;
+        up.format("\x1b[%dA", m_window_rows);
+        printer.print(up.c_str(), up.length());
 
-        printer.print("\n");
+        m_row = min(m_row + (single_row ? 1 : m_window_rows), total_rows);
+        top = m_row - m_window_rows;
     }
+    else
+    {
+        top = m_row;
+        m_window_rows = min(page_rows, total_rows - m_row);
+        m_row += m_window_rows;
+    }
+
+    std::vector<print_run> runs;
+    runs.reserve((m_layout.get_columns() * 4) + 2);
+    for (int row = top; row < m_row; ++row)
+        print_row(printer, context.matches, m_layout, row, runs);
 
     if (m_row == total_rows)
+    {
+        // Scrolling left the pager's prompt below the matches.
+        if (top > 0)
+            printer.print("\x1b[K", 3);
+
         return state_none;
+    }
 
     printer.print(g_colour_interact.get(), "-- More --");
     return state_pager;
@@ -313,4 +351,5 @@ tab_completer::state tab_completer::print(const context& context, bool single_ro
 //------------------------------------------------------------------------------
 void tab_completer::on_terminal_resize(int columns, int rows, const context& context)
 {
+    m_layout.reset();
 }
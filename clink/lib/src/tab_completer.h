@@ -4,6 +4,10 @@
 #pragma once
 
 #include "editor_module.h"
+#include "match_layout.h"
+
+#include <core/settings.h>
+#include <terminal/setting_colour.h>
 
 //------------------------------------------------------------------------------
 class tab_completer
@@ -28,10 +32,21 @@ private:
     virtual void    on_terminal_resize(int columns, int rows, const context& context) override;
     state           begin_print(const context& context);
     state           print(const context& context, bool single_row);
-    int             m_longest = 0;
+    match_layout    m_layout;
     int             m_row = 0;
+    int             m_window_rows = 0;
     int             m_prompt_bind_group = -1;
     int             m_pager_bind_group = -1;
     int             m_prev_group = -1;
     bool            m_waiting = false;
 };
+
+//------------------------------------------------------------------------------
+// How matches are displayed. Other modules that list matches (such as the
+// completion menu) follow these too.
+extern setting_bool     g_vertical;
+extern setting_int      g_column_pad;
+extern setting_int      g_max_width;
+extern setting_colour   g_colour_minor;
+extern setting_colour   g_colour_major;
+extern setting_colour   g_colour_highlight;
@@ -0,0 +1,256 @@
+// Copyright (c) 2018 Martin Ridgers
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "line_editor_tester.h"
+
+#include <core/settings.h>
+#include <core/str.h>
+#include <lib/editor_module.h>
+#include <lib/match_generator.h>
+#include <lib/matches.h>
+
+//------------------------------------------------------------------------------
+#define MENU    "\x1b[Z"
+#define UP      "\x1b[A"
+#define DOWN    "\x1b[B"
+#define RIGHT   "\x1b[C"
+#define LEFT    "\x1b[D"
+
+//------------------------------------------------------------------------------
+class menu_generator
+    : public match_generator
+{
+public:
+    virtual bool generate(const line_state& line, match_builder& builder) override
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            str<16> match;
+            match.format(format, i);
+            builder.add_match(match.c_str());
+        }
+        return true;
+    }
+
+    virtual int get_prefix_length(const line_state& line) const override
+    {
+        return 0;
+    }
+
+    const char*     format = "%02d_match";
+    int             count = 30;
+};
+
+//------------------------------------------------------------------------------
+// The selected match is drawn with 'colour.highlight' which is on red.
+static bool is_selected(mem_screen_buffer& screen, int column, int row)
+{
+    attributes attr = screen.get_cell_attributes(column, row);
+    auto bg = attr.get_bg();
+    return bg && !bg.is_default && bg->as_16() == colour_red;
+}
+
+
+
+//------------------------------------------------------------------------------
+TEST_CASE("Menu completion")
+{
+    // Narrow enough for three columns of "00_match". The previous width's put
+    // back afterwards, even if a section fails.
+    struct max_width_scope
+    {
+        max_width_scope(const char* value)
+        : m_setting(settings::find("match.max_width"))
+        {
+            m_setting->get(m_prev);
+            m_setting->set(value);
+        }
+
+        ~max_width_scope()
+        {
+            m_setting->set(m_prev.c_str());
+        }
+
+        setting*    m_setting;
+        str<16>     m_prev;
+    } max_width("30");
+
+    line_editor_tester tester;
+    mem_screen_buffer& screen = tester.get_screen();
+
+    editor_module* menu = menu_completer_create();
+    menu_generator generator;
+    tester.get_editor()->add_module(*menu);
+    tester.get_editor()->add_generator(generator);
+
+    SECTION("Grid")
+    {
+        tester.set_input(MENU);
+        tester.set_expected_screen(
+            "clink $",
+            "00_match  10_match  20_match",
+            "01_match  11_match  21_match",
+            "02_match  12_match  22_match",
+            "03_match  13_match  23_match",
+            "04_match  14_match  24_match",
+            "05_match  15_match  25_match",
+            "06_match  16_match  26_match",
+            "07_match  17_match  27_match",
+            "08_match  18_match  28_match",
+            "09_match  19_match  29_match");
+        tester.run();
+        REQUIRE(is_selected(screen, 0, 1));
+        REQUIRE(!is_selected(screen, 10, 1));
+    }
+
+    SECTION("Navigate")
+    {
+        tester.set_input(MENU DOWN DOWN RIGHT UP);
+        tester.set_expected_screen(
+            "clink $",
+            "00_match  10_match  20_match",
+            "01_match  11_match  21_match",
+            "02_match  12_match  22_match",
+            "03_match  13_match  23_match",
+            "04_match  14_match  24_match",
+            "05_match  15_match  25_match",
+            "06_match  16_match  26_match",
+            "07_match  17_match  27_match",
+            "08_match  18_match  28_match",
+            "09_match  19_match  29_match");
+        tester.run();
+        REQUIRE(is_selected(screen, 10, 2));
+        REQUIRE(!is_selected(screen, 0, 1));
+        REQUIRE(!is_selected(screen, 0, 3));
+        REQUIRE(screen.get_cursor_column() == 8);
+    }
+
+    SECTION("Scroll")
+    {
+        // Ten rows are shown at once. Tab moves through the matches in order
+        // so the 11th match scrolls the rows up by one.
+        generator.count = 40;
+        tester.set_input(MENU "\t\t\t\t\t\t\t\t\t\t");
+        tester.set_expected_screen(
+            "clink $",
+            "01_match  15_match  29_match",
+            "02_match  16_match  30_match",
+            "03_match  17_match  31_match",
+            "04_match  18_match  32_match",
+            "05_match  19_match  33_match",
+            "06_match  20_match  34_match",
+            "07_match  21_match  35_match",
+            "08_match  22_match  36_match",
+            "09_match  23_match  37_match",
+            "10_match  24_match  38_match");
+        tester.run();
+        REQUIRE(is_selected(screen, 0, 10));
+    }
+
+    SECTION("Filter")
+    {
+        tester.set_input(MENU "2" DOWN);
+        tester.set_expected_screen(
+            "clink $ 2",
+            "20_match  24_match  28_match",
+            "21_match  25_match  29_match",
+            "22_match  26_match",
+            "23_match  27_match");
+        tester.run();
+        REQUIRE(is_selected(screen, 0, 2));
+    }
+
+    SECTION("Filter backspace")
+    {
+        tester.set_input(MENU "1\b" "2");
+        tester.set_expected_matches("20_match", "21_match", "22_match", "23_match",
+            "24_match", "25_match", "26_match", "27_match", "28_match", "29_match");
+        tester.run();
+    }
+
+    SECTION("Accept")
+    {
+        tester.set_input(MENU DOWN RIGHT "\r");
+        tester.set_expected_output("11_match ");
+        tester.run();
+    }
+
+    SECTION("Accept filtered")
+    {
+        tester.set_input(MENU "2" DOWN DOWN DOWN RIGHT "\r" "x");
+        tester.set_expected_output("27_match x");
+        tester.run();
+    }
+
+    SECTION("Cancel")
+    {
+        tester.set_input(MENU DOWN "\x03" "abc");
+        tester.set_expected_screen("clink $ abc");
+        tester.run();
+    }
+
+    SECTION("Other keys")
+    {
+        // Keys the menu doesn't use close it and then work as they normally do.
+        tester.set_input("0" MENU "\x02" "x");
+        tester.set_expected_screen("clink $ x0");
+        tester.run();
+    }
+
+    SECTION("Many matches")
+    {
+        // Down through a few hundred rows, which scrolls the menu every ten,
+        // and back up part of the way.
+        generator.format = "%04d";
+        generator.count = 10000;
+
+        str<> input;
+        input << MENU;
+        for (int i = 0; i < 400; ++i)
+            input << DOWN;
+        for (int i = 0; i < 150; ++i)
+            input << UP;
+        input << "\r";
+
+        tester.set_input(input.c_str());
+        tester.set_expected_output("0250 ");
+        tester.run();
+    }
+
+    SECTION("Screen calls")
+    {
+        auto count_calls = [&] (const char* input) {
+            screen.clear(screen_buffer::clear_type_all);
+            screen.set_cursor(0, 0);
+
+            unsigned int start = screen.get_call_count();
+            tester.set_input(input);
+            tester.set_expected_output("");
+            tester.run();
+            return screen.get_call_count() - start;
+        };
+
+        // Ten DOWNs from the top; the first nine stay within the menu's ten
+        // rows and the last scrolls it.
+        generator.count = 40;
+
+        str<> input;
+        input << MENU;
+        unsigned int opened = count_calls(input.c_str());
+        for (int i = 0; i < 9; ++i)
+            input << DOWN;
+        unsigned int moved = count_calls(input.c_str());
+        input << DOWN;
+        unsigned int scrolled = count_calls(input.c_str());
+
+        // Moving within the menu only redraws the two cells whose selection
+        // changed, while scrolling redraws all of the menu's rows.
+        unsigned int per_move = (moved - opened) / 9;
+        REQUIRE(moved - opened == per_move * 9);
+        REQUIRE(per_move == 11);
+        REQUIRE(scrolled - moved == 55);
+    }
+
+    menu_completer_destroy(menu);
+}
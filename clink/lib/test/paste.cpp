@@ -0,0 +1,107 @@
+// Copyright (c) 2018 Martin Ridgers
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "line_editor_tester.h"
+
+#include <core/str.h>
+#include <lib/editor_module.h>
+#include <lib/match_generator.h>
+#include <lib/matches.h>
+
+//------------------------------------------------------------------------------
+class counting_generator
+    : public match_generator
+{
+public:
+    virtual bool generate(const line_state& line, match_builder& builder) override
+    {
+        ++generates;
+        return false;
+    }
+
+    virtual int get_prefix_length(const line_state& line) const override
+    {
+        return 0;
+    }
+
+    int             generates = 0;
+};
+
+//------------------------------------------------------------------------------
+class many_generator
+    : public match_generator
+{
+public:
+    virtual bool generate(const line_state& line, match_builder& builder) override
+    {
+        for (int i = 0; i < 200; ++i)
+        {
+            str<16> match;
+            match.format("%03d", i);
+            builder.add_match(match.c_str());
+        }
+        return true;
+    }
+
+    virtual int get_prefix_length(const line_state& line) const override
+    {
+        return 0;
+    }
+};
+
+
+
+//------------------------------------------------------------------------------
+TEST_CASE("Paste")
+{
+    line_editor_tester tester;
+    counting_generator generator;
+    tester.get_editor()->add_generator(generator);
+
+    SECTION("Inserted at once")
+    {
+        tester.set_input("echo hello world");
+        tester.set_expected_output("echo hello world");
+        tester.run();
+
+        // Once as the line begins and once after the paste.
+        REQUIRE(generator.generates == 2);
+    }
+
+    SECTION("Bound keys")
+    {
+        tester.set_input("echo ab" DO_COMPLETE "cd");
+        tester.set_expected_output("echo abcd");
+        tester.run();
+    }
+
+    SECTION("Long")
+    {
+        str<> input;
+        for (int i = 0; i < 5000; ++i)
+            input.concat("echo %path%"  + (i % 11), 1);
+
+        tester.set_input(input.c_str());
+        tester.set_expected_matches();
+        tester.run();
+
+        REQUIRE(generator.generates == 2);
+    }
+
+    SECTION("Query prompt")
+    {
+        editor_module* completer = tab_completer_create();
+        many_generator many;
+        tester.get_editor()->add_module(*completer);
+        tester.get_editor()->add_generator(many);
+
+        // Keys the "Show 200 matches?" query doesn't bind are ignored rather
+        // than inserted into the line as a paste.
+        tester.set_input("\t\tabn");
+        tester.set_expected_output("");
+        tester.run();
+
+        tab_completer_destroy(completer);
+    }
+}
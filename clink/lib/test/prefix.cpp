@@ -0,0 +1,79 @@
+// Copyright (c) 2018 Martin Ridgers
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "line_editor_tester.h"
+
+#include <core/str_iter.h>
+#include <lib/line_state.h>
+#include <lib/match_generator.h>
+
+//------------------------------------------------------------------------------
+class prefix_generator
+    : public match_generator
+{
+public:
+    virtual bool generate(const line_state& line, match_builder& builder) override
+    {
+        return false;
+    }
+
+    virtual int get_prefix_length(const line_state& line) const override
+    {
+        ++queries;
+
+        str_iter end_word = line.get_end_word();
+        const char* word = end_word.get_pointer();
+        int prefix = 0;
+        for (int i = 0, n = end_word.length(); i < n; ++i)
+            if (word[i] == '\\')
+                prefix = i + 1;
+
+        return prefix;
+    }
+
+    mutable int     queries = 0;
+};
+
+
+
+//------------------------------------------------------------------------------
+TEST_CASE("Prefix length")
+{
+    line_editor_tester tester;
+    prefix_generator generator;
+    tester.get_editor()->add_generator(generator);
+
+    // Returns how many times the generator was asked for a prefix length while
+    // editing a line with 'input'.
+    auto count_queries = [&] (const char* input) {
+        int queries = generator.queries;
+        tester.set_input(input);
+        tester.set_expected_matches();
+        tester.run();
+        return generator.queries - queries;
+    };
+
+    int queries = count_queries("cmd dir\\a");
+    REQUIRE(queries > 0);
+
+    SECTION("Unchanged command")
+    {
+        // Keys that don't edit the command reuse the remembered length.
+        REQUIRE(count_queries("cmd dir\\a" DO_COMPLETE DO_COMPLETE) == queries);
+    }
+
+    SECTION("Edited command")
+    {
+        REQUIRE(count_queries("cmd dir\\a" DO_COMPLETE "b") == queries + 1);
+        REQUIRE(count_queries("cmd dir\\a" DO_COMPLETE "b" DO_COMPLETE) == queries + 1);
+    }
+
+    SECTION("Restored command")
+    {
+        // The key is the command's text up to the cursor, so moving the cursor
+        // changes it. Only the last key is remembered, so moving back over the
+        // 'a' and forward again asks the generators once for each move.
+        REQUIRE(count_queries("cmd dir\\a" "\x1b[D" "\x1b[C") == queries + 2);
+    }
+}
@@ -0,0 +1,305 @@
+// Copyright (c) 2018 Martin Ridgers
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "line_editor_tester.h"
+
+#include <core/base.h>
+#include <core/str.h>
+#include <lib/editor_module.h>
+#include <lib/match_generator.h>
+#include <lib/matches.h>
+
+//------------------------------------------------------------------------------
+class numbered_generator
+    : public match_generator
+{
+public:
+    virtual bool generate(const line_state& line, match_builder& builder) override
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            str<16> match;
+            match.format("%02d_match", i);
+            builder.add_match(match.c_str());
+        }
+        return true;
+    }
+
+    virtual int get_prefix_length(const line_state& line) const override
+    {
+        return 0;
+    }
+
+    int             count = 60;
+};
+
+//------------------------------------------------------------------------------
+static int find_line(mem_screen_buffer& screen, const char* needle)
+{
+    for (int i = 0, n = screen.get_rows(); i < n; ++i)
+    {
+        str<> line;
+        screen.get_line(i, line);
+        if (strstr(line.c_str(), needle) != nullptr)
+            return i;
+    }
+
+    return -1;
+}
+
+//------------------------------------------------------------------------------
+static void dump_screen(mem_screen_buffer& screen)
+{
+    for (int i = 0, n = screen.get_rows(); i < n; ++i)
+    {
+        str<> line;
+        screen.get_line(i, line);
+        printf("%2d; %s#\n", i, line.c_str());
+    }
+}
+
+//------------------------------------------------------------------------------
+// Checks the screen shows the end of 'text' wrapped at the screen's width, with
+// the rows after it empty.
+static void require_wrapped(mem_screen_buffer& screen, const char* text)
+{
+    int columns = screen.get_columns();
+    int rows = screen.get_rows();
+    int length = int(strlen(text));
+    int text_rows = (length + columns - 1) / columns;
+    int first_row = max(0, text_rows - rows);
+
+    for (int i = 0; i < rows; ++i)
+    {
+        str<> expected;
+        int start = (first_row + i) * columns;
+        if (start < length)
+            expected.concat(text + start, min(columns, length - start));
+
+        while (expected.length() && expected.c_str()[expected.length() - 1] == ' ')
+            expected.truncate(expected.length() - 1);
+
+        str<> row;
+        screen.get_line(i, row);
+        REQUIRE(row.equals(expected.c_str()), [&] () {
+            printf("row %d expected; %s#\n", i, expected.c_str());
+            dump_screen(screen);
+        });
+    }
+}
+
+
+
+//------------------------------------------------------------------------------
+TEST_CASE("Render")
+{
+    line_editor_tester tester;
+    mem_screen_buffer& screen = tester.get_screen();
+
+    SECTION("Edit line")
+    {
+        tester.set_input("echo abc\x1b[H\x1b[3~");
+        tester.set_expected_screen("clink $ cho abc");
+        tester.run();
+        REQUIRE(screen.get_cursor_column() == 8);
+    }
+
+    SECTION("Prompt")
+    {
+        // The prompt's drawn once per line, including lines after the first.
+        // Each line starts on a clear screen.
+        for (int i = 0; i < 3; ++i)
+        {
+            screen.clear(screen_buffer::clear_type_all);
+            screen.set_cursor(0, 0);
+
+            tester.set_input("abc");
+            tester.set_expected_screen("clink $ abc");
+            tester.run();
+        }
+    }
+
+    SECTION("Match list")
+    {
+        editor_module* completer = tab_completer_create();
+        numbered_generator generator;
+        tester.get_editor()->add_module(*completer);
+        tester.get_editor()->add_generator(generator);
+
+        tester.set_input("\t\t");
+        tester.set_expected_screen(
+            "clink $",
+            "00_match  08_match  16_match  24_match  32_match  40_match  48_match  56_match",
+            "01_match  09_match  17_match  25_match  33_match  41_match  49_match  57_match",
+            "02_match  10_match  18_match  26_match  34_match  42_match  50_match  58_match",
+            "03_match  11_match  19_match  27_match  35_match  43_match  51_match  59_match",
+            "04_match  12_match  20_match  28_match  36_match  44_match  52_match",
+            "05_match  13_match  21_match  29_match  37_match  45_match  53_match",
+            "06_match  14_match  22_match  30_match  38_match  46_match  54_match",
+            "07_match  15_match  23_match  31_match  39_match  47_match  55_match",
+            "",
+            "clink $");
+        tester.run();
+
+        // Colours are applied to the matches.
+        REQUIRE(screen.get_cell_attributes(0, 1) != screen.get_cell_attributes(2, 1));
+
+        tab_completer_destroy(completer);
+    }
+
+    SECTION("Many matches")
+    {
+        editor_module* completer = tab_completer_create();
+        numbered_generator generator;
+        generator.count = 2000;
+        tester.get_editor()->add_module(*completer);
+        tester.get_editor()->add_generator(generator);
+
+        // Answer the "Show 2000 matches?" query and page through the lot.
+        str<> input;
+        input << "\t\ty";
+        for (int i = 0; i < 14; ++i)
+            input << " ";
+
+        tester.set_input(input.c_str());
+        tester.set_expected_output("");
+        tester.run();
+
+        // Matches are sorted so the last one, "99_match", is on the last page.
+        // Pages are drawn over the previous one rather than scrolling them.
+        REQUIRE(find_line(screen, "  99_match") >= 0, [&] () { dump_screen(screen); });
+        REQUIRE(find_line(screen, "-- More --") < 0, [&] () { dump_screen(screen); });
+        REQUIRE(screen.get_scroll_count() < unsigned(screen.get_rows()));
+
+        tab_completer_destroy(completer);
+    }
+
+    SECTION("Pager")
+    {
+        editor_module* completer = tab_completer_create();
+        numbered_generator generator;
+        generator.count = 300;
+        tester.get_editor()->add_module(*completer);
+        tester.get_editor()->add_generator(generator);
+
+        // A few rows a line at a time then the rest as a page. The window
+        // should move over the rows in place, ending with the last at its
+        // bottom.
+        tester.set_input("\t\ty\r\r\r ");
+        tester.set_expected_output("");
+        tester.run();
+
+        int rows = screen.get_rows();
+        REQUIRE(screen.get_scroll_count() < unsigned(rows));
+        REQUIRE(find_line(screen, "-- More --") < 0, [&] () { dump_screen(screen); });
+
+        int match_rows = 0;
+        for (int i = 0; i < rows; ++i)
+        {
+            str<> line;
+            screen.get_line(i, line);
+            match_rows += (strstr(line.c_str(), "_match") != nullptr);
+        }
+        REQUIRE(match_rows == rows - 2, [&] () { dump_screen(screen); });
+
+        int last = find_line(screen, "  99_match");
+        REQUIRE(last >= 0, [&] () { dump_screen(screen); });
+        REQUIRE(find_line(screen, "clink $") > last);
+
+        // Moving on a line repaints the window's rows where they are, so it
+        // costs the same as the first page did.
+        auto count_calls = [&] (const char* input) {
+            screen.clear(screen_buffer::clear_type_all);
+            screen.set_cursor(0, 0);
+
+            unsigned int start = screen.get_call_count();
+            tester.set_input(input);
+            tester.set_expected_output("");
+            tester.run();
+            return screen.get_call_count() - start;
+        };
+
+        unsigned int page = count_calls("\t\tyq");
+        unsigned int line = count_calls("\t\ty\rq") - page;
+        REQUIRE(page == 999);
+        REQUIRE(line == 993);
+        REQUIRE(count_calls("\t\ty\r\rq") == page + (line * 2));
+
+        tab_completer_destroy(completer);
+    }
+
+    SECTION("Long line")
+    {
+        // A line long enough to scroll the screen, followed by edits part way
+        // through it that move everything after them along.
+        str<> input;
+        for (int i = 0; i < 3000; ++i)
+            input.concat("echo %path% " + (i % 12), 1);
+
+        for (int i = 0; i < 100; ++i)
+            input << "\x02" "x";
+
+        tester.set_input(input.c_str());
+        tester.set_expected_matches();
+        tester.run();
+
+        REQUIRE(screen.get_scroll_count() > 0);
+
+        // Each edit inserted an 'x' before the line's last character.
+        str<> text;
+        text << "clink $ ";
+        text.concat(input.c_str(), 2999);
+        for (int i = 0; i < 100; ++i)
+            text << "x";
+        text << " ";
+
+        require_wrapped(screen, text.c_str());
+
+        // Once positioned the whole line's written in a single call, and edits
+        // don't redraw the dozens of rows it spans.
+        auto count_calls = [&] (const char* input) {
+            screen.clear(screen_buffer::clear_type_all);
+            screen.set_cursor(0, 0);
+
+            unsigned int start = screen.get_call_count();
+            tester.set_input(input);
+            tester.set_expected_matches();
+            tester.run();
+            return screen.get_call_count() - start;
+        };
+
+        str<> line;
+        line.concat(input.c_str(), 3000);
+        unsigned int written = count_calls(line.c_str());
+        REQUIRE(written == 2);
+
+        line << "\x02" "x";
+        REQUIRE(count_calls(line.c_str()) == written + 3);
+        REQUIRE(count_calls(input.c_str()) <= written + (100 * 5));
+    }
+
+    SECTION("Resize")
+    {
+        str<> input;
+        for (int i = 0; i < 500; ++i)
+            input.concat("echo %path% " + (i % 12), 1);
+
+        for (int i = 0; i < 50; ++i)
+            input << DO_RESIZE;
+
+        tester.set_resize(60, 25);
+        tester.set_input(input.c_str());
+        tester.set_expected_matches();
+        tester.run();
+
+        // An even number of resizes leaves the screen as it started, with the
+        // line redrawn to fit it.
+        REQUIRE(screen.get_columns() == 80);
+
+        str<> text;
+        text << "clink $ ";
+        text.concat(input.c_str(), 500);
+        require_wrapped(screen, text.c_str());
+    }
+}
@@ -0,0 +1,66 @@
+// Copyright (c) 2016 Martin Ridgers
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "fs_fixture.h"
+#include "rl/rl_snapshot.h"
+
+#include <core/path.h>
+#include <core/str.h>
+
+extern "C" {
+#include <readline/readline.h>
+#include <readline/rldefs.h>
+#include <readline/xmalloc.h>
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("Readline snapshot")
+{
+    fs_fixture fs;
+
+    str<> path;
+    path::join(fs.get_root(), "snapshot", path);
+
+    Keymap map = emacs_standard_keymap;
+    rl_command_func_t* undo = rl_named_function("undo");
+    rl_command_func_t* kill_line = rl_named_function("kill-line");
+
+    str<> query_items;
+    query_items << rl_variable_value("completion-query-items");
+
+    rl_bind_keyseq_in_map("\\C-xa", undo, map);
+
+    rl_snapshot base;
+    base.capture();
+
+    // Change things like an inputrc file would.
+    rl_bind_keyseq_in_map("\\C-xa", kill_line, map);
+    rl_generic_bind(ISMACR, "\\C-xb", savestring("abc"), map);
+    rl_variable_bind("completion-query-items", "123");
+
+    rl_snapshot loaded;
+    loaded.capture();
+    REQUIRE(loaded.save(path.c_str(), 0x493, base));
+
+    // Put things back and apply the snapshot to change them again.
+    rl_bind_keyseq_in_map("\\C-xa", undo, map);
+    rl_generic_bind(ISFUNC, "\\C-xb", nullptr, map);
+    rl_variable_bind("completion-query-items", query_items.c_str());
+
+    REQUIRE(!rl_snapshot::apply(path.c_str(), 0x394));
+    REQUIRE(rl_function_of_keyseq("\030a", map, nullptr) == undo);
+
+    REQUIRE(rl_snapshot::apply(path.c_str(), 0x493));
+    REQUIRE(rl_function_of_keyseq("\030a", map, nullptr) == kill_line);
+    REQUIRE(strcmp(rl_variable_value("completion-query-items"), "123") == 0);
+
+    int type;
+    auto* macro = (const char*)rl_function_of_keyseq("\030b", map, &type);
+    REQUIRE(type == ISMACR);
+    REQUIRE(strcmp(macro, "abc") == 0);
+
+    rl_generic_bind(ISFUNC, "\\C-xa", nullptr, map);
+    rl_generic_bind(ISFUNC, "\\C-xb", nullptr, map);
+    rl_variable_bind("completion-query-items", query_items.c_str());
+}
@@ -0,0 +1,87 @@
+// Copyright (c) 2016 Martin Ridgers
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <vector>
+
+class str_base;
+
+//------------------------------------------------------------------------------
+// A lua_Alloc implementation for the many small, short-lived objects Lua makes
+// while generating matches. Small blocks are rounded up to a size class and
+// carved linearly from slabs that each hold one class, and freed blocks are
+// kept on their slab's free list for reuse. Larger blocks go to the CRT heap.
+// A slab is released once all its blocks are freed (one empty slab is kept
+// spare so a burst that ends and starts again doesn't churn), so the memory
+// held is bounded by what's live plus a slab's worth per class. It must
+// outlive the Lua state using it.
+class lua_allocator
+{
+public:
+    struct stats
+    {
+        unsigned int    allocs;         // new blocks requested by Lua
+        unsigned int    reallocs;       // blocks resized
+        unsigned int    frees;
+        unsigned int    heap_allocs;    // blocks too big to pool
+        unsigned int    slabs;          // held now, including the spare
+        unsigned int    peak_slabs;
+        unsigned int    in_use;         // bytes
+        unsigned int    peak;           // bytes
+    };
+
+                        lua_allocator();
+                        ~lua_allocator();
+    static void*        alloc(void* user, void* ptr, size_t old_size, size_t new_size);
+    const stats&        get_stats() const;
+    void                report(str_base& out) const;
+
+private:
+    enum
+    {
+        class_granularity   = 16,
+        class_count         = 16,
+        max_pooled_size     = class_granularity * class_count,
+        slab_size           = 64 << 10,
+    };
+
+    struct free_block
+    {
+        free_block*     next;
+    };
+
+    struct slab
+    {
+        slab*           next;           // slabs of this class with room
+        slab*           prev;
+        free_block*     free;
+        unsigned int    index;          // in m_slabs
+        unsigned short  size_class;
+        unsigned short  live;           // blocks handed out
+        unsigned int    carved;         // offset of the next unused block
+    };
+
+    static int          get_class(size_t size);
+    static slab*        get_slab(void* ptr);
+    void*               allocate(size_t size);
+    void                deallocate(void* ptr, size_t size);
+    void*               reallocate(void* ptr, size_t old_size, size_t new_size);
+    bool                is_heap_stray(void* ptr);
+    slab*               create_slab(int size_class);
+    void                release_slab(slab* s);
+    bool                has_room(const slab* s) const;
+    void                link(slab* s);
+    void                unlink(slab* s);
+    slab*               m_partial[class_count] = {};
+    slab*               m_spare = nullptr;
+    std::vector<slab*>  m_slabs;
+    std::vector<void*>  m_heap_strays;   // heap blocks shrunk to pooled sizes
+    stats               m_stats = {};
+};
+
+//------------------------------------------------------------------------------
+inline const lua_allocator::stats& lua_allocator::get_stats() const
+{
+    return m_stats;
+}
@@ -5,23 +5,27 @@
 
 #include <lib/match_generator.h>
 
+class line_state_lua;
 class lua_state;
+class match_builder_lua;
 
 //------------------------------------------------------------------------------
 class lua_match_generator
     : public match_generator
 {
 public:
-                    lua_match_generator(lua_state& state);
-    virtual         ~lua_match_generator();
+                        lua_match_generator(lua_state& state);
+    virtual             ~lua_match_generator();
 
 private:
-    virtual bool    generate(const line_state& line, match_builder& builder) override;
-    virtual int     get_prefix_length(const line_state& line) const override;
-    void            initialise();
-    void            print_error(const char* error) const;
-    void            lua_pushlinestate(const line_state& line);
-    bool            load_script(const char* script);
-    void            load_scripts(const char* path);
-    lua_state&      m_state;
+    virtual bool        generate(const line_state& line, match_builder& builder) override;
+    virtual int         get_prefix_length(const line_state& line) const override;
+    void                initialise();
+    void                print_error(const char* error) const;
+    void                lua_pushlinestate(const line_state& line);
+    bool                load_script(const char* script);
+    void                load_scripts(const char* path);
+    lua_state&          m_state;
+    line_state_lua*     m_line_lua;
+    match_builder_lua*  m_builder_lua;
 };
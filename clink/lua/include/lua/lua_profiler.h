@@ -0,0 +1,57 @@
+// Copyright (c) 2016 Martin Ridgers
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <vector>
+
+class str_base;
+struct lua_Debug;
+struct lua_State;
+
+//------------------------------------------------------------------------------
+// Records how long generators and prompt filters take and how many allocations
+// they make. Scripts route calls through clink._profile() which only exists
+// while a profiler is attached. Optionally a count hook samples which script
+// lines are running.
+class lua_profiler
+{
+public:
+    enum mode
+    {
+        mode_off,
+        mode_calls,
+        mode_sampled,
+    };
+
+                        lua_profiler(lua_State* state, int mode);
+                        ~lua_profiler();
+    void                reset();
+    void                report(str_base& out) const;
+
+private:
+    struct entry
+    {
+        unsigned int    hash;
+        int             name;       // offset into m_strings
+        unsigned int    count;      // calls or samples
+        unsigned int    allocs;
+        long long       ticks;
+    };
+
+    typedef std::vector<entry> entries;
+
+    static int          profile_call(lua_State* state);
+    static void         sample_hook(lua_State* state, lua_Debug* debug);
+    static void*        alloc(void* user, void* ptr, size_t old_size, size_t new_size);
+    entry&              get_entry(entries& list, const char* name);
+    void                report(str_base& out, const entries& list, const char* title, unsigned int limit) const;
+    lua_State*          m_state;
+    void*               (*m_alloc)(void*, void*, size_t, size_t);
+    void*               m_alloc_user;
+    entries             m_calls;
+    entries             m_samples;
+    std::vector<char>   m_strings;
+    long long           m_last_sample = 0;
+    unsigned int        m_alloc_count = 0;
+};
@@ -3,6 +3,8 @@
 
 #pragma once
 
+class lua_allocator;
+class lua_profiler;
 struct lua_State;
 
 //------------------------------------------------------------------------------
@@ -14,11 +16,18 @@ public:
     void            initialise();
     void            shutdown();
     bool            do_string(const char* string, int length=-1);
-    bool            do_file(const char* path);
+    bool            do_file(const char* path, const char* cache_dir=nullptr);
     lua_State*      get_state() const;
+    lua_profiler*   get_profiler() const;
+    void            get_script_cache_stats(unsigned int& hits, unsigned int& misses) const;
 
 private:
+    bool            load_cached_file(const char* path, const char* cache_dir);
     lua_State*      m_state;
+    lua_allocator*  m_allocator;
+    lua_profiler*   m_profiler;
+    unsigned int    m_cache_hits;
+    unsigned int    m_cache_misses;
 };
 
 //------------------------------------------------------------------------------
@@ -26,3 +35,16 @@ inline lua_State* lua_state::get_state() const
 {
     return m_state;
 }
+
+//------------------------------------------------------------------------------
+inline lua_profiler* lua_state::get_profiler() const
+{
+    return m_profiler;
+}
+
+//------------------------------------------------------------------------------
+inline void lua_state::get_script_cache_stats(unsigned int& hits, unsigned int& misses) const
+{
+    hits = m_cache_hits;
+    misses = m_cache_misses;
+}
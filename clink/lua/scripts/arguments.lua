@@ -17,81 +17,9 @@ end
 
 
 --------------------------------------------------------------------------------
-local _argreader = {}
-_argreader.__index = _argreader
-setmetatable(_argreader, { __call = function (x, ...) return x._new(...) end })
-
---------------------------------------------------------------------------------
-function _argreader._new(root)
-    local reader = setmetatable({
-        _matcher = root,
-        _arg_index = 1,
-        _stack = {},
-    }, _argreader)
-    return reader
-end
-
---------------------------------------------------------------------------------
-function _argreader:update(word)
-    -- Check for flags and swtich matcher if the word is a flag.
-    local matcher = self._matcher
-    local is_flag = matcher:_is_flag(word)
-    if is_flag then
-        if matcher._flags then
-            self:_push(matcher._flags)
-        else
-            return
-        end
-    end
-
-    matcher = self._matcher
-    local arg_index = self._arg_index
-    local arg = matcher._args[arg_index]
-
-    arg_index = arg_index + 1
-
-    -- If arg_index is out of bounds we should loop if set or return to the
-    -- previous matcher if possible.
-    if arg_index > #matcher._args then
-        if matcher._loop then
-            self._arg_index = math.min(math.max(matcher._loop, 1), #matcher._args)
-        elseif not self:_pop() then
-            self._arg_index = arg_index
-        end
-    else
-        self._arg_index = arg_index
-    end
-
-    -- Some matchers have no args at all.
-    if not arg then
-        return
-    end
-
-    -- Does the word lead to another matcher?
-    for key, linked in pairs(arg._links) do
-        if key == word then
-            self:_push(linked)
-            break
-        end
-    end
-end
-
---------------------------------------------------------------------------------
-function _argreader:_push(matcher)
-    table.insert(self._stack, { self._matcher, self._arg_index })
-    self._matcher = matcher
-    self._arg_index = 1
-end
-
---------------------------------------------------------------------------------
-function _argreader:_pop()
-    if #self._stack > 0 then
-        self._matcher, self._arg_index = table.unpack(table.remove(self._stack))
-        return true
-    end
-
-    return false
-end
+-- Argmatchers are compiled into a native table that's used to walk the words
+-- of a line. Anything that changes an argmatcher needs to flag a recompile.
+local _compiled = { dirty = true }
 
 
 
@@ -117,6 +45,7 @@ function _argmatcher:addarg(...)
     local list = { _links = {} }
     self:_add(list, {...})
     table.insert(self._args, list)
+    _compiled.dirty = true
     return self
 end
 
@@ -131,6 +60,7 @@ function _argmatcher:addflags(...)
 
     flag_matcher._args[1] = list
     self._flags = flag_matcher
+    _compiled.dirty = true
     return self
 end
 
@@ -140,6 +70,7 @@ end
 --- -ret:   self
 function _argmatcher:loop(index)
     self._loop = index or -1
+    _compiled.dirty = true
     return self
 end
 
@@ -155,6 +86,7 @@ function _argmatcher:setflagprefix(...)
     end
 
     self._flagprefix = {...}
+    _compiled.dirty = true
     return self
 end
 
@@ -246,21 +178,7 @@ function _argmatcher:_add(list, addee)
 end
 
 --------------------------------------------------------------------------------
-function _argmatcher:_generate(line_state, match_builder)
-    local reader = _argreader(self)
-
-    -- Consume words and use them to move through matchers' arguments.
-    local word_count = line_state:getwordcount()
-    for word_index = 2, (word_count - 1) do
-        local word = line_state:getword(word_index)
-        reader:update(word)
-    end
-
-    -- There should always be a matcher left on the stack, but the arg_index
-    -- could be well out of range.
-    local matcher = reader._matcher
-    local arg_index = reader._arg_index
-
+function _argmatcher:_generate(arg_index, end_is_flag, line_state, match_builder)
     -- Are we left with a valid argument that can provide matches?
     local add_matches = function(arg)
         for key, _ in pairs(arg._links) do
@@ -269,7 +187,7 @@ function _argmatcher:_generate(line_state, match_builder)
 
         for _, i in ipairs(arg) do
             if type(i) == "function" then
-                local j = i(word_count, line_state, match_builder)
+                local j = i(line_state:getwordcount(), line_state, match_builder)
                 if type(j) ~= "table" then
                     return j or false
                 end
@@ -285,18 +203,18 @@ function _argmatcher:_generate(line_state, match_builder)
 
     -- Select between adding flags or matches themselves. Works in conjunction
     -- with getprefixlength()'s return.
-    if matcher._flags and matcher:_is_flag(line_state:getendword()) then
+    if end_is_flag then
         match_builder:setprefixincluded()
-        add_matches(matcher._flags._args[1])
+        add_matches(self._flags._args[1])
     else
-        local arg = matcher._args[arg_index]
+        local arg = self._args[arg_index]
         if arg then
             return add_matches(arg) and true or false
         end
     end
 
     -- No valid argument. Decide if we should match files or not.
-    local no_files = matcher._no_file_generation or #matcher._args == 0
+    local no_files = self._no_file_generation or #self._args == 0
     return no_files
 end
 
@@ -327,32 +245,20 @@ function clink.argmatcher(...)
         _argmatchers[i:lower()] = matcher
     end
 
+    _compiled.dirty = true
     return matcher
 end
 
 
 
 --------------------------------------------------------------------------------
-local function _find_argmatcher(line_state)
-    -- Running an argmatcher only makes sense if there's two or more words.
-    if line_state:getwordcount() < 2 then
-        return
+local function _get_compiled_argmatchers()
+    if _compiled.dirty then
+        _compiled.table, _compiled.matchers = clink._compile_argmatchers(_argmatchers)
+        _compiled.dirty = false
     end
 
-    local first_word = line_state:getword(1)
-
-    -- Search for a valid argmatcher and return it.
-    local argmatcher_keys = {
-        path.getname(first_word):lower(),
-        path.getbasename(first_word):lower(),
-    }
-
-    for _, key in ipairs(argmatcher_keys) do
-        local argmatcher = _argmatchers[key]
-        if argmatcher then
-            return argmatcher
-        end
-    end
+    return _compiled.table
 end
 
 
@@ -360,11 +266,17 @@ end
 --------------------------------------------------------------------------------
 local argmatcher_generator = clink.generator(24)
 
+-- Once compiled the prefix length can be found natively.
+argmatcher_generator:setprefixrule("_argmatcher")
+argmatcher_generator._compiled = _compiled
+
 --------------------------------------------------------------------------------
 function argmatcher_generator:generate(line_state, match_builder)
-    local argmatcher = _find_argmatcher(line_state)
-    if argmatcher then
-        return argmatcher:_generate(line_state, match_builder)
+    local compiled = _get_compiled_argmatchers()
+    local index, arg_index, end_is_flag = clink._walk_argmatchers(compiled, line_state)
+    if index then
+        local matcher = _compiled.matchers[index]
+        return matcher:_generate(arg_index, end_is_flag, line_state, match_builder)
     end
 
     return false
@@ -372,11 +284,6 @@ end
 
 --------------------------------------------------------------------------------
 function argmatcher_generator:getprefixlength(line_state)
-    local argmatcher = _find_argmatcher(line_state)
-    local word = line_state:getendword()
-    if argmatcher and argmatcher._flags and argmatcher:_is_flag(word) then
-        return 1
-    end
-
-    return 0
+    local compiled = _get_compiled_argmatchers()
+    return clink._get_argmatcher_prefix_length(compiled, line_state)
 end
@@ -6,6 +6,9 @@ clink = clink or {}
 local _generators = {}
 local _generators_unsorted = false
 
+-- Generators are read natively when calculating prefix lengths.
+clink._generators = _generators
+
 
 
 --------------------------------------------------------------------------------
@@ -32,11 +35,42 @@ local function prepare()
     end
 end
 
+--------------------------------------------------------------------------------
+local function profile(category, id_func, func, ...)
+    -- clink._profile() only exists when Lua scripts are being profiled.
+    local profile = clink._profile
+    if profile then
+        return profile(category, id_func, func, ...)
+    end
+
+    return func(...)
+end
+
+--------------------------------------------------------------------------------
+local function run_to_completion(func, ...)
+    -- Generators may yield (e.g. by sharing code with prompt filters) but their
+    -- matches are needed immediately so they're resumed until they finish.
+    local co = coroutine.create(func)
+    local ok, ret = coroutine.resume(co, ...)
+    while ok and coroutine.status(co) == "suspended" do
+        ok, ret = coroutine.resume(co)
+    end
+
+    -- The error's raised again outside of the coroutine so the generator's
+    -- stack is added to it while it can still be walked.
+    if not ok then
+        error(debug.traceback(co, ret), 0)
+    end
+
+    return ret
+end
+
 --------------------------------------------------------------------------------
 function clink._generate(line_state, match_builder)
     local impl = function ()
         for _, generator in ipairs(_generators) do
-            local ret = generator:generate(line_state, match_builder)
+            local ret = profile("generate", generator.generate, run_to_completion,
+                generator.generate, generator, line_state, match_builder)
             if ret == true then
                 return true
             end
@@ -50,25 +84,30 @@ function clink._generate(line_state, match_builder)
     return ret or false
 end
 
---------------------------------------------------------------------------------
-function clink._get_prefix_length(line_state)
-    local impl = function ()
-        local ret = 0
-        for _, generator in ipairs(_generators) do
-            if generator.getprefixlength then
-                local i = generator:getprefixlength(line_state) or 0
-                if i > ret then ret = i end
-            end
-        end
 
-        return ret
-    end
 
-    prepare()
-    local ret = pcall_dispatch(impl)
-    return ret or 0
+--------------------------------------------------------------------------------
+local _generator = {}
+_generator.__index = _generator
+
+--------------------------------------------------------------------------------
+--- -name:  generator:setprefixrule
+--- -arg:   rule:string
+--- -arg:   [chars:string]
+--- -ret:   self
+--- Declares how the generator's prefix length is found so Clink can calculate
+--- it natively instead of calling the generator's getprefixlength() method on
+--- each key press. The rule is one of; "none" (no prefix), "separator" (the
+--- prefix ends after the last of 'chars' in the end word), or "toggle" (as
+--- "separator" but only if there's an odd number of 'chars').
+function _generator:setprefixrule(rule, chars)
+    self._prefixrule = rule
+    self._prefixchars = chars or ""
+    return self
 end
 
+
+
 --------------------------------------------------------------------------------
 --- -name:  clink.generator
 --- -arg:   [priority:integer]
@@ -76,7 +115,7 @@ end
 function clink.generator(priority)
     if priority == nil then priority = 999 end
 
-    local ret = { _priority = priority }
+    local ret = setmetatable({ _priority = priority }, _generator)
     table.insert(_generators, ret)
 
     _generators_unsorted = true
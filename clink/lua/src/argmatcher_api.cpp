@@ -0,0 +1,110 @@
+// Copyright (c) 2016 Martin Ridgers
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "argmatcher_table.h"
+#include "line_state_lua.h"
+#include "lua_state.h"
+
+#include <core/base.h>
+#include <lib/line_state.h>
+
+#include <new>
+
+//------------------------------------------------------------------------------
+static argmatcher_table* check_table(lua_State* state, int index)
+{
+    return (argmatcher_table*)luaL_testudata(state, index, "argmatcher_table_mt");
+}
+
+//------------------------------------------------------------------------------
+// Compiles a table of argmatchers keyed by command name into a native table
+// that can be walked without allocating. Also returns a table to map the native
+// table's matcher indices back to the argmatcher tables.
+static int compile_argmatchers(lua_State* state)
+{
+    void* addr = lua_newuserdata(state, sizeof(argmatcher_table));
+    auto* table = new (addr) argmatcher_table();
+
+    if (luaL_newmetatable(state, "argmatcher_table_mt"))
+    {
+        lua_pushliteral(state, "__gc");
+        lua_pushcfunction(state, [](lua_State* state) -> int {
+            auto* table = (argmatcher_table*)lua_touserdata(state, -1);
+            table->~argmatcher_table();
+            return 0;
+        });
+        lua_rawset(state, -3);
+    }
+
+    lua_setmetatable(state, -2);
+
+    if (!table->compile(state, 1))
+        return 0;
+
+    return 2;
+}
+
+//------------------------------------------------------------------------------
+// Finds the argmatcher for the line's command and walks its words, returning
+// the index of the matcher and argument that the end word is in, and if the
+// end word should be treated as a flag.
+static int walk_argmatchers(lua_State* state)
+{
+    const argmatcher_table* table = check_table(state, 1);
+    const line_state* line = line_state_lua::check(state, 2);
+    if (table == nullptr || line == nullptr)
+        return 0;
+
+    argmatcher_table::result result;
+    if (!table->walk(*line, result))
+        return 0;
+
+    str<128> end_word;
+    line->get_end_word(end_word);
+    bool end_flag = (table->has_flags(result.matcher) &&
+        table->is_flag(result.matcher, end_word.c_str()));
+
+    lua_pushinteger(state, result.matcher + 1);
+    lua_pushinteger(state, result.arg_index);
+    lua_pushboolean(state, end_flag);
+    return 3;
+}
+
+//------------------------------------------------------------------------------
+static int get_argmatcher_prefix_length(lua_State* state)
+{
+    const argmatcher_table* table = check_table(state, 1);
+    const line_state* line = line_state_lua::check(state, 2);
+    if (table == nullptr || line == nullptr)
+        return 0;
+
+    lua_pushinteger(state, table->get_prefix_length(*line));
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+void argmatcher_lua_initialise(lua_state& lua)
+{
+    struct {
+        const char* name;
+        int         (*method)(lua_State*);
+    } methods[] = {
+        { "_compile_argmatchers",           &compile_argmatchers },
+        { "_walk_argmatchers",              &walk_argmatchers },
+        { "_get_argmatcher_prefix_length",  &get_argmatcher_prefix_length },
+    };
+
+    lua_State* state = lua.get_state();
+
+    lua_getglobal(state, "clink");
+
+    for (const auto& method : methods)
+    {
+        lua_pushstring(state, method.name);
+        lua_pushcfunction(state, method.method);
+        lua_rawset(state, -3);
+    }
+
+    lua_pop(state, 1);
+}
@@ -0,0 +1,377 @@
+// Copyright (c) 2016 Martin Ridgers
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "argmatcher_table.h"
+
+#include <core/base.h>
+#include <core/path.h>
+#include <core/str.h>
+#include <lib/line_state.h>
+
+#include <algorithm>
+
+//------------------------------------------------------------------------------
+static unsigned int hash_word(const char* in, int length)
+{
+    unsigned int hash = 5381;
+    for (int i = 0; i < length; ++i)
+        hash = ((hash << 5) + hash) ^ (unsigned char)in[i];
+    return hash;
+}
+
+
+
+//------------------------------------------------------------------------------
+int argmatcher_table::add_string(const char* in, int length)
+{
+    int offset = int(m_strings.size());
+    m_strings.insert(m_strings.end(), in, in + length);
+    return offset;
+}
+
+//------------------------------------------------------------------------------
+bool argmatcher_table::compile(lua_State* state, int matchers_index)
+{
+    // Compiles the "command name -> argmatcher" table at 'matchers_index'. On
+    // success a table mapping compiled indices (1-based) back to each of the
+    // argmatcher tables is left on the top of the stack.
+
+    m_matchers.clear();
+    m_args.clear();
+    m_links.clear();
+    m_commands.clear();
+    m_strings.clear();
+
+    matchers_index = lua_absindex(state, matchers_index);
+    if (!lua_istable(state, matchers_index))
+        return false;
+
+    lua_createtable(state, 0, 0);
+    int tables_index = lua_gettop(state);
+
+    lua_createtable(state, 0, 0);
+    int ids_index = lua_gettop(state);
+
+    // Matchers are given an index the first time they're seen and compiled
+    // later on, which keeps each matcher's args and links contiguous.
+    auto get_id = [&] (int value_index) -> int {
+        value_index = lua_absindex(state, value_index);
+        if (!lua_istable(state, value_index))
+            return -1;
+
+        lua_pushvalue(state, value_index);
+        lua_rawget(state, ids_index);
+        if (lua_isnumber(state, -1))
+        {
+            int id = int(lua_tointeger(state, -1));
+            lua_pop(state, 1);
+            return id;
+        }
+        lua_pop(state, 1);
+
+        int id = int(m_matchers.size());
+        m_matchers.push_back({});
+
+        lua_pushvalue(state, value_index);
+        lua_pushinteger(state, id);
+        lua_rawset(state, ids_index);
+
+        lua_pushvalue(state, value_index);
+        lua_rawseti(state, tables_index, id + 1);
+        return id;
+    };
+
+    // Registered commands.
+    lua_pushnil(state);
+    while (lua_next(state, matchers_index))
+    {
+        if (lua_type(state, -2) == LUA_TSTRING)
+        {
+            int id = get_id(-1);
+            if (id >= 0)
+            {
+                size_t length;
+                const char* key = lua_tolstring(state, -2, &length);
+
+                link command = { hash_word(key, int(length)) };
+                command.key = add_string(key, int(length));
+                command.key_length = int(length);
+                command.matcher = id;
+                m_commands.push_back(command);
+            }
+        }
+
+        lua_pop(state, 1);
+    }
+
+    std::sort(m_commands.begin(), m_commands.end());
+
+    // Compile each matcher in turn. More may be found as links are followed.
+    for (int i = 0; i < int(m_matchers.size()); ++i)
+    {
+        lua_rawgeti(state, tables_index, i + 1);
+
+        matcher out = {};
+        out.flags = -1;
+
+        lua_getfield(state, -1, "_args");
+        if (lua_istable(state, -1))
+        {
+            int arg_count = int(lua_rawlen(state, -1));
+            out.arg_begin = int(m_args.size());
+            out.arg_count = arg_count;
+            m_args.resize(m_args.size() + arg_count);
+
+            for (int j = 0; j < arg_count; ++j)
+            {
+                arg arg = { int(m_links.size()), 0 };
+
+                lua_rawgeti(state, -1, j + 1);
+                lua_getfield(state, -1, "_links");
+                if (lua_istable(state, -1))
+                {
+                    lua_pushnil(state);
+                    while (lua_next(state, -2))
+                    {
+                        int id;
+                        if (lua_type(state, -2) == LUA_TSTRING && (id = get_id(-1)) >= 0)
+                        {
+                            size_t length;
+                            const char* key = lua_tolstring(state, -2, &length);
+
+                            link link = { hash_word(key, int(length)) };
+                            link.key = add_string(key, int(length));
+                            link.key_length = int(length);
+                            link.matcher = id;
+                            m_links.push_back(link);
+                        }
+
+                        lua_pop(state, 1);
+                    }
+                }
+                lua_pop(state, 2);
+
+                arg.link_count = int(m_links.size()) - arg.link_begin;
+                std::sort(m_links.begin() + arg.link_begin, m_links.end());
+                m_args[out.arg_begin + j] = arg;
+            }
+        }
+        lua_pop(state, 1);
+
+        lua_getfield(state, -1, "_flags");
+        out.flags = get_id(-1);
+        lua_pop(state, 1);
+
+        // Lua's truthiness means that loop(0) still loops.
+        lua_getfield(state, -1, "_loop");
+        if (lua_isnumber(state, -1))
+            out.loop = max(int(lua_tointeger(state, -1)), 1);
+        lua_pop(state, 1);
+
+        // Flag prefixes are single characters, kept as a string for strchr().
+        out.flag_prefix = int(m_strings.size());
+        lua_getfield(state, -1, "_flagprefix");
+        if (lua_istable(state, -1))
+        {
+            for (int j = 0, n = int(lua_rawlen(state, -1)); j < n; ++j)
+            {
+                lua_rawgeti(state, -1, j + 1);
+                const char* prefix = lua_tostring(state, -1);
+                if (prefix != nullptr && prefix[0])
+                    m_strings.push_back(prefix[0]);
+                lua_pop(state, 1);
+            }
+        }
+        m_strings.push_back('\0');
+        lua_pop(state, 1);
+
+        m_matchers[i] = out;
+        lua_pop(state, 1);
+    }
+
+    lua_pop(state, 1); // ids
+    return true;
+}
+
+//------------------------------------------------------------------------------
+unsigned int argmatcher_table::get_matcher_count() const
+{
+    return (unsigned int)m_matchers.size();
+}
+
+//------------------------------------------------------------------------------
+int argmatcher_table::find_link(
+    const link* links,
+    int count,
+    const char* word,
+    int length) const
+{
+    link key = { hash_word(word, length) };
+    const link* end = links + count;
+    for (const link* i = std::lower_bound(links, end, key); i < end; ++i)
+    {
+        if (i->hash != key.hash)
+            break;
+
+        if (i->key_length == length && !memcmp(&m_strings[i->key], word, length))
+            return i->matcher;
+    }
+
+    return -1;
+}
+
+//------------------------------------------------------------------------------
+int argmatcher_table::find(const line_state& line) const
+{
+    // Running an argmatcher only makes sense if there's two or more words.
+    if (line.get_word_count() < 2 || m_commands.empty())
+        return -1;
+
+    str<288> first_word;
+    line.get_word(0, first_word);
+
+    str<288> name(path::get_name(first_word.c_str()));
+    for (int i = 0, n = name.length(); i < n; ++i)
+        name.data()[i] = char(tolower((unsigned char)name[i]));
+
+    const link* commands = &m_commands[0];
+    int count = int(m_commands.size());
+
+    // Try the name as it is (e.g. 'foo.exe') and then without the extension.
+    int id = find_link(commands, count, name.c_str(), name.length());
+    if (id >= 0)
+        return id;
+
+    int dot = name.last_of('.');
+    if (dot < 0)
+        return -1;
+
+    return find_link(commands, count, name.c_str(), dot);
+}
+
+//------------------------------------------------------------------------------
+bool argmatcher_table::is_flag(const matcher& matcher, const char* word, int length) const
+{
+    const char* prefixes = &m_strings[matcher.flag_prefix];
+    return (length > 0 && word[0] && strchr(prefixes, word[0]) != nullptr);
+}
+
+//------------------------------------------------------------------------------
+bool argmatcher_table::is_flag(int matcher, const char* word) const
+{
+    return is_flag(m_matchers[matcher], word, int(strlen(word)));
+}
+
+//------------------------------------------------------------------------------
+bool argmatcher_table::has_flags(int matcher) const
+{
+    return (m_matchers[matcher].flags >= 0);
+}
+
+//------------------------------------------------------------------------------
+int argmatcher_table::get_prefix_length(const line_state& line) const
+{
+    // Flags include their prefix character in matches so the prefix length is
+    // one if the end word is a flag.
+    int matcher = find(line);
+    if (matcher < 0 || !has_flags(matcher))
+        return 0;
+
+    str_iter end_word = line.get_end_word();
+    return is_flag(m_matchers[matcher], end_word.get_pointer(), end_word.length()) ? 1 : 0;
+}
+
+//------------------------------------------------------------------------------
+bool argmatcher_table::walk(const line_state& line, result& out) const
+{
+    int root = find(line);
+    if (root < 0)
+        return false;
+
+    // Each word can push at most twice (a flag and a link). The editor only
+    // tracks so many words so a fixed stack usually suffices, but lines with
+    // more words than it holds get a stack from the heap.
+    struct frame
+    {
+        int     matcher;
+        int     arg_index;
+    };
+    frame fixed_stack[160];
+    std::vector<frame> heap_stack;
+    frame* stack = fixed_stack;
+    int needed = int(line.get_word_count()) * 2;
+    if (needed > sizeof_array(fixed_stack))
+    {
+        heap_stack.resize(needed);
+        stack = heap_stack.data();
+    }
+    int stack_size = 0;
+
+    int current = root;
+    int arg_index = 1;
+
+    auto push = [&] (int next) {
+        stack[stack_size++] = { current, arg_index };
+        current = next;
+        arg_index = 1;
+    };
+
+    auto pop = [&] () -> bool {
+        if (stack_size <= 0)
+            return false;
+        --stack_size;
+        current = stack[stack_size].matcher;
+        arg_index = stack[stack_size].arg_index;
+        return true;
+    };
+
+    // Consume words and use them to move through matchers' arguments.
+    for (int i = 1, n = int(line.get_word_count()) - 1; i < n; ++i)
+    {
+        str_iter word_iter = line.get_word(i);
+        const char* word = word_iter.get_pointer();
+        int length = word_iter.length();
+
+        // Check for flags and switch matcher if the word is a flag.
+        if (is_flag(m_matchers[current], word, length))
+        {
+            int flags = m_matchers[current].flags;
+            if (flags < 0)
+                continue;
+
+            push(flags);
+        }
+
+        const matcher& matcher = m_matchers[current];
+        const arg* arg = nullptr;
+        if (arg_index >= 1 && arg_index <= matcher.arg_count)
+            arg = &m_args[matcher.arg_begin + arg_index - 1];
+
+        // If the next arg is out of bounds we should loop if set or return to
+        // the previous matcher if possible.
+        int next_index = arg_index + 1;
+        if (next_index > matcher.arg_count)
+        {
+            if (matcher.loop)
+                arg_index = min(matcher.loop, matcher.arg_count);
+            else if (!pop())
+                arg_index = next_index;
+        }
+        else
+            arg_index = next_index;
+
+        // Does the word lead to another matcher?
+        if (arg != nullptr && arg->link_count)
+        {
+            const link* links = &m_links[arg->link_begin];
+            int linked = find_link(links, arg->link_count, word, length);
+            if (linked >= 0)
+                push(linked);
+        }
+    }
+
+    out.matcher = current;
+    out.arg_index = arg_index;
+    return true;
+}
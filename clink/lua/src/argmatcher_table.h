@@ -0,0 +1,65 @@
+// Copyright (c) 2016 Martin Ridgers
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <vector>
+
+class line_state;
+struct lua_State;
+
+//------------------------------------------------------------------------------
+// A flattened, native copy of the argmatchers defined in Lua. The graph of
+// matchers/arguments/links is compiled once and then walked for each line
+// without calling back into Lua or creating any Lua garbage.
+class argmatcher_table
+{
+public:
+    struct result
+    {
+        int                 matcher;    // index into the compiled matchers
+        int                 arg_index;  // 1-based, may be out of range
+    };
+
+    bool                    compile(lua_State* state, int matchers_index);
+    int                     find(const line_state& line) const;
+    bool                    walk(const line_state& line, result& out) const;
+    bool                    is_flag(int matcher, const char* word) const;
+    bool                    has_flags(int matcher) const;
+    int                     get_prefix_length(const line_state& line) const;
+    unsigned int            get_matcher_count() const;
+
+private:
+    struct matcher
+    {
+        int                 arg_begin;
+        int                 arg_count;
+        int                 flags;      // matcher index or -1
+        int                 loop;       // 0 if the matcher doesn't loop
+        int                 flag_prefix; // offset of a nul-terminated set in m_strings
+    };
+
+    struct arg
+    {
+        int                 link_begin;
+        int                 link_count;
+    };
+
+    struct link
+    {
+        unsigned int        hash;
+        int                 key;        // offset into m_strings
+        int                 key_length;
+        int                 matcher;
+        bool                operator < (const link& rhs) const { return hash < rhs.hash; }
+    };
+
+    int                     add_string(const char* in, int length);
+    int                     find_link(const link* links, int count, const char* word, int length) const;
+    bool                    is_flag(const matcher& matcher, const char* word, int length) const;
+    std::vector<matcher>    m_matchers;
+    std::vector<arg>        m_args;
+    std::vector<link>       m_links;
+    std::vector<link>       m_commands;
+    std::vector<char>       m_strings;
+};
@@ -22,19 +22,35 @@ static line_state_lua::method g_methods[] = {
 
 
 //------------------------------------------------------------------------------
-line_state_lua::line_state_lua(const line_state& line)
+line_state_lua::line_state_lua(const line_state* line)
 : lua_bindable("line_state", g_methods)
 , m_line(line)
 {
 }
 
+//------------------------------------------------------------------------------
+void line_state_lua::set_line_state(const line_state* line)
+{
+    m_line = line;
+}
+
+//------------------------------------------------------------------------------
+const line_state* line_state_lua::check(lua_State* state, int index)
+{
+    auto* const* self = (line_state_lua* const*)luaL_testudata(state, index, "line_state_mt");
+    if (self == nullptr || *self == nullptr)
+        return nullptr;
+
+    return (*self)->m_line;
+}
+
 //------------------------------------------------------------------------------
 /// -name:  line:getline
 /// -ret:   string
 /// Returns the current line in its entirety.
 int line_state_lua::get_line(lua_State* state)
 {
-    lua_pushstring(state, m_line.get_line());
+    lua_pushstring(state, m_line->get_line());
     return 1;
 }
 
@@ -44,7 +60,7 @@ int line_state_lua::get_line(lua_State* state)
 /// Returns the position of the cursor.
 int line_state_lua::get_cursor(lua_State* state)
 {
-    lua_pushinteger(state, m_line.get_cursor() + 1);
+    lua_pushinteger(state, m_line->get_cursor() + 1);
     return 1;
 }
 
@@ -59,7 +75,7 @@ int line_state_lua::get_cursor(lua_State* state)
 /// command of the line unquoted as whitespace isn't considered for words.
 int line_state_lua::get_command_offset(lua_State* state)
 {
-    lua_pushinteger(state, m_line.get_command_offset() + 1);
+    lua_pushinteger(state, m_line->get_command_offset() + 1);
     return 1;
 }
 
@@ -69,7 +85,7 @@ int line_state_lua::get_command_offset(lua_State* state)
 /// Returns the number of words in the current line.
 int line_state_lua::get_word_count(lua_State* state)
 {
-    lua_pushinteger(state, m_line.get_word_count());
+    lua_pushinteger(state, m_line->get_word_count());
     return 1;
 }
 
@@ -85,7 +101,7 @@ int line_state_lua::get_word_info(lua_State* state)
     if (!lua_isnumber(state, 1))
         return 0;
 
-    const array<word>& words = m_line.get_words();
+    const array<word>& words = m_line->get_words();
     unsigned int index = int(lua_tointeger(state, 1)) - 1;
     if (index >= words.size())
         return 0;
@@ -125,7 +141,7 @@ int line_state_lua::get_word(lua_State* state)
         return 0;
 
     unsigned int index = int(lua_tointeger(state, 1)) - 1;
-    str_iter word = m_line.get_word(index);
+    str_iter word = m_line->get_word(index);
     lua_pushlstring(state, word.get_pointer(), word.length());
     return 1;
 }
@@ -138,7 +154,7 @@ int line_state_lua::get_word(lua_State* state)
 /// generated for.
 int line_state_lua::get_end_word(lua_State* state)
 {
-    str_iter word = m_line.get_end_word();
+    str_iter word = m_line->get_end_word();
     lua_pushlstring(state, word.get_pointer(), word.length());
     return 1;
 }
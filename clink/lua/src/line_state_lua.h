@@ -13,7 +13,9 @@ class line_state_lua
     : public lua_bindable<line_state_lua>
 {
 public:
-                        line_state_lua(const line_state& line);
+                        line_state_lua(const line_state* line=nullptr);
+    void                set_line_state(const line_state* line);
+    static const line_state* check(lua_State* state, int index);
     int                 get_line(lua_State* state);
     int                 get_cursor(lua_State* state);
     int                 get_command_offset(lua_State* state);
@@ -23,5 +25,5 @@ public:
     int                 get_end_word(lua_State* state);
 
 private:
-    const line_state&   m_line;
+    const line_state*   m_line;
 };
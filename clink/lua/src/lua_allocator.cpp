@@ -0,0 +1,292 @@
+// Copyright (c) 2016 Martin Ridgers
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "lua_allocator.h"
+
+#include <core/base.h>
+#include <core/str.h>
+
+//------------------------------------------------------------------------------
+lua_allocator::lua_allocator()
+{
+}
+
+//------------------------------------------------------------------------------
+lua_allocator::~lua_allocator()
+{
+    for (slab* s : m_slabs)
+        VirtualFree(s, 0, MEM_RELEASE);
+
+    if (m_spare != nullptr)
+        VirtualFree(m_spare, 0, MEM_RELEASE);
+}
+
+//------------------------------------------------------------------------------
+void* lua_allocator::alloc(void* user, void* ptr, size_t old_size, size_t new_size)
+{
+    auto* self = (lua_allocator*)user;
+    stats& counts = self->m_stats;
+
+    // When 'ptr' is null Lua passes the type of object being made in
+    // 'old_size' rather than a size.
+    if (ptr == nullptr)
+        old_size = 0;
+
+    if (new_size == 0)
+    {
+        if (ptr != nullptr)
+        {
+            self->deallocate(ptr, old_size);
+            counts.in_use -= unsigned(old_size);
+            ++counts.frees;
+        }
+        return nullptr;
+    }
+
+    void* ret;
+    if (ptr == nullptr)
+    {
+        ret = self->allocate(new_size);
+        ++counts.allocs;
+    }
+    else
+    {
+        ret = self->reallocate(ptr, old_size, new_size);
+        ++counts.reallocs;
+    }
+
+    if (ret != nullptr)
+    {
+        counts.in_use += unsigned(new_size - old_size);
+        counts.peak = max(counts.peak, counts.in_use);
+    }
+
+    return ret;
+}
+
+//------------------------------------------------------------------------------
+int lua_allocator::get_class(size_t size)
+{
+    if (size > max_pooled_size)
+        return -1;
+
+    return int((size - 1) / class_granularity);
+}
+
+//------------------------------------------------------------------------------
+lua_allocator::slab* lua_allocator::get_slab(void* ptr)
+{
+    // Slabs are aligned to their size so a block's slab is found by masking.
+    return (slab*)(uintptr_t(ptr) & ~uintptr_t(slab_size - 1));
+}
+
+//------------------------------------------------------------------------------
+void* lua_allocator::allocate(size_t size)
+{
+    int size_class = get_class(size);
+    if (size_class < 0)
+    {
+        ++m_stats.heap_allocs;
+        return malloc(size);
+    }
+
+    slab* s = m_partial[size_class];
+    if (s == nullptr && (s = create_slab(size_class)) == nullptr)
+        return nullptr;
+
+    // Reuse a freed block if there is one, otherwise carve a new block.
+    void* ptr;
+    if (free_block* block = s->free)
+    {
+        s->free = block->next;
+        ptr = block;
+    }
+    else
+    {
+        ptr = (char*)s + s->carved;
+        s->carved += (size_class + 1) * class_granularity;
+    }
+
+    ++s->live;
+    if (!has_room(s))
+        unlink(s);
+
+    return ptr;
+}
+
+//------------------------------------------------------------------------------
+void lua_allocator::deallocate(void* ptr, size_t size)
+{
+    int size_class = get_class(size);
+    if (size_class < 0 || is_heap_stray(ptr))
+    {
+        free(ptr);
+        return;
+    }
+
+    slab* s = get_slab(ptr);
+    bool was_full = !has_room(s);
+
+    auto* block = (free_block*)ptr;
+    block->next = s->free;
+    s->free = block;
+    --s->live;
+
+    if (!s->live)
+    {
+        if (!was_full)
+            unlink(s);
+
+        release_slab(s);
+    }
+    else if (was_full)
+        link(s);
+}
+
+//------------------------------------------------------------------------------
+void* lua_allocator::reallocate(void* ptr, size_t old_size, size_t new_size)
+{
+    // Blocks that stay within their size class don't need to move.
+    int old_class = get_class(old_size);
+    int new_class = get_class(new_size);
+    if (old_class == new_class && old_class >= 0)
+        return ptr;
+
+    if (old_class < 0 && new_class < 0)
+        return realloc(ptr, new_size);
+
+    // Lua assumes shrinking a block can't fail. If there's no slab to move a
+    // shrinking block into it stays where it is. Heap blocks that stay are
+    // remembered so they're still freed to the heap at their smaller size.
+    void* ret = allocate(new_size);
+    if (ret == nullptr)
+    {
+        if (new_size > old_size)
+            return nullptr;
+
+        if (old_class < 0)
+            m_heap_strays.push_back(ptr);
+
+        return ptr;
+    }
+
+    memcpy(ret, ptr, min(old_size, new_size));
+    deallocate(ptr, old_size);
+    return ret;
+}
+
+//------------------------------------------------------------------------------
+bool lua_allocator::is_heap_stray(void* ptr)
+{
+    // Removes 'ptr' from the strays if it's one. There are only ever strays
+    // after slabs couldn't be allocated so this is almost always empty.
+    for (size_t i = 0, n = m_heap_strays.size(); i < n; ++i)
+    {
+        if (m_heap_strays[i] != ptr)
+            continue;
+
+        m_heap_strays[i] = m_heap_strays.back();
+        m_heap_strays.pop_back();
+        return true;
+    }
+
+    return false;
+}
+
+//------------------------------------------------------------------------------
+lua_allocator::slab* lua_allocator::create_slab(int size_class)
+{
+    // VirtualAlloc() places regions on the allocation granularity (64KB) which
+    // gives slabs the alignment get_slab() relies on, and releasing one hands
+    // its memory straight back to the system.
+    slab* s = m_spare;
+    if (s != nullptr)
+        m_spare = nullptr;
+    else
+    {
+        s = (slab*)VirtualAlloc(nullptr, slab_size, MEM_RESERVE|MEM_COMMIT, PAGE_READWRITE);
+        if (s == nullptr)
+            return nullptr;
+
+        ++m_stats.slabs;
+        m_stats.peak_slabs = max(m_stats.peak_slabs, m_stats.slabs);
+    }
+
+    static const unsigned int header_size =
+        (sizeof(slab) + class_granularity - 1) & ~(class_granularity - 1);
+
+    s->free = nullptr;
+    s->index = unsigned(m_slabs.size());
+    s->size_class = (unsigned short)size_class;
+    s->live = 0;
+    s->carved = header_size;
+    m_slabs.push_back(s);
+
+    link(s);
+    return s;
+}
+
+//------------------------------------------------------------------------------
+void lua_allocator::release_slab(slab* s)
+{
+    slab* last = m_slabs.back();
+    m_slabs[s->index] = last;
+    last->index = s->index;
+    m_slabs.pop_back();
+
+    if (m_spare == nullptr)
+    {
+        m_spare = s;
+        return;
+    }
+
+    VirtualFree(s, 0, MEM_RELEASE);
+    --m_stats.slabs;
+}
+
+//------------------------------------------------------------------------------
+bool lua_allocator::has_room(const slab* s) const
+{
+    unsigned int class_size = (s->size_class + 1) * class_granularity;
+    return (s->free != nullptr || s->carved + class_size <= slab_size);
+}
+
+//------------------------------------------------------------------------------
+void lua_allocator::link(slab* s)
+{
+    slab*& head = m_partial[s->size_class];
+    s->prev = nullptr;
+    s->next = head;
+    if (head != nullptr)
+        head->prev = s;
+    head = s;
+}
+
+//------------------------------------------------------------------------------
+void lua_allocator::unlink(slab* s)
+{
+    if (s->prev != nullptr)
+        s->prev->next = s->next;
+    else
+        m_partial[s->size_class] = s->next;
+
+    if (s->next != nullptr)
+        s->next->prev = s->prev;
+
+    s->next = s->prev = nullptr;
+}
+
+//------------------------------------------------------------------------------
+void lua_allocator::report(str_base& out) const
+{
+    str<280> line;
+    line.format("Allocator: %u allocs (%u from the heap), %u reallocs, %u frees\n",
+        m_stats.allocs, m_stats.heap_allocs, m_stats.reallocs, m_stats.frees);
+    out << line;
+
+    line.format("Allocator: %u KB in use, %u KB peak, %u KB of slabs (%u KB peak)\n\n",
+        m_stats.in_use >> 10, m_stats.peak >> 10, (m_stats.slabs * slab_size) >> 10,
+        (m_stats.peak_slabs * slab_size) >> 10);
+    out << line;
+}
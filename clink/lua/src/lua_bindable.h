@@ -26,6 +26,7 @@ public:
                         lua_bindable(const char* name, const method* methods);
                         ~lua_bindable();
     void                push(lua_State* state);
+    void                release();
 
 private:
     static int          call(lua_State* state);
@@ -100,10 +101,7 @@ void lua_bindable<T>::unbind()
     if (m_state == nullptr || m_registry_ref == LUA_NOREF)
         return;
 
-    lua_rawgeti(m_state, LUA_REGISTRYINDEX, m_registry_ref);
-    if (void* self = lua_touserdata(m_state, -1))
-        *(void**)self = nullptr;
-    lua_pop(m_state, 1);
+    release();
 
     luaL_unref(m_state, LUA_REGISTRYINDEX, m_registry_ref);
     m_registry_ref = LUA_NOREF;
@@ -114,12 +112,33 @@ void lua_bindable<T>::unbind()
 template <class T>
 void lua_bindable<T>::push(lua_State* state)
 {
-    m_state = state;
+    // The Lua object is created once and reused on subsequent pushes.
+    if (m_state != state)
+    {
+        unbind();
+        m_state = state;
+    }
 
     if (m_registry_ref == LUA_NOREF)
         bind();
 
     lua_rawgeti(m_state, LUA_REGISTRYINDEX, m_registry_ref);
+    *(void**)lua_touserdata(m_state, -1) = this;
+}
+
+//------------------------------------------------------------------------------
+template <class T>
+void lua_bindable<T>::release()
+{
+    // Detaches the Lua object so any references Lua holds on to are inert
+    // until the next push().
+    if (m_state == nullptr || m_registry_ref == LUA_NOREF)
+        return;
+
+    lua_rawgeti(m_state, LUA_REGISTRYINDEX, m_registry_ref);
+    if (void* self = lua_touserdata(m_state, -1))
+        *(void**)self = nullptr;
+    lua_pop(m_state, 1);
 }
 
 //------------------------------------------------------------------------------
@@ -3,12 +3,14 @@
 
 #include "pch.h"
 #include "lua_match_generator.h"
+#include "argmatcher_table.h"
 #include "lua_bindable.h"
 #include "lua_script_loader.h"
 #include "lua_state.h"
 #include "line_state_lua.h"
 #include "match_builder_lua.h"
 
+#include <core/base.h>
 #include <lib/line_state.h>
 #include <lib/matches.h>
 
@@ -21,6 +23,8 @@ extern "C" {
 //------------------------------------------------------------------------------
 lua_match_generator::lua_match_generator(lua_state& state)
 : m_state(state)
+, m_line_lua(new line_state_lua())
+, m_builder_lua(new match_builder_lua())
 {
     lua_load_script(m_state, lib, generator);
     lua_load_script(m_state, lib, arguments);
@@ -29,6 +33,8 @@ lua_match_generator::lua_match_generator(lua_state& state)
 //------------------------------------------------------------------------------
 lua_match_generator::~lua_match_generator()
 {
+    delete m_builder_lua;
+    delete m_line_lua;
 }
 
 //------------------------------------------------------------------------------
@@ -48,25 +54,94 @@ bool lua_match_generator::generate(const line_state& line, match_builder& builde
     lua_pushliteral(state, "_generate");
     lua_rawget(state, -2);
 
-    line_state_lua line_lua(line);
-    line_lua.push(state);
+    // The Lua objects wrapping the line and builder persist across calls and
+    // are released afterwards so scripts can't use them once we return.
+    m_line_lua->set_line_state(&line);
+    m_line_lua->push(state);
 
-    match_builder_lua builder_lua(builder);
-    builder_lua.push(state);
+    m_builder_lua->set_builder(&builder);
+    m_builder_lua->push(state);
 
-    if (lua_pcall(state, 2, 1, 0) != 0)
+    int use_matches = 0;
+    if (lua_pcall(state, 2, 1, 0) == 0)
+        use_matches = lua_toboolean(state, -1);
+    else if (const char* error = lua_tostring(state, -1))
+        print_error(error);
+
+    m_builder_lua->release();
+    m_line_lua->release();
+    lua_settop(state, 0);
+
+    return !!use_matches;
+}
+
+//------------------------------------------------------------------------------
+static int get_rule_prefix_length(lua_State* state, const line_state& line)
+{
+    // Calculates the prefix length of the generator table on the top of the
+    // stack from the rule it declared. Returns -1 if Lua needs to be called.
+    lua_pushliteral(state, "_prefixrule");
+    lua_rawget(state, -2);
+    str<16> rule(lua_isstring(state, -1) ? lua_tostring(state, -1) : "");
+    lua_pop(state, 1);
+
+    if (rule.equals("separator") || rule.equals("toggle"))
     {
-        if (const char* error = lua_tostring(state, -1))
-            print_error(error);
+        lua_pushliteral(state, "_prefixchars");
+        lua_rawget(state, -2);
+        str<16> chars(lua_isstring(state, -1) ? lua_tostring(state, -1) : "");
+        lua_pop(state, 1);
+
+        str_iter end_word = line.get_end_word();
+        const char* word = end_word.get_pointer();
+
+        int count = 0;
+        int prefix = 0;
+        for (int i = 0, n = end_word.length(); i < n; ++i)
+        {
+            if (word[i] && strchr(chars.c_str(), word[i]) != nullptr)
+            {
+                ++count;
+                prefix = i + 1;
+            }
+        }
+
+        if (rule.equals("toggle") && !(count & 1))
+            return 0;
+
+        return prefix;
+    }
 
-        lua_settop(state, 0);
-        return false;
+    if (rule.equals("_argmatcher"))
+    {
+        // Argmatchers can only be used natively once they've been compiled.
+        int prefix = -1;
+        lua_pushliteral(state, "_compiled");
+        lua_rawget(state, -2);
+        if (lua_istable(state, -1))
+        {
+            lua_getfield(state, -1, "dirty");
+            bool dirty = !!lua_toboolean(state, -1);
+            lua_getfield(state, -2, "table");
+            auto* table = (argmatcher_table*)luaL_testudata(state, -1, "argmatcher_table_mt");
+            if (!dirty && table != nullptr)
+                prefix = table->get_prefix_length(line);
+            lua_pop(state, 2);
+        }
+        lua_pop(state, 1);
+
+        return prefix;
     }
 
-    int use_matches = lua_toboolean(state, -1);
-    lua_settop(state, 0);
+    if (rule.equals("none"))
+        return 0;
 
-    return !!use_matches;
+    // No rule so the generator's getprefixlength() method is needed, if any.
+    lua_getfield(state, -1, "getprefixlength");
+    bool has_method = lua_isfunction(state, -1);
+    lua_pop(state, 1);
+
+    return has_method ? -1 : 0;
 }
 
 //------------------------------------------------------------------------------
@@ -74,24 +149,59 @@ int lua_match_generator::get_prefix_length(const line_state& line) const
 {
     lua_State* state = m_state.get_state();
 
-    // Call to Lua to calculate prefix length.
     lua_getglobal(state, "clink");
-    lua_pushliteral(state, "_get_prefix_length");
+    lua_pushliteral(state, "_generators");
     lua_rawget(state, -2);
-
-    line_state_lua line_lua(line);
-    line_lua.push(state);
-
-    if (lua_pcall(state, 1, 1, 0) != 0)
+    if (!lua_istable(state, -1))
     {
-        if (const char* error = lua_tostring(state, -1))
-            print_error(error);
-
         lua_settop(state, 0);
         return 0;
     }
 
-    int prefix = int(lua_tointeger(state, -1));
+    // Most generators declare a rule that can be evaluated natively. Only the
+    // ones that don't need a call into Lua.
+    m_line_lua->set_line_state(&line);
+
+    int prefix = 0;
+    for (int i = 1, n = int(lua_rawlen(state, -1)); i <= n; ++i)
+    {
+        lua_rawgeti(state, -1, i);
+
+        int length = get_rule_prefix_length(state, line);
+        if (length < 0)
+        {
+            // Calls are routed through clink._profile() when profiling.
+            int arg_count = 2;
+            if (m_state.get_profiler() != nullptr)
+            {
+                lua_getfield(state, 1, "_profile");
+                lua_pushliteral(state, "getprefixlength");
+                lua_getfield(state, 3, "getprefixlength");
+                arg_count += 3;
+            }
+
+            lua_getfield(state, 3, "getprefixlength");
+            lua_pushvalue(state, 3);
+            m_line_lua->push(state);
+
+            if (lua_pcall(state, arg_count, 1, 0) != 0)
+            {
+                if (const char* error = lua_tostring(state, -1))
+                    print_error(error);
+
+                length = 0;
+            }
+            else
+                length = int(lua_tointeger(state, -1));
+
+            lua_pop(state, 1);
+        }
+
+        prefix = max(prefix, length);
+        lua_pop(state, 1);
+    }
+
+    m_line_lua->release();
     lua_settop(state, 0);
     return prefix;
 }
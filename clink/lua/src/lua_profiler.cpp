@@ -0,0 +1,221 @@
+// Copyright (c) 2016 Martin Ridgers
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "lua_profiler.h"
+#include "lua_allocator.h"
+
+#include <core/base.h>
+#include <core/str.h>
+#include <core/str_hash.h>
+
+#include <algorithm>
+
+//------------------------------------------------------------------------------
+static const int    g_sample_interval = 1000; // VM instructions
+static char         g_registry_key;
+
+//------------------------------------------------------------------------------
+static long long get_ticks()
+{
+    LARGE_INTEGER ticks;
+    QueryPerformanceCounter(&ticks);
+    return ticks.QuadPart;
+}
+
+//------------------------------------------------------------------------------
+static double ticks_to_ms(long long ticks)
+{
+    LARGE_INTEGER freq;
+    QueryPerformanceFrequency(&freq);
+    return (ticks * 1000.0) / double(freq.QuadPart);
+}
+
+
+
+//------------------------------------------------------------------------------
+lua_profiler::lua_profiler(lua_State* state, int mode)
+: m_state(state)
+{
+    // Count allocations by sitting in front of the state's allocator.
+    m_alloc = lua_getallocf(state, &m_alloc_user);
+    lua_setallocf(state, &lua_profiler::alloc, this);
+
+    lua_pushlightuserdata(state, this);
+    lua_rawsetp(state, LUA_REGISTRYINDEX, &g_registry_key);
+
+    lua_getglobal(state, "clink");
+    lua_pushliteral(state, "_profile");
+    lua_pushlightuserdata(state, this);
+    lua_pushcclosure(state, &lua_profiler::profile_call, 1);
+    lua_rawset(state, -3);
+    lua_pop(state, 1);
+
+    if (mode == mode_sampled)
+    {
+        m_last_sample = get_ticks();
+        lua_sethook(state, &lua_profiler::sample_hook, LUA_MASKCOUNT, g_sample_interval);
+    }
+}
+
+//------------------------------------------------------------------------------
+lua_profiler::~lua_profiler()
+{
+    lua_sethook(m_state, nullptr, 0, 0);
+    lua_setallocf(m_state, m_alloc, m_alloc_user);
+
+    lua_pushnil(m_state);
+    lua_rawsetp(m_state, LUA_REGISTRYINDEX, &g_registry_key);
+
+    lua_getglobal(m_state, "clink");
+    if (lua_istable(m_state, -1))
+    {
+        lua_pushliteral(m_state, "_profile");
+        lua_pushnil(m_state);
+        lua_rawset(m_state, -3);
+    }
+    lua_pop(m_state, 1);
+}
+
+//------------------------------------------------------------------------------
+void lua_profiler::reset()
+{
+    m_calls.clear();
+    m_samples.clear();
+    m_strings.clear();
+}
+
+//------------------------------------------------------------------------------
+lua_profiler::entry& lua_profiler::get_entry(entries& list, const char* name)
+{
+    unsigned int hash = str_hash(name);
+    for (auto& iter : list)
+        if (iter.hash == hash && strcmp(&m_strings[iter.name], name) == 0)
+            return iter;
+
+    entry new_entry = { hash, int(m_strings.size()) };
+    m_strings.insert(m_strings.end(), name, name + strlen(name) + 1);
+    list.push_back(new_entry);
+    return list.back();
+}
+
+//------------------------------------------------------------------------------
+void* lua_profiler::alloc(void* user, void* ptr, size_t old_size, size_t new_size)
+{
+    auto* self = (lua_profiler*)user;
+    if (ptr == nullptr && new_size)
+        ++self->m_alloc_count;
+
+    return self->m_alloc(self->m_alloc_user, ptr, old_size, new_size);
+}
+
+//------------------------------------------------------------------------------
+int lua_profiler::profile_call(lua_State* state)
+{
+    // clink._profile(category, id_func, func, ...) calls func(...) and records
+    // the call against 'category' and where 'id_func' is defined.
+    auto* self = (lua_profiler*)lua_touserdata(state, lua_upvalueindex(1));
+
+    // lua_getinfo() with '>' expects a function on the top of the stack.
+    str<280> name;
+    lua_Debug debug;
+    const char* category = lua_isstring(state, 1) ? lua_tostring(state, 1) : "?";
+    if (lua_isfunction(state, 2))
+    {
+        lua_pushvalue(state, 2);
+        if (lua_getinfo(state, ">S", &debug))
+            name.format("%s %s:%d", category, debug.short_src, debug.linedefined);
+        else
+            name = category;
+    }
+    else
+        name = category;
+
+    lua_remove(state, 2);
+
+    unsigned int allocs = self->m_alloc_count;
+    long long start = get_ticks();
+    self->m_last_sample = start;
+
+    int arg_count = lua_gettop(state) - 2;
+    int status = lua_pcall(state, arg_count, LUA_MULTRET, 0);
+
+    entry& call = self->get_entry(self->m_calls, name.c_str());
+    call.ticks += get_ticks() - start;
+    call.allocs += self->m_alloc_count - allocs;
+    ++call.count;
+
+    if (status != LUA_OK)
+        return lua_error(state);
+
+    return lua_gettop(state) - 1;
+}
+
+//------------------------------------------------------------------------------
+void lua_profiler::sample_hook(lua_State* state, lua_Debug* debug)
+{
+    lua_rawgetp(state, LUA_REGISTRYINDEX, &g_registry_key);
+    auto* self = (lua_profiler*)lua_touserdata(state, -1);
+    lua_pop(state, 1);
+    if (self == nullptr || !lua_getinfo(state, "Sl", debug))
+        return;
+
+    // Time since the last sample is attributed to the line that's running now.
+    str<280> name;
+    name.format("%s:%d", debug->short_src, debug->currentline);
+
+    long long now = get_ticks();
+    entry& sample = self->get_entry(self->m_samples, name.c_str());
+    sample.ticks += now - self->m_last_sample;
+    ++sample.count;
+
+    self->m_last_sample = now;
+}
+
+//------------------------------------------------------------------------------
+void lua_profiler::report(str_base& out) const
+{
+    out.clear();
+    report(out, m_calls, "Calls", ~0u);
+    report(out, m_samples, "Samples", 50);
+
+    // The profiler sits in front of the state's allocator.
+    if (!out.empty() && m_alloc == &lua_allocator::alloc)
+        ((const lua_allocator*)m_alloc_user)->report(out);
+}
+
+//------------------------------------------------------------------------------
+void lua_profiler::report(
+    str_base& out,
+    const entries& list,
+    const char* title,
+    unsigned int limit) const
+{
+    if (list.empty())
+        return;
+
+    std::vector<const entry*> sorted;
+    for (const auto& iter : list)
+        sorted.push_back(&iter);
+
+    auto lambda = [] (const entry* a, const entry* b) { return a->ticks > b->ticks; };
+    std::sort(sorted.begin(), sorted.end(), lambda);
+
+    str<280> line;
+    line.format("%-8s %10s %10s %8s  %s\n", title, "Total ms", "Mean ms", "Allocs", "Name");
+    out << line;
+
+    unsigned int count = 0;
+    for (const entry* iter : sorted)
+    {
+        if (count++ >= limit)
+            break;
+
+        double total = ticks_to_ms(iter->ticks);
+        line.format("%8u %10.3f %10.3f %8u  %s\n", iter->count, total,
+            total / max(iter->count, 1u), iter->allocs, &m_strings[iter->name]);
+        out << line;
+    }
+
+    out << "\n";
+}
@@ -3,10 +3,15 @@
 
 #include "pch.h"
 #include "lua_state.h"
+#include "lua_allocator.h"
+#include "lua_profiler.h"
 #include "lua_script_loader.h"
 
-#include <core/settings.h>
+#include <core/base.h>
 #include <core/os.h>
+#include <core/path.h>
+#include <core/settings.h>
+#include <core/str_hash.h>
 
 extern "C" {
 #include <lua.h>
@@ -22,6 +27,23 @@ static setting_bool g_lua_debug(
     "can added by calling pause().",
     false);
 
+static setting_enum g_lua_profile(
+    "lua.profile",
+    "Profiles Lua scripts",
+    "Records the time taken and allocations made by each Lua generator and\n"
+    "prompt filter. The 'sampled' option also periodically samples which\n"
+    "script line is running. Use 'clink profile' to see the results.",
+    "off,calls,sampled",
+    0);
+
+static setting_bool g_lua_pool(
+    "lua.pool_allocator",
+    "Pools Lua's allocations",
+    "Lua's many small and short-lived objects are allocated from pools rather\n"
+    "than from the heap. Statistics on the pools' use are included in the\n"
+    "output of 'clink profile'.",
+    true);
+
 static setting_str g_lua_path(
     "lua.path",
     "'require' search path",
@@ -32,6 +54,40 @@ static setting_str g_lua_path(
 
 
 //------------------------------------------------------------------------------
+struct script_cache_header
+{
+    enum { magic = 0x43626c63 }; // 'clbC'
+
+    unsigned int    m_magic;
+    unsigned int    m_lua_version;
+    unsigned int    m_path_hash;
+    unsigned int    m_path_length;
+    int             m_source_size;
+    unsigned int    m_reserved;     // keeps m_source_time aligned without padding
+    long long       m_source_time;
+
+    bool            operator == (const script_cache_header& rhs) const
+                    {
+                        return (m_magic == rhs.m_magic)
+                            && (m_lua_version == rhs.m_lua_version)
+                            && (m_path_hash == rhs.m_path_hash)
+                            && (m_path_length == rhs.m_path_length)
+                            && (m_source_size == rhs.m_source_size)
+                            && (m_source_time == rhs.m_source_time);
+                    }
+};
+
+//------------------------------------------------------------------------------
+static int script_cache_writer(lua_State* state, const void* data, size_t size, void* user)
+{
+    FILE* out = (FILE*)user;
+    return (fwrite(data, 1, size, out) != size);
+}
+
+
+
+//------------------------------------------------------------------------------
+void argmatcher_lua_initialise(lua_state&);
 void clink_lua_initialise(lua_state&);
 void os_lua_initialise(lua_state&);
 void path_lua_initialise(lua_state&);
@@ -43,6 +99,10 @@ void string_lua_initialise(lua_state&);
 //------------------------------------------------------------------------------
 lua_state::lua_state()
 : m_state(nullptr)
+, m_allocator(nullptr)
+, m_profiler(nullptr)
+, m_cache_hits(0)
+, m_cache_misses(0)
 {
     initialise();
 }
@@ -59,9 +119,21 @@ void lua_state::initialise()
     shutdown();
 
     // Create a new Lua state.
-    m_state = luaL_newstate();
+    if (g_lua_pool.get())
+    {
+        m_allocator = new lua_allocator();
+        m_state = lua_newstate(&lua_allocator::alloc, m_allocator);
+    }
+    else
+        m_state = luaL_newstate();
+
     luaL_openlibs(m_state);
 
+    // Completion makes a burst of garbage that's mostly gone by the next one.
+    // Letting the heap grow further before collecting means most bursts pass
+    // without having to run a collection cycle in the middle of them.
+    lua_gc(m_state, LUA_GCSETPAUSE, 400);
+
     // Set up the package.path value for require() statements.
     str<280> path;
     if (!os::get_env("lua_path_" LUA_VERSION_MAJOR "_" LUA_VERSION_MINOR, path))
@@ -90,10 +162,14 @@ void lua_state::initialise()
         lua_load_script(self, lib, debugger);
 
     clink_lua_initialise(self);
+    argmatcher_lua_initialise(self);
     os_lua_initialise(self);
     path_lua_initialise(self);
     settings_lua_initialise(self);
     string_lua_initialise(self);
+
+    if (int profile = g_lua_profile.get())
+        m_profiler = new lua_profiler(m_state, profile);
 }
 
 //------------------------------------------------------------------------------
@@ -102,8 +178,14 @@ void lua_state::shutdown()
     if (m_state == nullptr)
         return;
 
+    delete m_profiler;
+    m_profiler = nullptr;
+
     lua_close(m_state);
     m_state = nullptr;
+
+    delete m_allocator;
+    m_allocator = nullptr;
 }
 
 //------------------------------------------------------------------------------
@@ -125,13 +207,104 @@ bool lua_state::do_string(const char* string, int length)
 }
 
 //------------------------------------------------------------------------------
-bool lua_state::do_file(const char* path)
+bool lua_state::do_file(const char* path, const char* cache_dir)
 {
     bool failed;
-    if (failed = !!luaL_dofile(m_state, path))
+    if (cache_dir != nullptr && *cache_dir)
+        failed = !load_cached_file(path, cache_dir);
+    else
+        failed = !!luaL_loadfile(m_state, path);
+
+    if (!failed)
+        failed = !!lua_pcall(m_state, 0, LUA_MULTRET, 0);
+
+    if (failed)
         if (const char* error = lua_tostring(m_state, -1))
             puts(error);
 
     lua_settop(m_state, 0);
     return !failed;
 }
+
+//------------------------------------------------------------------------------
+bool lua_state::load_cached_file(const char* path, const char* cache_dir)
+{
+    // Scripts' compiled bytecode is cached in 'cache_dir' in a file named after
+    // a hash of the script's path. The cache is valid if the header matches and
+    // the full path that follows it is the same (in case two paths collide).
+    unsigned int path_length = unsigned(strlen(path));
+    script_cache_header header = {
+        script_cache_header::magic,
+        LUA_VERSION_NUM,
+        str_hash(path),
+        path_length,
+        os::get_file_size(path),
+        0,
+        os::get_file_time(path),
+    };
+
+    str<16> cache_name;
+    cache_name.format("%08x.luac", header.m_path_hash);
+
+    str<280> cache_path;
+    path::join(cache_dir, cache_name.c_str(), cache_path);
+
+    // Try and load the bytecode from the cache.
+    if (FILE* in = fopen(cache_path.c_str(), "rb"))
+    {
+        fseek(in, 0, SEEK_END);
+        int size = int(ftell(in)) - int(sizeof(header) + path_length);
+        fseek(in, 0, SEEK_SET);
+
+        bool loaded = false;
+        script_cache_header cached_header;
+        if (size > 0 && fread(&cached_header, sizeof(cached_header), 1, in) == 1)
+        {
+            if (cached_header == header)
+            {
+                char* buffer = (char*)malloc(max(size, int(path_length)));
+                if (fread(buffer, path_length, 1, in) == 1
+                    && !memcmp(buffer, path, path_length)
+                    && fread(buffer, size, 1, in) == 1)
+                {
+                    str<280> chunk_name;
+                    chunk_name << "@" << path;
+                    loaded = !luaL_loadbufferx(m_state, buffer, size, chunk_name.c_str(), "b");
+                    if (!loaded)
+                        lua_pop(m_state, 1);
+                }
+                free(buffer);
+            }
+        }
+
+        fclose(in);
+
+        if (loaded)
+        {
+            ++m_cache_hits;
+            return true;
+        }
+    }
+
+    // Not in the cache so compile the source and write the bytecode out.
+    ++m_cache_misses;
+    if (luaL_loadfile(m_state, path))
+        return false;
+
+    if (header.m_source_size < 0 || header.m_source_time < 0)
+        return true;
+
+    os::make_dir(cache_dir);
+    if (FILE* out = fopen(cache_path.c_str(), "wb"))
+    {
+        bool ok = (fwrite(&header, sizeof(header), 1, out) == 1);
+        ok = ok && (fwrite(path, path_length, 1, out) == 1);
+        ok = ok && !lua_dump(m_state, script_cache_writer, out);
+        fclose(out);
+
+        if (!ok)
+            os::unlink(cache_path.c_str());
+    }
+
+    return true;
+}
@@ -5,13 +5,22 @@
 #include "match_builder_lua.h"
 
 #include <core/base.h>
+#include <core/globber.h>
+#include <core/path.h>
+#include <core/settings.h>
 #include <core/str.h>
 #include <lib/matches.h>
 
+//------------------------------------------------------------------------------
+extern setting_bool g_glob_hidden;
+extern setting_bool g_glob_system;
+extern setting_bool g_glob_unc;
+
 //------------------------------------------------------------------------------
 static match_builder_lua::method g_methods[] = {
     { "addmatch",           &match_builder_lua::add_match },
     { "addmatches",         &match_builder_lua::add_matches },
+    { "addglob",            &match_builder_lua::add_glob },
     { "setprefixincluded",  &match_builder_lua::set_prefix_included },
     {}
 };
@@ -19,7 +28,7 @@ static match_builder_lua::method g_methods[] = {
 
 
 //------------------------------------------------------------------------------
-match_builder_lua::match_builder_lua(match_builder& builder)
+match_builder_lua::match_builder_lua(match_builder* builder)
 : lua_bindable<match_builder_lua>("match_builder_lua", g_methods)
 , m_builder(builder)
 {
@@ -30,6 +39,12 @@ match_builder_lua::~match_builder_lua()
 {
 }
 
+//------------------------------------------------------------------------------
+void match_builder_lua::set_builder(match_builder* builder)
+{
+    m_builder = builder;
+}
+
 //------------------------------------------------------------------------------
 /// -name:  builder:addmatch
 /// -arg:   match:string|table
@@ -53,20 +68,32 @@ int match_builder_lua::set_prefix_included(lua_State* state)
     if (lua_gettop(state) > 0)
         included = (lua_toboolean(state, 1) != 0);
 
-    m_builder.set_prefix_included(included);
+    m_builder->set_prefix_included(included);
 
     return 0;
 }
 
 //------------------------------------------------------------------------------
 /// -name:  builder:addmatches
-/// -arg:   matches:table
+/// -arg:   matches:table|string
+/// -arg:   [suffix:string]
 /// -ret:   integer, boolean
+/// -show:  builder:addmatches(io.popen("git tag"):read("*a"))
 /// This is the equivalent of calling builder:addmatch() in a for-loop. Returns
 /// the number of matches added and a boolean indicating if all matches were
-/// added successfully.
+/// added successfully. If 'suffix' is given it is used as the suffix of any
+/// matches that are plain strings. 'matches' can also be a single string of
+/// newline separated matches, which is the quickest way to add a large number
+/// of them as no Lua string or table is made for each one.
 int match_builder_lua::add_matches(lua_State* state)
 {
+    char suffix = 0;
+    if (lua_isstring(state, 2))
+        suffix = lua_tostring(state, 2)[0];
+
+    if (lua_type(state, 1) == LUA_TSTRING)
+        return add_packed_matches(state, suffix);
+
     if (lua_gettop(state) <= 0 || !lua_istable(state, 1))
     {
         lua_pushinteger(state, 0);
@@ -74,12 +101,21 @@ int match_builder_lua::add_matches(lua_State* state)
         return 2;
     }
 
+    // Plain strings are by far the most common entry so they're added directly
+    // rather than going through the more general add_match_impl().
     int count = 0;
     int total = int(lua_rawlen(state, 1));
     for (int i = 1; i <= total; ++i)
     {
         lua_rawgeti(state, 1, i);
-        count += !!add_match_impl(state, -1);
+        if (lua_type(state, -1) == LUA_TSTRING)
+        {
+            match_desc desc = { lua_tostring(state, -1) };
+            desc.suffix = suffix;
+            count += !!m_builder->add_match(desc);
+        }
+        else
+            count += !!add_match_impl(state, -1);
         lua_pop(state, 1);
     }
 
@@ -88,13 +124,114 @@ int match_builder_lua::add_matches(lua_State* state)
     return 2;
 }
 
+//------------------------------------------------------------------------------
+int match_builder_lua::add_packed_matches(lua_State* state, char suffix)
+{
+    size_t length;
+    const char* packed = lua_tolstring(state, 1, &length);
+    const char* end = packed + length;
+
+    // Each line is a match. Empty lines and a '\r' before the '\n' are skipped.
+    int count = 0;
+    int total = 0;
+    str<288> match;
+    for (const char* c = packed; c < end;)
+    {
+        const char* line_end = (const char*)memchr(c, '\n', end - c);
+        if (line_end == nullptr)
+            line_end = end;
+
+        const char* next = line_end + 1;
+        if (line_end > c && line_end[-1] == '\r')
+            --line_end;
+
+        if (line_end > c)
+        {
+            match.clear();
+            match.concat(c, int(line_end - c));
+
+            match_desc desc = { match.c_str() };
+            desc.suffix = suffix;
+            count += !!m_builder->add_match(desc);
+            ++total;
+        }
+
+        c = next;
+    }
+
+    lua_pushinteger(state, count);
+    lua_pushboolean(state, count == total);
+    return 2;
+}
+
+//------------------------------------------------------------------------------
+/// -name:  builder:addglob
+/// -arg:   dirs:table
+/// -arg:   patterns:table
+/// -ret:   integer
+/// -show:  builder:addglob(os.getenvlist("path"), { "*.exe", "*.bat" })
+/// Adds what os.globfiles() finds for each of 'patterns' in each of 'dirs' as
+/// matches. This is much quicker than calling os.globfiles() for each pattern
+/// and directory and adding the results. Returns the number of matches added.
+int match_builder_lua::add_glob(lua_State* state)
+{
+    if (!lua_istable(state, 1) || !lua_istable(state, 2))
+    {
+        lua_pushinteger(state, 0);
+        return 1;
+    }
+
+    bool glob_unc = g_glob_unc.get();
+    bool glob_hidden = g_glob_hidden.get();
+    bool glob_system = g_glob_system.get();
+
+    int count = 0;
+    str<288> mask;
+    str<288> file;
+    int dir_count = int(lua_rawlen(state, 1));
+    int pattern_count = int(lua_rawlen(state, 2));
+    for (int i = 1; i <= pattern_count; ++i)
+    {
+        lua_rawgeti(state, 2, i);
+        const char* pattern = lua_tostring(state, -1);
+
+        for (int j = 1; pattern != nullptr && j <= dir_count; ++j)
+        {
+            lua_rawgeti(state, 1, j);
+            const char* dir = lua_tostring(state, -1);
+            if (dir != nullptr)
+            {
+                mask.clear();
+                path::join(dir, pattern, mask);
+
+                const char* c = mask.c_str();
+                if (glob_unc || !path::is_separator(c[0]) || !path::is_separator(c[1]))
+                {
+                    globber globber(mask.c_str());
+                    globber.hidden(glob_hidden);
+                    globber.system(glob_system);
+
+                    while (globber.next(file, false))
+                        count += !!m_builder->add_match(file.c_str());
+                }
+            }
+            lua_pop(state, 1);
+        }
+
+        lua_pop(state, 1);
+    }
+
+    lua_pushinteger(state, count);
+    return 1;
+}
+
 //------------------------------------------------------------------------------
 bool match_builder_lua::add_match_impl(lua_State* state, int stack_index)
 {
     if (lua_isstring(state, stack_index))
     {
         const char* match = lua_tostring(state, stack_index);
-        return m_builder.add_match(match);
+        return m_builder->add_match(match);
     }
     else if (lua_istable(state, stack_index))
     {
@@ -128,7 +265,7 @@ bool match_builder_lua::add_match_impl(lua_State* state, int stack_index)
         lua_pop(state, 1);
 
         if (desc.match != nullptr)
-            return m_builder.add_match(desc);
+            return m_builder->add_match(desc);
     }
 
     return false;
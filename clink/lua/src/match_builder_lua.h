@@ -13,13 +13,16 @@ class match_builder_lua
     : public lua_bindable<match_builder_lua>
 {
 public:
-                    match_builder_lua(match_builder& builder);
+                    match_builder_lua(match_builder* builder=nullptr);
                     ~match_builder_lua();
+    void            set_builder(match_builder* builder);
     int             add_match(lua_State* state);
     int             add_matches(lua_State* state);
+    int             add_glob(lua_State* state);
     int             set_prefix_included(lua_State* state);
 
 private:
     bool            add_match_impl(lua_State* state, int stack_index);
-    match_builder&  m_builder;
+    int             add_packed_matches(lua_State* state, char suffix);
+    match_builder*  m_builder;
 };
@@ -10,6 +10,7 @@
 #include <core/path.h>
 #include <core/settings.h>
 #include <core/str.h>
+#include <core/str_tokeniser.h>
 #include <process/process.h>
 
 //------------------------------------------------------------------------------
@@ -17,6 +18,8 @@ extern setting_bool g_glob_hidden;
 extern setting_bool g_glob_system;
 extern setting_bool g_glob_unc;
 
+static char g_env_list_key;
+
 
 
 //------------------------------------------------------------------------------
@@ -290,6 +293,91 @@ static int get_env_names(lua_State* state)
     return 1;
 }
 
+//------------------------------------------------------------------------------
+/// -name:  os.getenvlist
+/// -arg:   name:string
+/// -ret:   table
+/// -show:  for _, dir in ipairs(os.getenvlist("path")) do print(dir) end
+/// Returns the ';'-separated parts of the environment variable 'name' in a
+/// table. Empty parts are skipped and surrounding quotes are removed. The table
+/// is cached and the same one is returned until the variable's value changes
+/// so it must not be modified.
+static int get_env_list(lua_State* state)
+{
+    const char* name = get_string(state, 1);
+    if (name == nullptr)
+        return 0;
+
+    str<> value;
+    os::get_env(name, value);
+
+    // The cache lives in the registry as { [name] = { value, list } }.
+    lua_rawgetp(state, LUA_REGISTRYINDEX, &g_env_list_key);
+    if (lua_isnil(state, -1))
+    {
+        lua_pop(state, 1);
+        lua_createtable(state, 0, 0);
+        lua_pushvalue(state, -1);
+        lua_rawsetp(state, LUA_REGISTRYINDEX, &g_env_list_key);
+    }
+
+    int cache_index = lua_gettop(state);
+    lua_pushvalue(state, 1);
+    lua_rawget(state, cache_index);
+    if (lua_istable(state, -1))
+    {
+        size_t cached_length;
+        lua_rawgeti(state, -1, 1);
+        const char* cached = lua_tolstring(state, -1, &cached_length);
+        bool unchanged = (cached_length == value.length());
+        unchanged = unchanged && (memcmp(cached, value.c_str(), cached_length) == 0);
+        lua_pop(state, 1);
+
+        if (unchanged)
+        {
+            lua_rawgeti(state, -1, 2);
+            return 1;
+        }
+    }
+    lua_pop(state, 1);
+
+    // Split the value up and cache it.
+    lua_createtable(state, 2, 0);
+    lua_pushlstring(state, value.c_str(), value.length());
+    lua_rawseti(state, -2, 1);
+
+    lua_createtable(state, 16, 0);
+
+    str_tokeniser tokens(value.c_str(), ";");
+    tokens.add_quote_pair("\"");
+
+    int count = 0;
+    const char* start;
+    int length;
+    while (tokens.next(start, length))
+    {
+        if (length >= 2 && start[0] == '"' && start[length - 1] == '"')
+        {
+            ++start;
+            length -= 2;
+        }
+
+        if (length <= 0)
+            continue;
+
+        lua_pushlstring(state, start, length);
+        lua_rawseti(state, -2, ++count);
+    }
+
+    lua_pushvalue(state, -1);
+    lua_rawseti(state, -3, 2);
+
+    lua_pushvalue(state, 1);
+    lua_pushvalue(state, -3);
+    lua_rawset(state, cache_index);
+    return 1;
+}
+
 //------------------------------------------------------------------------------
 /// -name:  os.gethost
 /// -ret:   string
@@ -347,6 +435,191 @@ static int get_aliases(lua_State* state)
     return 1;
 }
 
+//------------------------------------------------------------------------------
+// Returns the last time the file at 'path' was written to as an opaque string
+// that's only suitable for comparing, or nil if the file doesn't exist. It's a
+// string because a lua_Number can't hold all 64 bits of the time, and Lua
+// formats numbers with %.14g when they're turned into strings.
+static int get_file_time(lua_State* state)
+{
+    const char* path = get_string(state, 1);
+    if (path == nullptr)
+        return 0;
+
+    long long time = os::get_file_time(path);
+    if (time < 0)
+        return 0;
+
+    str<32> time_str;
+    time_str.format("%lld", time);
+    lua_pushstring(state, time_str.c_str());
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+// A spawned process's output file can still be open when the process object is
+// collected; a script may be reading it, or the file's own __gc may not have
+// run yet. Deleting it would then fail, so failed deletes are kept here and are
+// tried again each time a process is spawned or collected, and at exit.
+class output_deleter
+{
+public:
+                    ~output_deleter() { retry(); }
+    void            remove(const wchar_t* path);
+    void            retry();
+
+private:
+    enum { max_pending = 16 };
+    wchar_t         m_pending[max_pending][MAX_PATH];
+    int             m_count = 0;
+};
+
+static output_deleter g_output_deleter;
+
+//------------------------------------------------------------------------------
+void output_deleter::remove(const wchar_t* path)
+{
+    retry();
+
+    if (DeleteFileW(path) || GetLastError() == ERROR_FILE_NOT_FOUND)
+        return;
+
+    if (m_count < max_pending)
+        wcscpy(m_pending[m_count++], path);
+}
+
+//------------------------------------------------------------------------------
+void output_deleter::retry()
+{
+    for (int i = 0; i < m_count;)
+    {
+        if (!DeleteFileW(m_pending[i]) && GetLastError() != ERROR_FILE_NOT_FOUND)
+        {
+            ++i;
+            continue;
+        }
+
+        if (i != --m_count)
+            wcscpy(m_pending[i], m_pending[m_count]);
+    }
+}
+
+
+
+//------------------------------------------------------------------------------
+struct spawned_process
+{
+    HANDLE          handle;
+    wchar_t         output_path[MAX_PATH];
+};
+
+//------------------------------------------------------------------------------
+static spawned_process* check_spawned(lua_State* state)
+{
+    return (spawned_process*)luaL_checkudata(state, 1, "spawned_process_mt");
+}
+
+//------------------------------------------------------------------------------
+static int spawned_is_done(lua_State* state)
+{
+    spawned_process* spawned = check_spawned(state);
+    DWORD wait = WaitForSingleObject(spawned->handle, 0);
+    lua_pushboolean(state, (wait != WAIT_TIMEOUT));
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+static int spawned_get_output_path(lua_State* state)
+{
+    spawned_process* spawned = check_spawned(state);
+    str<288> path(spawned->output_path);
+    lua_pushstring(state, path.c_str());
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+static int spawned_gc(lua_State* state)
+{
+    auto* spawned = (spawned_process*)lua_touserdata(state, 1);
+    CloseHandle(spawned->handle);
+    g_output_deleter.remove(spawned->output_path);
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+// Runs 'command' via the command processor without waiting for it to finish.
+// The command's stdout is written to a temporary file. Returns an object with
+// isdone() and getoutputpath() methods, or nil if the process wasn't started.
+static int spawn(lua_State* state)
+{
+    const char* command = get_string(state, 1);
+    if (command == nullptr)
+        return 0;
+
+    g_output_deleter.retry();
+
+    wchar_t temp_dir[MAX_PATH];
+    wchar_t output_path[MAX_PATH];
+    if (!GetTempPathW(sizeof_array(temp_dir), temp_dir) ||
+        !GetTempFileNameW(temp_dir, L"clk", 0, output_path))
+        return 0;
+
+    SECURITY_ATTRIBUTES sa = { sizeof(sa), nullptr, TRUE };
+    HANDLE output = CreateFileW(output_path, GENERIC_WRITE,
+        FILE_SHARE_READ|FILE_SHARE_WRITE|FILE_SHARE_DELETE, &sa, CREATE_ALWAYS,
+        FILE_ATTRIBUTE_TEMPORARY, nullptr);
+    if (output == INVALID_HANDLE_VALUE)
+    {
+        g_output_deleter.remove(output_path);
+        return 0;
+    }
+
+    str<288> comspec;
+    if (!os::get_env("comspec", comspec))
+        comspec = "cmd.exe";
+
+    str<> command_line;
+    command_line << "\"" << comspec.c_str() << "\" /d /c \"" << command << "\"";
+    wstr<> wcommand_line(command_line.c_str());
+
+    STARTUPINFOW si = { sizeof(si) };
+    si.dwFlags = STARTF_USESTDHANDLES;
+    si.hStdOutput = output;
+    si.hStdError = GetStdHandle(STD_ERROR_HANDLE);
+
+    PROCESS_INFORMATION pi;
+    BOOL ok = CreateProcessW(nullptr, wcommand_line.data(), nullptr, nullptr,
+        TRUE, CREATE_NO_WINDOW, nullptr, nullptr, &si, &pi);
+    CloseHandle(output);
+    if (!ok)
+    {
+        g_output_deleter.remove(output_path);
+        return 0;
+    }
+
+    CloseHandle(pi.hThread);
+
+    auto* spawned = (spawned_process*)lua_newuserdata(state, sizeof(spawned_process));
+    spawned->handle = pi.hProcess;
+    wcscpy(spawned->output_path, output_path);
+
+    if (luaL_newmetatable(state, "spawned_process_mt"))
+    {
+        lua_createtable(state, 0, 0);
+        lua_pushcfunction(state, &spawned_is_done);
+        lua_setfield(state, -2, "isdone");
+        lua_pushcfunction(state, &spawned_get_output_path);
+        lua_setfield(state, -2, "getoutputpath");
+        lua_setfield(state, -2, "__index");
+
+        lua_pushcfunction(state, &spawned_gc);
+        lua_setfield(state, -2, "__gc");
+    }
+
+    lua_setmetatable(state, -2);
+    return 1;
+}
+
 //------------------------------------------------------------------------------
 void os_lua_initialise(lua_state& lua)
 {
@@ -354,22 +627,25 @@ void os_lua_initialise(lua_state& lua)
         const char* name;
         int         (*method)(lua_State*);
     } methods[] = {
-        { "chdir",       &set_current_dir },
-        { "getcwd",      &get_current_dir },
-        { "mkdir",       &make_dir },
-        { "rmdir",       &remove_dir },
-        { "isdir",       &is_dir },
-        { "isfile",      &is_file },
-        { "unlink",      &unlink },
-        { "move",        &move },
-        { "copy",        &copy },
-        { "globdirs",    &glob_dirs },
-        { "globfiles",   &glob_files },
-        { "getenv",      &get_env },
-        { "setenv",      &set_env },
-        { "getenvnames", &get_env_names },
-        { "gethost",     &get_host },
-        { "getaliases",  &get_aliases },
+        { "chdir",        &set_current_dir },
+        { "getcwd",       &get_current_dir },
+        { "mkdir",        &make_dir },
+        { "rmdir",        &remove_dir },
+        { "isdir",        &is_dir },
+        { "isfile",       &is_file },
+        { "unlink",       &unlink },
+        { "move",         &move },
+        { "copy",         &copy },
+        { "globdirs",     &glob_dirs },
+        { "globfiles",    &glob_files },
+        { "getenv",       &get_env },
+        { "setenv",       &set_env },
+        { "getenvnames",  &get_env_names },
+        { "getenvlist",   &get_env_list },
+        { "gethost",      &get_host },
+        { "getaliases",   &get_aliases },
+        { "_spawn",       &spawn },
+        { "_getfiletime", &get_file_time },
     };
 
     lua_State* state = lua.get_state();
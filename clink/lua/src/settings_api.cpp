@@ -9,6 +9,60 @@
 
 #include <new.h>
 
+//------------------------------------------------------------------------------
+static char g_handles_key;
+
+//------------------------------------------------------------------------------
+static setting* find_setting(lua_State* state, int index)
+{
+    // Settings found by name are cached in a table keyed by the name. Names are
+    // interned Lua strings so later lookups of the same name are just a table
+    // lookup. The cache is dropped if settings are added or removed.
+    unsigned int generation = settings::get_generation();
+
+    lua_rawgetp(state, LUA_REGISTRYINDEX, &g_handles_key);
+    if (lua_istable(state, -1))
+    {
+        lua_rawgeti(state, -1, 0);
+        bool stale = (lua_Integer(generation) != lua_tointeger(state, -1));
+        lua_pop(state, 1);
+
+        if (stale)
+        {
+            lua_pop(state, 1);
+            lua_pushnil(state);
+        }
+    }
+
+    if (lua_isnil(state, -1))
+    {
+        lua_pop(state, 1);
+        lua_createtable(state, 0, 16);
+        lua_pushinteger(state, lua_Integer(generation));
+        lua_rawseti(state, -2, 0);
+        lua_pushvalue(state, -1);
+        lua_rawsetp(state, LUA_REGISTRYINDEX, &g_handles_key);
+    }
+
+    lua_pushvalue(state, index);
+    lua_rawget(state, -2);
+    auto* ret = (setting*)lua_touserdata(state, -1);
+    lua_pop(state, 1);
+
+    if (ret == nullptr)
+    {
+        if (ret = settings::find(lua_tostring(state, index)))
+        {
+            lua_pushvalue(state, index);
+            lua_pushlightuserdata(state, ret);
+            lua_rawset(state, -3);
+        }
+    }
+
+    lua_pop(state, 1);
+    return ret;
+}
+
 //------------------------------------------------------------------------------
 /// -name:  settings.get
 /// -arg:   name:string
@@ -18,8 +72,7 @@ static int get(lua_State* state)
     if (lua_gettop(state) == 0 || !lua_isstring(state, 1))
         return 0;
 
-    const char* key = lua_tostring(state, 1);
-    const setting* setting = settings::find(key);
+    const setting* setting = find_setting(state, 1);
     if (setting == nullptr)
         return 0;
 
@@ -62,8 +115,7 @@ static int set(lua_State* state)
     if (lua_gettop(state) < 2 || !lua_isstring(state, 1))
         return 0;
 
-    const char* key = lua_tostring(state, 1);
-    setting* setting = settings::find(key);
+    setting* setting = find_setting(state, 1);
     if (setting == nullptr)
         return 0;
 
@@ -0,0 +1,117 @@
+// Copyright (c) 2016 Martin Ridgers
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+
+#include <lua/lua_allocator.h>
+
+#include <vector>
+
+extern "C" {
+#include <lua.h>
+#include <lauxlib.h>
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("Lua allocator")
+{
+    lua_allocator allocator;
+    const lua_allocator::stats& stats = allocator.get_stats();
+
+    auto alloc = [&] (void* ptr, int old_size, int new_size) {
+        return lua_allocator::alloc(&allocator, ptr, old_size, new_size);
+    };
+
+    SECTION("Pooled")
+    {
+        void* a = alloc(nullptr, LUA_TTABLE, 10);
+        void* b = alloc(nullptr, LUA_TSTRING, 20);
+        REQUIRE(a != nullptr);
+        REQUIRE(b != nullptr);
+        REQUIRE(a != b);
+        REQUIRE(stats.allocs == 2);
+        REQUIRE(stats.slabs == 2);
+        REQUIRE(stats.heap_allocs == 0);
+        REQUIRE(stats.in_use == 30);
+
+        // Freed blocks are reused by the next allocation in the same class.
+        alloc(a, 10, 0);
+        REQUIRE(alloc(nullptr, LUA_TTABLE, 16) == a);
+        REQUIRE(stats.frees == 1);
+
+        // Staying within a size class doesn't move the block.
+        REQUIRE(alloc(b, 20, 32) == b);
+
+        // But moving up a class does, and the contents move with it.
+        memset(b, 0x5a, 32);
+        void* c = alloc(b, 32, 100);
+        REQUIRE(c != b);
+        REQUIRE(((unsigned char*)c)[31] == 0x5a);
+        REQUIRE(stats.reallocs == 2);
+        REQUIRE(stats.in_use == 116);
+        REQUIRE(stats.peak == 116);
+    }
+
+    SECTION("Heap")
+    {
+        void* a = alloc(nullptr, LUA_TTABLE, 4096);
+        REQUIRE(a != nullptr);
+        REQUIRE(stats.heap_allocs == 1);
+        REQUIRE(stats.slabs == 0);
+
+        // Shrinking into the pools' range moves the block out of the heap.
+        memset(a, 0x5a, 4096);
+        void* b = alloc(a, 4096, 64);
+        REQUIRE(((unsigned char*)b)[63] == 0x5a);
+        REQUIRE(stats.slabs == 1);
+
+        alloc(b, 64, 0);
+        REQUIRE(stats.in_use == 0);
+        REQUIRE(stats.peak == 4096);
+    }
+
+    SECTION("Released")
+    {
+        // Enough blocks to need several slabs.
+        std::vector<void*> blocks;
+        for (int i = 0; i < 20000; ++i)
+            blocks.push_back(alloc(nullptr, LUA_TSTRING, 24));
+
+        REQUIRE(stats.slabs > 2);
+        REQUIRE(stats.peak_slabs == stats.slabs);
+
+        // Empty slabs go back to the system, bar the one kept spare.
+        for (void* block : blocks)
+            alloc(block, 24, 0);
+
+        REQUIRE(stats.in_use == 0);
+        REQUIRE(stats.slabs == 1);
+        REQUIRE(stats.peak_slabs > 2);
+
+        // And the spare is what's used next.
+        alloc(nullptr, LUA_TTABLE, 64);
+        REQUIRE(stats.slabs == 1);
+    }
+
+    SECTION("Lua state")
+    {
+        lua_State* state = lua_newstate(&lua_allocator::alloc, &allocator);
+        REQUIRE(state != nullptr);
+        REQUIRE(stats.in_use != 0);
+
+        // Many small tables and strings, much like generating matches makes.
+        // Each of these was a CRT heap allocation before the pools.
+        const char* script =
+            "local t = {}"
+            "for i = 1, 2000 do t[i] = { i .. '_match', n = i } end";
+        REQUIRE(luaL_loadstring(state, script) == LUA_OK);
+        REQUIRE(lua_pcall(state, 0, 0, 0) == LUA_OK);
+
+        REQUIRE(stats.allocs > 4000);
+        REQUIRE(stats.heap_allocs * 100 < stats.allocs);
+
+        lua_close(state);
+        REQUIRE(stats.in_use == 0);
+        REQUIRE(stats.allocs == stats.frees);
+    }
+}
@@ -417,6 +417,10 @@ TEST_CASE("Lua arg parsers.")
             :setflagprefix()\
             :addflags('-oa', '-ob', '-oc')\
             :addarg('-od', '-oe', '-of')\
+            \
+            clink.argmatcher('argcmd_flags_m')\
+            :setflagprefix('-', '/', '+', '~', '!', '@', '#', '%', '^')\
+            :addflags('^one', '^two')\
         ";
 
         REQUIRE(lua.do_string(script));
@@ -520,6 +524,13 @@ TEST_CASE("Lua arg parsers.")
             tester.set_expected_matches("-od", "-oe", "-of");
             tester.run();
         }
+
+        SECTION("Many prefixes")
+        {
+            tester.set_input("argcmd_flags_m ^");
+            tester.set_expected_matches("^one", "^two");
+            tester.run();
+        }
     }
 
     SECTION("Skip")
@@ -645,4 +656,41 @@ TEST_CASE("Lua arg parsers.")
             tester.run();
         }
     }
+
+    SECTION("Changes after use")
+    {
+        const char* script = "\
+            p = clink.argmatcher('argcmd_changes'):addarg('one', 'two')\
+        ";
+
+        REQUIRE(lua.do_string(script));
+
+        tester.set_input("argcmd_changes t");
+        tester.set_expected_matches("two");
+        tester.run();
+
+        SECTION("Add argument")
+        {
+            REQUIRE(lua.do_string("p:addarg('three', 'four')"));
+            tester.set_input("argcmd_changes two t");
+            tester.set_expected_matches("three");
+            tester.run();
+        }
+
+        SECTION("Add link")
+        {
+            REQUIRE(lua.do_string("p:addarg('tree' .. clink.argmatcher():addarg('leaf'))"));
+            tester.set_input("argcmd_changes two tree l");
+            tester.set_expected_matches("leaf");
+            tester.run();
+        }
+
+        SECTION("Add command")
+        {
+            REQUIRE(lua.do_string("clink.argmatcher('argcmd_changes_2'):addarg('three')"));
+            tester.set_input("argcmd_changes_2 t");
+            tester.set_expected_matches("three");
+            tester.run();
+        }
+    }
 }
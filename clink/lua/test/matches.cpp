@@ -0,0 +1,94 @@
+// Copyright (c) 2018 Martin Ridgers
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+
+#include <core/array.h>
+#include <core/str.h>
+#include <lib/line_state.h>
+#include <lib/matches.h>
+#include <lua/lua_match_generator.h>
+#include <lua/lua_state.h>
+
+#include "match_pipeline.h"
+#include "matches_impl.h"
+
+extern "C" {
+#include <lua.h>
+}
+
+//------------------------------------------------------------------------------
+static int get_global_int(lua_state& lua, const char* name)
+{
+    lua_State* state = lua.get_state();
+    lua_getglobal(state, name);
+    int ret = int(lua_tointeger(state, -1));
+    lua_pop(state, 1);
+    return ret;
+}
+
+
+
+//------------------------------------------------------------------------------
+TEST_CASE("Lua bulk matches")
+{
+    lua_state lua;
+    lua_match_generator lua_generator(lua);
+
+    // Both forms of addmatches() are given 10,000 matches numbered in order.
+    const char* script = "\
+        bulk_generator = clink.generator(1)\
+        function bulk_generator:generate(line_state, match_builder)\
+            bulk_count, bulk_ok = match_builder:addmatches(bulk_matches, '/')\
+            return true\
+        end\
+        \
+        bulk_table = {}\
+        for i = 1, 10000 do\
+            bulk_table[i] = string.format('%05d', i)\
+        end\
+        bulk_packed = table.concat(bulk_table, '\\n')\
+    ";
+
+    REQUIRE(lua.do_string(script));
+
+    SECTION("Table")
+    {
+        REQUIRE(lua.do_string("bulk_matches = bulk_table"));
+    }
+
+    SECTION("Packed")
+    {
+        REQUIRE(lua.do_string("bulk_matches = bulk_packed"));
+    }
+
+    SECTION("Packed CRLF")
+    {
+        REQUIRE(lua.do_string("bulk_matches = bulk_packed:gsub('\\n', '\\r\\n') .. '\\r\\n'"));
+    }
+
+    word end_word = {};
+    array<word> words(&end_word, 1);
+    line_state line = { "", 0, 0, words };
+
+    matches_impl matches(0x40000);
+    match_pipeline pipeline(matches);
+    pipeline.reset();
+
+    match_generator* generators[] = { &lua_generator };
+    pipeline.generate(line, array<match_generator*>(generators, 1));
+    pipeline.select("");
+
+    REQUIRE(get_global_int(lua, "bulk_count") == 10000);
+    REQUIRE(lua.do_string("assert(bulk_ok)"));
+    REQUIRE(matches.get_match_count() == 10000);
+
+    // Matches are in the order they were given, each with the suffix.
+    str<16> expected;
+    for (unsigned int i = 0, n = matches.get_match_count(); i < n; ++i)
+    {
+        expected.format("%05d", i + 1);
+        REQUIRE(expected.equals(matches.get_match(i)));
+        REQUIRE(matches.get_suffix(i) == '/');
+    }
+}
@@ -0,0 +1,90 @@
+// Copyright (c) 2018 Martin Ridgers
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+
+#include "line_editor_tester.h"
+
+#include <lua/lua_match_generator.h>
+#include <lua/lua_state.h>
+
+//------------------------------------------------------------------------------
+TEST_CASE("Lua prefix rules")
+{
+    lua_state lua;
+    lua_match_generator lua_generator(lua);
+
+    line_editor_tester tester;
+    tester.get_editor()->add_generator(lua_generator);
+
+    const char* script = "\
+        prefix_generator = clink.generator(1)\
+        function prefix_generator:generate(line_state, match_builder)\
+            match_builder:addmatches({ 'abc', 'abd', 'xyz' })\
+            return true\
+        end\
+    ";
+
+    REQUIRE(lua.do_string(script));
+
+    SECTION("Separator")
+    {
+        REQUIRE(lua.do_string("prefix_generator:setprefixrule('separator', '\\\\/')"));
+
+        SECTION("None")
+        {
+            tester.set_input("cmd a");
+            tester.set_expected_matches("abc", "abd");
+            tester.run();
+        }
+
+        SECTION("One")
+        {
+            tester.set_input("cmd dir\\a");
+            tester.set_expected_matches("abc", "abd");
+            tester.run();
+        }
+
+        SECTION("Last")
+        {
+            tester.set_input("cmd dir/a\\x");
+            tester.set_expected_matches("xyz");
+            tester.run();
+        }
+    }
+
+    SECTION("Toggle")
+    {
+        REQUIRE(lua.do_string("prefix_generator:setprefixrule('toggle', '%')"));
+
+        SECTION("Open")
+        {
+            tester.set_input("cmd %a");
+            tester.set_expected_matches("abc", "abd");
+            tester.run();
+        }
+
+        SECTION("Closed")
+        {
+            tester.set_input("cmd %a%x");
+            tester.set_expected_matches();
+            tester.run();
+        }
+
+        SECTION("Reopened")
+        {
+            tester.set_input("cmd %a%b%x");
+            tester.set_expected_matches("xyz");
+            tester.run();
+        }
+    }
+
+    SECTION("None")
+    {
+        REQUIRE(lua.do_string("prefix_generator:setprefixrule('none')"));
+
+        tester.set_input("cmd dir\\a");
+        tester.set_expected_matches();
+        tester.run();
+    }
+}
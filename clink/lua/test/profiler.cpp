@@ -0,0 +1,52 @@
+// Copyright (c) 2016 Martin Ridgers
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+
+#include <core/str.h>
+#include <lua/lua_profiler.h>
+#include <lua/lua_state.h>
+
+//------------------------------------------------------------------------------
+TEST_CASE("Lua profiler")
+{
+    lua_state lua;
+
+    // Nothing's routed through the profiler until one's attached.
+    REQUIRE(lua.do_string("assert(clink._profile == nil)"));
+
+    SECTION("Calls")
+    {
+        lua_profiler profiler(lua.get_state(), lua_profiler::mode_calls);
+
+        REQUIRE(lua.do_string("\
+            local function func(a, b) return { a + b } end\
+            local ret = clink._profile('test', func, func, 1, 2)\
+            assert(ret[1] == 3)\
+            assert(not pcall(clink._profile, 'test', error, error, 'x'))\
+            assert(clink._profile('no_id', nil, func, 2, 3)[1] == 5)\
+        "));
+
+        str<> report;
+        profiler.report(report);
+        REQUIRE(strstr(report.c_str(), "test [string") != nullptr);
+        REQUIRE(strstr(report.c_str(), "no_id") != nullptr);
+
+        profiler.reset();
+        profiler.report(report);
+        REQUIRE(report.empty());
+    }
+
+    SECTION("Sampled")
+    {
+        lua_profiler profiler(lua.get_state(), lua_profiler::mode_sampled);
+
+        REQUIRE(lua.do_string("local x = 0 for i = 1, 100000 do x = x + i end"));
+
+        str<> report;
+        profiler.report(report);
+        REQUIRE(strstr(report.c_str(), "Samples") != nullptr);
+    }
+
+    REQUIRE(lua.do_string("assert(clink._profile == nil)"));
+}
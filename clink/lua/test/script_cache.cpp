@@ -0,0 +1,102 @@
+// Copyright (c) 2016 Martin Ridgers
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+
+#include "fs_fixture.h"
+
+#include <core/os.h>
+#include <lua/lua_state.h>
+
+extern "C" {
+#include <lua.h>
+}
+
+//------------------------------------------------------------------------------
+static int get_global_int(lua_state& lua, const char* name)
+{
+    lua_State* state = lua.get_state();
+    lua_getglobal(state, name);
+    int ret = int(lua_tointeger(state, -1));
+    lua_pop(state, 1);
+    return ret;
+}
+
+//------------------------------------------------------------------------------
+static void write_script(const char* script)
+{
+    if (FILE* out = fopen("script.lua", "wt"))
+    {
+        fputs(script, out);
+        fclose(out);
+    }
+}
+
+
+
+//------------------------------------------------------------------------------
+TEST_CASE("Lua script cache")
+{
+    static const char* empty_fs[] = { nullptr };
+    fs_fixture fs(empty_fs);
+
+    write_script("script_cache_value = (script_cache_value or 0) + 1");
+
+    lua_state lua;
+    unsigned int hits, misses;
+
+    SECTION("Uncached")
+    {
+        REQUIRE(lua.do_file("script.lua"));
+        REQUIRE(get_global_int(lua, "script_cache_value") == 1);
+        REQUIRE(os::get_path_type("cache") == os::path_type_invalid);
+
+        lua.get_script_cache_stats(hits, misses);
+        REQUIRE(hits == 0);
+        REQUIRE(misses == 0);
+    }
+
+    SECTION("Cached")
+    {
+        REQUIRE(lua.do_file("script.lua", "cache"));
+        REQUIRE(os::get_path_type("cache") == os::path_type_dir);
+
+        lua.get_script_cache_stats(hits, misses);
+        REQUIRE(hits == 0);
+        REQUIRE(misses == 1);
+
+        // Second load comes from the cache and should behave identically.
+        REQUIRE(lua.do_file("script.lua", "cache"));
+        REQUIRE(get_global_int(lua, "script_cache_value") == 2);
+
+        lua.get_script_cache_stats(hits, misses);
+        REQUIRE(hits == 1);
+        REQUIRE(misses == 1);
+    }
+
+    SECTION("Edited")
+    {
+        REQUIRE(lua.do_file("script.lua", "cache"));
+        REQUIRE(get_global_int(lua, "script_cache_value") == 1);
+
+        // A change to the script's size invalidates its cached bytecode.
+        write_script("script_cache_value = 10");
+        REQUIRE(lua.do_file("script.lua", "cache"));
+        REQUIRE(get_global_int(lua, "script_cache_value") == 10);
+
+        lua.get_script_cache_stats(hits, misses);
+        REQUIRE(hits == 0);
+        REQUIRE(misses == 2);
+
+        REQUIRE(lua.do_file("script.lua", "cache"));
+        lua.get_script_cache_stats(hits, misses);
+        REQUIRE(hits == 1);
+        REQUIRE(misses == 2);
+    }
+
+    SECTION("Syntax error")
+    {
+        write_script("script_cache_value = = 1");
+        REQUIRE(!lua.do_file("script.lua", "cache"));
+    }
+}
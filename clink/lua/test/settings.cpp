@@ -0,0 +1,35 @@
+// Copyright (c) 2016 Martin Ridgers
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+
+#include <core/settings.h>
+#include <lua/lua_state.h>
+
+//------------------------------------------------------------------------------
+TEST_CASE("Lua settings")
+{
+    lua_state lua;
+
+    setting_int one("!lua.one", "", "", 1);
+    REQUIRE(lua.do_string("assert(settings.get('!lua.one') == 1)"));
+
+    // Cached lookups still see the current value.
+    REQUIRE(one.set("2"));
+    REQUIRE(lua.do_string("assert(settings.get('!lua.one') == 2)"));
+    REQUIRE(lua.do_string("assert(settings.set('!lua.one', '3'))"));
+    REQUIRE(one.get() == 3);
+
+    // And settings coming and going.
+    {
+        setting_int two("!lua.two", "", "", 4);
+        REQUIRE(lua.do_string("assert(settings.get('!lua.two') == 4)"));
+    }
+    REQUIRE(lua.do_string("assert(settings.get('!lua.two') == nil)"));
+
+    REQUIRE(lua.do_string("\
+        assert(settings.add('!lua.three', true))\
+        assert(settings.get('!lua.three') == true)\
+        assert(settings.get('!lua.one') == 3)\
+    "));
+}
@@ -36,20 +36,22 @@ class attributes
 public:
     struct colour
     {
+        // Either one of xterm's 256 palette indices or a 24-bit RGB value.
         union
         {
             struct
             {
-                unsigned short  r : 5;
-                unsigned short  g : 5;
-                unsigned short  b : 5;
-                unsigned short  is_rgb : 1;
+                unsigned int    r : 8;
+                unsigned int    g : 8;
+                unsigned int    b : 8;
+                unsigned int    is_rgb : 1;
             };
-            unsigned short      value;
+            unsigned int        value;
         };
 
         bool                    operator == (const colour& rhs) const { return value == rhs.value; }
         void                    as_888(unsigned char (&out)[3]) const;
+        unsigned char           as_16() const;
     };
 
     template <typename T>
@@ -102,11 +104,11 @@ private:
         {
             colour              m_fg;
             colour              m_bg;
-            unsigned short      m_bold : 1;
-            unsigned short      m_underline : 1;
+            unsigned char       m_bold : 1;
+            unsigned char       m_underline : 1;
             flags               m_flags;
-            unsigned char       m_unused;
+            unsigned short      m_unused;
         };
-        unsigned long long      m_state;
+        unsigned int            m_state[3];
     };
 };
@@ -124,15 +124,8 @@ public:
 
 private:
     bool                next_c1();
-    bool                next_char(int c);
-    bool                next_char_str(int c);
-    bool                next_cmd_str(int c);
-    bool                next_csi_f(int c);
-    bool                next_csi_p(int c);
-    bool                next_esc(int c);
-    bool                next_esc_st(int c);
-    bool                next_unknown(int c);
     str_iter            m_iter;
+    const char*         m_end;
     ecma48_code&        m_code;
     ecma48_state&       m_state;
 };
@@ -5,8 +5,19 @@
 
 #include "attributes.h"
 
+class str_base;
 class terminal_out;
 
+//------------------------------------------------------------------------------
+// A span of text and the attributes to print it with. A null 'data' prints
+// 'bytes' spaces instead, which saves callers having to pad columns themselves.
+struct print_run
+{
+    attributes              attr;
+    const char*             data;
+    int                     bytes;
+};
+
 //------------------------------------------------------------------------------
 class printer
 {
@@ -14,6 +25,7 @@ public:
                             printer(terminal_out& terminal);
     void                    print(const char* data, int bytes);
     void                    print(const attributes attr, const char* data, int bytes);
+    void                    print(const print_run* runs, int count);
     template <int S> void   print(const char (&data)[S]);
     template <int S> void   print(const attributes attr, const char (&data)[S]);
     unsigned int            get_columns() const;
@@ -29,10 +41,22 @@ private: /* TODO: unimplemented API */
     cursor_state            get_cursor() const;
 
 private:
+    struct sgr_entry
+    {
+        attributes          from;
+        attributes          to;
+        bool                valid;
+        unsigned char       length;
+        char                sgr[46];
+    };
+
+    static void             format_sgr(const attributes from, const attributes to, str_base& out);
     void                    flush_attributes();
+    void                    append_attributes(str_base& out);
     terminal_out&           m_terminal;
     attributes              m_set_attr;
     attributes              m_next_attr;
+    sgr_entry               m_sgr_cache[32];
 };
 
 //------------------------------------------------------------------------------
@@ -0,0 +1,59 @@
+// Copyright (c) 2018 Martin Ridgers
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <core/str.h>
+
+#include <vector>
+
+class printer;
+
+//------------------------------------------------------------------------------
+// A model of the cells the prompt and the line being edited occupy on the
+// terminal. Each frame is laid out into cells and compared with the previous
+// one so that only the cursor moves and spans of cells that changed are
+// written. Parts of the prompt between 0x01/0x02 markers take up no cells.
+class shadow_screen
+{
+public:
+    void                reset();
+    void                draw(printer& printer, const char* prompt, const char* text, int text_length, int cursor);
+    int                 get_cursor_row() const;
+    int                 get_cursor_column() const;
+    int                 get_row_count() const;
+
+private:
+    struct cell
+    {
+        unsigned int    key;        // the cell's bytes, or ~0u if there's > 4
+        unsigned int    offset;     // into frame::chars
+        unsigned char   length;
+        unsigned char   width;      // 0 = right half of a wide character
+    };
+
+    struct frame
+    {
+        std::vector<cell> cells;
+        str<>           chars;
+        str<>           prompt;
+        int             prompt_cells = 0;
+        int             cursor = 0;
+        int             columns = 0;
+    };
+
+    static void         layout(frame& out, const char* prompt, const char* text, int text_length, int cursor);
+    static int          add_char(frame& out, const char* chars, int length);
+    static void         add_cell(frame& out, const char* chars, int length, int width);
+    bool                is_dirty(int index) const;
+    void                write_prompt(const frame& next);
+    void                write_span(const frame& next, int from, int to);
+    void                move_to(int index, int columns);
+    const frame&        get_front() const;
+    frame               m_frames[2];
+    str<>               m_out;
+    int                 m_cursor = 0;
+    unsigned char       m_front = 0;
+    bool                m_full = true;
+    bool                m_valid = false;
+};
@@ -17,6 +17,6 @@ public:
     virtual         ~terminal_in() = default;
     virtual void    begin() = 0;
     virtual void    end() = 0;
-    virtual void    select() = 0;
+    virtual void    select(int timeout=-1) = 0; // milliseconds, -1 = infinite
     virtual int     read() = 0;
 };
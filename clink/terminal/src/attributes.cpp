@@ -4,12 +4,20 @@
 #include "pch.h"
 #include "attributes.h"
 
-static_assert(sizeof(attributes) == sizeof(long long), "sizeof(attr) != 64bits");
+static_assert(sizeof(attributes) == sizeof(int) * 3, "sizeof(attr) != 96bits");
 
 //------------------------------------------------------------------------------
 enum
 {
-    default_code = 231, // because xterm256's 231 == old-school colour 15 (white)
+    default_code = 0x100, // not a palette index and not RGB (is_rgb's clear)
+};
+
+//------------------------------------------------------------------------------
+static const unsigned char g_basic_888[16][3] = {
+    {   0,   0,   0 }, { 128,   0,   0 }, {   0, 128,   0 }, { 128, 128,   0 },
+    {   0,   0, 128 }, { 128,   0, 128 }, {   0, 128, 128 }, { 192, 192, 192 },
+    { 128, 128, 128 }, { 255,   0,   0 }, {   0, 255,   0 }, { 255, 255,   0 },
+    {   0,   0, 255 }, { 255,   0, 255 }, {   0, 255, 255 }, { 255, 255, 255 },
 };
 
 
@@ -17,17 +25,73 @@ enum
 //------------------------------------------------------------------------------
 void attributes::colour::as_888(unsigned char (&out)[3]) const
 {
-    out[0] = (r << 3) | (r & 7);
-    out[1] = (g << 3) | (g & 7);
-    out[2] = (b << 3) | (b & 7);
+    if (is_rgb)
+    {
+        out[0] = r;
+        out[1] = g;
+        out[2] = b;
+        return;
+    }
+
+    // The basic 16 colours, then a 6x6x6 colour cube, then 24 shades of grey.
+    unsigned int index = value & 0xff;
+    if (index < 16)
+    {
+        for (int i = 0; i < 3; ++i)
+            out[i] = g_basic_888[index][i];
+        return;
+    }
+
+    if (index < 232)
+    {
+        static const unsigned char levels[] = { 0, 95, 135, 175, 215, 255 };
+        index -= 16;
+        out[0] = levels[index / 36];
+        out[1] = levels[(index / 6) % 6];
+        out[2] = levels[index % 6];
+        return;
+    }
+
+    out[0] = out[1] = out[2] = (unsigned char)(8 + ((index - 232) * 10));
+}
+
+//------------------------------------------------------------------------------
+unsigned char attributes::colour::as_16() const
+{
+    if (!is_rgb && value < 16)
+        return (unsigned char)value;
+
+    // Pick whichever of the basic 16 colours is closest.
+    unsigned char rgb[3];
+    as_888(rgb);
+
+    int nearest = -1;
+    int nearest_distance = 0;
+    for (int i = 0; i < 16; ++i)
+    {
+        int distance = 0;
+        for (int j = 0; j < 3; ++j)
+        {
+            int d = int(rgb[j]) - int(g_basic_888[i][j]);
+            distance += d * d;
+        }
+
+        if (nearest < 0 || distance < nearest_distance)
+        {
+            nearest = i;
+            nearest_distance = distance;
+        }
+    }
+
+    return (unsigned char)nearest;
 }
 
 
 
 //------------------------------------------------------------------------------
 attributes::attributes()
-: m_state(0)
 {
+    m_state[0] = m_state[1] = m_state[2] = 0;
 }
 
 //------------------------------------------------------------------------------
@@ -56,18 +120,13 @@ bool attributes::operator == (const attributes rhs)
 //------------------------------------------------------------------------------
 attributes attributes::merge(const attributes first, const attributes second)
 {
-    attributes mask;
-    mask.m_flags.all = ~0;
-    mask.m_fg.value = second.m_flags.fg ? ~0 : 0;
-    mask.m_bg.value = second.m_flags.bg ? ~0 : 0;
-    mask.m_bold = second.m_flags.bold;
-    mask.m_underline = second.m_flags.underline;
-
-    attributes out;
-    out.m_state = first.m_state & ~mask.m_state;
-    out.m_state |= second.m_state & mask.m_state;
-    out.m_flags.all |= first.m_flags.all;
+    attributes out = first;
+    if (second.m_flags.fg)          out.m_fg = second.m_fg;
+    if (second.m_flags.bg)          out.m_bg = second.m_bg;
+    if (second.m_flags.bold)        out.m_bold = second.m_bold;
+    if (second.m_flags.underline)   out.m_underline = second.m_underline;
 
+    out.m_flags.all |= second.m_flags.all;
     return out;
 }
 
@@ -102,9 +161,6 @@ void attributes::reset_bg()
 //------------------------------------------------------------------------------
 void attributes::set_fg(unsigned char value)
 {
-    if (value == default_code)
-        value = 15;
-
     m_flags.fg = 1;
     m_fg.value = value;
 }
@@ -112,9 +168,6 @@ void attributes::set_fg(unsigned char value)
 //------------------------------------------------------------------------------
 void attributes::set_bg(unsigned char value)
 {
-    if (value == default_code)
-        value = 15;
-
     m_flags.bg = 1;
     m_bg.value = value;
 }
@@ -123,9 +176,10 @@ void attributes::set_bg(unsigned char value)
 void attributes::set_fg(unsigned char r, unsigned char g, unsigned char b)
 {
     m_flags.fg = 1;
-    m_fg.r = r >> 3;
-    m_fg.g = g >> 3;
-    m_fg.b = b >> 3;
+    m_fg.value = 0;
+    m_fg.r = r;
+    m_fg.g = g;
+    m_fg.b = b;
     m_fg.is_rgb = 1;
 }
 
@@ -133,9 +187,10 @@ void attributes::set_fg(unsigned char r, unsigned char g, unsigned char b)
 void attributes::set_bg(unsigned char r, unsigned char g, unsigned char b)
 {
     m_flags.bg = 1;
-    m_bg.r = r >> 3;
-    m_bg.g = g >> 3;
-    m_bg.b = b >> 3;
+    m_bg.value = 0;
+    m_bg.r = r;
+    m_bg.g = g;
+    m_bg.b = b;
     m_bg.is_rgb = 1;
 }
 
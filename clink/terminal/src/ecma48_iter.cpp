@@ -7,6 +7,13 @@
 #include <core/base.h>
 #include <core/str_tokeniser.h>
 
+#if defined(_M_IX86) || defined(_M_X64)
+#   include <emmintrin.h>
+#   if defined(_MSC_VER)
+#       include <intrin.h>
+#   endif
+#endif
+
 //------------------------------------------------------------------------------
 extern "C" int wcwidth(int);
 
@@ -51,8 +58,125 @@ enum
     ecma48_state_csi_f,
     ecma48_state_cmd_str,
     ecma48_state_char_str,
+    ecma48_state_count
 };
 
+//------------------------------------------------------------------------------
+// Classes of the code points that the states react differently to.
+enum
+{
+    class_c0,           // 0x00-0x07, 0x0e-0x1a, 0x1c-0x1f
+    class_c0_format,    // 0x08-0x0d
+    class_esc,          // 0x1b
+    class_inter,        // 0x20-0x2f
+    class_param,        // 0x30-0x3f
+    class_upper,        // 0x40-0x5f bar 0x5c
+    class_backslash,    // 0x5c
+    class_lower,        // 0x60-0x7e
+    class_del,          // 0x7f
+    class_c1,           // 0x80-0x9f bar 0x9c
+    class_st,           // 0x9c
+    class_other,        // >= 0xa0
+    class_count
+};
+
+//------------------------------------------------------------------------------
+// What to do with a code point. The low nibble of a transition is the action
+// and the high nibble the state to move to.
+enum
+{
+    act_next,           // consume and continue
+    act_done,           // consume and the code's complete
+    act_end,            // the code's complete (without consuming)
+    act_reset,          // abandon the code so far (without consuming)
+    act_c0,             // consume; it's a C0 code
+    act_c1,             // consume; it's a C1 code (7-bit or 8-bit)
+    act_icf,            // consume; it's an independent control function
+    act_chars,          // consume; start of a run of characters
+    act_retry,          // move to the new state and look at it again
+};
+
+#define T(state, act)   (((ecma48_state_##state) << 4) | act_##act)
+
+static const unsigned char g_transitions[ecma48_state_count][class_count] = {
+    /*                 c0                 c0_format          esc                 inter              param              upper              backslash          lower              del                c1                 st                 other */
+    /* unknown  */ {   T(unknown, c0),    T(unknown, c0),    T(esc, next),       T(char, chars),    T(char, chars),    T(char, chars),    T(char, chars),    T(char, chars),    T(char, chars),    T(unknown, c1),    T(unknown, c1),    T(char, chars) },
+    /* char     */ {   T(char, end),      T(char, end),      T(char, end),       T(char, next),     T(char, next),     T(char, next),     T(char, next),     T(char, next),     T(char, next),     T(char, next),     T(char, next),     T(char, next) },
+    /* esc      */ {   T(char, chars),    T(char, chars),    T(char, chars),     T(char, chars),    T(char, chars),    T(esc, c1),        T(esc, c1),        T(esc, icf),       T(esc, icf),       T(char, chars),    T(char, chars),    T(char, chars) },
+    /* esc_st   */ {   T(unknown, reset), T(unknown, reset), T(unknown, reset),  T(unknown, reset), T(unknown, reset), T(unknown, reset), T(esc_st, done),   T(unknown, reset), T(unknown, reset), T(unknown, reset), T(unknown, reset), T(unknown, reset) },
+    /* csi_p    */ {   T(csi_f, retry),   T(csi_f, retry),   T(csi_f, retry),    T(csi_f, retry),   T(csi_p, next),    T(csi_f, retry),   T(csi_f, retry),   T(csi_f, retry),   T(csi_f, retry),   T(csi_f, retry),   T(csi_f, retry),   T(csi_f, retry) },
+    /* csi_f    */ {   T(unknown, reset), T(unknown, reset), T(unknown, reset),  T(csi_f, next),    T(unknown, reset), T(csi_f, done),    T(csi_f, done),    T(csi_f, done),    T(unknown, reset), T(unknown, reset), T(unknown, reset), T(unknown, reset) },
+    /* cmd_str  */ {   T(unknown, reset), T(cmd_str, next),  T(esc_st, next),    T(cmd_str, next),  T(cmd_str, next),  T(cmd_str, next),  T(cmd_str, next),  T(cmd_str, next),  T(unknown, reset), T(unknown, reset), T(cmd_str, done),  T(unknown, reset) },
+    /* char_str */ {   T(char_str, next), T(char_str, next), T(esc_st, next),    T(char_str, next), T(char_str, next), T(char_str, next), T(char_str, next), T(char_str, next), T(char_str, next), T(char_str, next), T(char_str, done), T(char_str, next) },
+};
+
+#undef T
+
+//------------------------------------------------------------------------------
+static int get_class(int c)
+{
+    static const unsigned char ascii_classes[] = {
+        class_c0,        class_c0,        class_c0,        class_c0,
+        class_c0,        class_c0,        class_c0,        class_c0,
+        class_c0_format, class_c0_format, class_c0_format, class_c0_format,
+        class_c0_format, class_c0_format, class_c0,        class_c0,
+        class_c0,        class_c0,        class_c0,        class_c0,
+        class_c0,        class_c0,        class_c0,        class_c0,
+        class_c0,        class_c0,        class_c0,        class_esc,
+        class_c0,        class_c0,        class_c0,        class_c0,
+    };
+
+    if (c < 0x20)   return ascii_classes[c];
+    if (c < 0x30)   return class_inter;
+    if (c < 0x40)   return class_param;
+    if (c < 0x60)   return (c == 0x5c) ? class_backslash : class_upper;
+    if (c < 0x7f)   return class_lower;
+    if (c == 0x7f)  return class_del;
+    if (c < 0xa0)   return (c == 0x9c) ? class_st : class_c1;
+    return class_other;
+}
+
+#if defined(_M_IX86) || defined(_M_X64)
+//------------------------------------------------------------------------------
+static unsigned int find_lowest_bit(unsigned int mask)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return index;
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+#endif
+
+//------------------------------------------------------------------------------
+static const char* find_c0(const char* ptr, const char* end)
+{
+    // Finds the first byte < 0x20 (a C0 control or the terminator) between ptr
+    // and end. On x86/x64 this goes sixteen bytes at a time with SSE2; loads
+    // are unaligned and never extend past end, so only bytes that are part of
+    // the string are read. Elsewhere, and for what's left, it's byte by byte.
+#if defined(_M_IX86) || defined(_M_X64)
+    const __m128i high_bits = _mm_set1_epi8(char(0xe0));
+    const __m128i zero = _mm_setzero_si128();
+
+    for (; end - ptr >= 16; ptr += 16)
+    {
+        __m128i chars = _mm_loadu_si128((const __m128i*)ptr);
+        __m128i is_c0 = _mm_cmpeq_epi8(_mm_and_si128(chars, high_bits), zero);
+        if (unsigned int found = unsigned(_mm_movemask_epi8(is_c0)))
+            return ptr + find_lowest_bit(found);
+    }
+#endif
+
+    for (; ptr < end; ++ptr)
+        if ((unsigned char)(*ptr) < 0x20)
+            break;
+
+    return ptr;
+}
+
 
 
 //------------------------------------------------------------------------------
@@ -141,6 +265,7 @@ bool ecma48_code::get_c1_str(str_base& out) const
 //------------------------------------------------------------------------------
 ecma48_iter::ecma48_iter(const char* s, ecma48_state& state, int len)
 : m_iter(s, len)
+, m_end(s + ((len >= 0) ? len : strlen(s)))
 , m_code(state.code)
 , m_state(state)
 {
@@ -155,6 +280,10 @@ const ecma48_code& ecma48_iter::next()
     bool done = true;
     while (1)
     {
+        // Runs of characters are skipped in bulk. Only C0 codes end them.
+        if (m_state.state == ecma48_state_char)
+            m_iter.reset_pointer(find_c0(m_iter.get_pointer(), m_end));
+
         int c = m_iter.peek();
         if (!c)
         {
@@ -167,18 +296,67 @@ const ecma48_code& ecma48_iter::next()
             break;
         }
 
-        switch (m_state.state)
+        unsigned char transition = g_transitions[m_state.state][get_class(c)];
+        int next_state = transition >> 4;
+
+        done = false;
+        switch (transition & 0x0f)
         {
-        case ecma48_state_char:     done = next_char(c);     break;
-        case ecma48_state_char_str: done = next_char_str(c); break;
-        case ecma48_state_cmd_str:  done = next_cmd_str(c);  break;
-        case ecma48_state_csi_f:    done = next_csi_f(c);    break;
-        case ecma48_state_csi_p:    done = next_csi_p(c);    break;
-        case ecma48_state_esc:      done = next_esc(c);      break;
-        case ecma48_state_esc_st:   done = next_esc_st(c);   break;
-        case ecma48_state_unknown:  done = next_unknown(c);  break;
+        case act_next:
+            m_iter.next();
+            break;
+
+        case act_done:
+            m_iter.next();
+            done = true;
+            break;
+
+        case act_end:
+            m_code.m_type = ecma48_code::type_chars;
+            done = true;
+            break;
+
+        case act_reset:
+            m_code.m_str = m_iter.get_pointer();
+            m_code.m_length = 0;
+            m_state.reset();
+            copy = m_iter.get_pointer();
+            continue;
+
+        case act_c0:
+            m_iter.next();
+            m_code.m_type = ecma48_code::type_c0;
+            m_code.m_code = c;
+            done = true;
+            break;
+
+        case act_c1:
+            m_iter.next();
+            m_code.m_type = ecma48_code::type_c1;
+            m_code.m_code = c;
+            done = next_c1();
+            next_state = m_state.state;
+            break;
+
+        case act_icf:
+            m_iter.next();
+            m_code.m_type = ecma48_code::type_icf;
+            m_code.m_code = c;
+            done = true;
+            break;
+
+        case act_chars:
+            m_iter.next();
+            m_code.m_type = ecma48_code::type_chars;
+            break;
+
+        case act_retry:
+            m_state.state = next_state;
+            continue;
         }
 
+        m_state.state = next_state;
+
         if (m_state.state != ecma48_state_char)
         {
             while (copy != m_iter.get_pointer())
@@ -231,156 +409,3 @@ bool ecma48_iter::next_c1()
 
     return true;
 }
-
-//------------------------------------------------------------------------------
-bool ecma48_iter::next_char(int c)
-{
-    if (in_range(c, 0x00, 0x1f))
-    {
-        m_code.m_type = ecma48_code::type_chars;
-        return true;
-    }
-
-    m_iter.next();
-    return false;
-}
-
-//------------------------------------------------------------------------------
-bool ecma48_iter::next_char_str(int c)
-{
-    m_iter.next();
-
-    if (c == 0x1b)
-    {
-        m_state.state = ecma48_state_esc_st;
-        return false;
-    }
-
-    return (c == 0x9c);
-}
-
-//------------------------------------------------------------------------------
-bool ecma48_iter::next_cmd_str(int c)
-{
-    if (c == 0x1b)
-    {
-        m_iter.next();
-        m_state.state = ecma48_state_esc_st;
-        return false;
-    }
-    else if (c == 0x9c)
-    {
-        m_iter.next();
-        return true;
-    }
-    else if (in_range(c, 0x08, 0x0d) || in_range(c, 0x20, 0x7e))
-    {
-        m_iter.next();
-        return false;
-    }
-
-    // Reset
-    m_code.m_str = m_iter.get_pointer();
-    m_code.m_length = 0;
-    m_state.reset();
-    return false;
-}
-
-//------------------------------------------------------------------------------
-bool ecma48_iter::next_csi_f(int c)
-{
-    if (in_range(c, 0x20, 0x2f))
-    {
-        m_iter.next();
-        return false;
-    }
-    else if (in_range(c, 0x40, 0x7e))
-    {
-        m_iter.next();
-        return true;
-    }
-
-    // Reset
-    m_code.m_str = m_iter.get_pointer();
-    m_code.m_length = 0;
-    m_state.reset();
-    return false;
-}
-
-//------------------------------------------------------------------------------
-bool ecma48_iter::next_csi_p(int c)
-{
-    if (in_range(c, 0x30, 0x3f))
-    {
-        m_iter.next();
-        return false;
-    }
-
-    m_state.state = ecma48_state_csi_f;
-    return next_csi_f(c);
-}
-
-//------------------------------------------------------------------------------
-bool ecma48_iter::next_esc(int c)
-{
-    m_iter.next();
-
-    if (in_range(c, 0x40, 0x5f))
-    {
-        m_code.m_type = ecma48_code::type_c1;
-        m_code.m_code = c;
-        return next_c1();
-    }
-    else if (in_range(c, 0x60, 0x7f))
-    {
-        m_code.m_type = ecma48_code::type_icf;
-        m_code.m_code = c;
-        return true;
-    }
-
-    m_state.state = ecma48_state_char;
-    return false;
-}
-
-//------------------------------------------------------------------------------
-bool ecma48_iter::next_esc_st(int c)
-{
-    if (c == 0x5c)
-    {
-        m_iter.next();
-        return true;
-    }
-
-    m_code.m_str = m_iter.get_pointer();
-    m_code.m_length = 0;
-    m_state.reset();
-    return false;
-}
-
-//------------------------------------------------------------------------------
-bool ecma48_iter::next_unknown(int c)
-{
-    m_iter.next();
-
-    if (c == 0x1b)
-    {
-        m_state.state = ecma48_state_esc;
-        return false;
-    }
-    else if (in_range(c, 0x00, 0x1f))
-    {
-        m_code.m_type = ecma48_code::type_c0;
-        m_code.m_code = c;
-        return true;
-    }
-    else if (in_range(c, 0x80, 0x9f))
-    {
-        m_code.m_type = ecma48_code::type_c1;
-        m_code.m_code = c;
-        return next_c1();
-    }
-
-    m_code.m_type = ecma48_code::type_chars;
-    m_state.state = ecma48_state_char;
-    return false;
-}
@@ -6,6 +6,38 @@
 #include "ecma48_iter.h"
 #include "screen_buffer.h"
 
+//------------------------------------------------------------------------------
+static bool is_opposite(int a, int b)
+{
+    return (a < 0 && b > 0) || (a > 0 && b < 0);
+}
+
+//------------------------------------------------------------------------------
+static bool has_attributes(const attributes attr)
+{
+    return attr.get_fg() || attr.get_bg() || attr.get_bold() || attr.get_underline();
+}
+
+//------------------------------------------------------------------------------
+template <typename T> static bool covers(
+    const attributes::attribute<T>& lhs,
+    const attributes::attribute<T>& rhs)
+{
+    return !rhs || (lhs && (lhs.value == rhs.value));
+}
+
+//------------------------------------------------------------------------------
+static bool is_redundant(const attributes current, const attributes attr)
+{
+    // True if everything 'attr' sets is already set to the same in 'current'.
+    return covers(current.get_fg(), attr.get_fg())
+        && covers(current.get_bg(), attr.get_bg())
+        && covers(current.get_bold(), attr.get_bold())
+        && covers(current.get_underline(), attr.get_underline());
+}
+
+
+
 //------------------------------------------------------------------------------
 ecma48_terminal_out::ecma48_terminal_out(screen_buffer& screen)
 : m_screen(screen)
@@ -16,20 +48,94 @@ ecma48_terminal_out::ecma48_terminal_out(screen_buffer& screen)
 void ecma48_terminal_out::begin()
 {
     m_screen.begin();
+    m_screen_attr = attributes();
 }
 
 //------------------------------------------------------------------------------
 void ecma48_terminal_out::end()
 {
+    flush_all();
     m_screen.end();
 }
 
 //------------------------------------------------------------------------------
 void ecma48_terminal_out::flush()
 {
+    flush_all();
     m_screen.flush();
 }
 
+//------------------------------------------------------------------------------
+void ecma48_terminal_out::flush_text()
+{
+    if (m_text.empty())
+        return;
+
+    m_screen.write(m_text.c_str(), m_text.length());
+    m_text.clear();
+}
+
+//------------------------------------------------------------------------------
+void ecma48_terminal_out::flush_cursor()
+{
+    if (m_home)
+        m_screen.move_cursor(INT_MIN, m_dy);
+
+    if (m_home ? m_dx : (m_dx | m_dy))
+        m_screen.move_cursor(m_dx, m_home ? 0 : m_dy);
+
+    m_dx = m_dy = 0;
+    m_home = false;
+}
+
+//------------------------------------------------------------------------------
+void ecma48_terminal_out::flush_attributes()
+{
+    if (!has_attributes(m_attr))
+        return;
+
+    if (!is_redundant(m_screen_attr, m_attr))
+    {
+        m_screen.set_attributes(m_attr);
+        m_screen_attr = attributes::merge(m_screen_attr, m_attr);
+    }
+
+    m_attr = attributes();
+}
+
+//------------------------------------------------------------------------------
+void ecma48_terminal_out::flush_all()
+{
+    flush_text();
+    flush_cursor();
+    flush_attributes();
+}
+
+//------------------------------------------------------------------------------
+void ecma48_terminal_out::move_cursor(int dx, int dy)
+{
+    // Moves are clamped to the screen's edges at each step so they can only
+    // be combined while they go the same way. A move to column zero (a CR)
+    // makes any earlier horizontal move irrelevant.
+    flush_text();
+
+    if (dx == INT_MIN)
+    {
+        m_home = true;
+        m_dx = 0;
+        dx = 0;
+    }
+
+    if (is_opposite(m_dx, dx) || is_opposite(m_dy, dy))
+        flush_cursor();
+
+    if (m_home && m_dx == 0 && dx < 0)
+        dx = 0;
+
+    m_dx += dx;
+    m_dy += dy;
+}
+
 //------------------------------------------------------------------------------
 int ecma48_terminal_out::get_columns() const
 {
@@ -70,10 +176,10 @@ void ecma48_terminal_out::write_c1(const ecma48_code& code)
         case 'P': delete_chars(csi);        break;
         case 'm': set_attributes(csi);      break;
 
-        case 'A': m_screen.move_cursor(0, -csi.get_param(0, 1)); break;
-        case 'B': m_screen.move_cursor(0,  csi.get_param(0, 1)); break;
-        case 'C': m_screen.move_cursor( csi.get_param(0, 1), 0); break;
-        case 'D': m_screen.move_cursor(-csi.get_param(0, 1), 0); break;
+        case 'A': move_cursor(0, -csi.get_param(0, 1)); break;
+        case 'B': move_cursor(0,  csi.get_param(0, 1)); break;
+        case 'C': move_cursor( csi.get_param(0, 1), 0); break;
+        case 'D': move_cursor(-csi.get_param(0, 1), 0); break;
         }
     }
 }
@@ -88,18 +194,20 @@ void ecma48_terminal_out::write_c0(int c0)
         break;
 
     case ecma48_code::c0_bs:
-        m_screen.move_cursor(-1, 0);
+        move_cursor(-1, 0);
         break;
 
     case ecma48_code::c0_cr:
-        m_screen.move_cursor(INT_MIN, 0);
+        move_cursor(INT_MIN, 0);
         break;
 
     case ecma48_code::c0_ht: // TODO: perhaps there should be a next_tab_stop() method?
     case ecma48_code::c0_lf: // TODO: shouldn't expect screen_buffer impl to react to '\n' characters.
         {
             char c = char(c0);
-            m_screen.write(&c, 1);
+            flush_cursor();
+            flush_attributes();
+            m_text.concat(&c, 1);
             break;
         }
     }
@@ -114,7 +222,9 @@ void ecma48_terminal_out::write(const char* chars, int length)
         switch (code.get_type())
         {
         case ecma48_code::type_chars:
-            m_screen.write(code.get_pointer(), code.get_length());
+            flush_cursor();
+            flush_attributes();
+            m_text.concat(code.get_pointer(), code.get_length());
             break;
 
         case ecma48_code::type_c0:
@@ -131,9 +241,16 @@ void ecma48_terminal_out::write(const char* chars, int length)
 //------------------------------------------------------------------------------
 void ecma48_terminal_out::set_attributes(const ecma48_code::csi_base& csi)
 {
+    // Attributes only need to reach the screen before the next text does so
+    // consecutive changes are merged.
+    flush_text();
+
     // Empty parameters to 'CSI SGR' implies 0 (reset).
     if (csi.param_count == 0)
-        return m_screen.set_attributes(attributes::defaults);
+    {
+        m_attr = attributes::merge(m_attr, attributes::defaults);
+        return;
+    }
 
     // Process each code that is supported.
     attributes attr;
@@ -174,10 +291,34 @@ void ecma48_terminal_out::set_attributes(const ecma48_code::csi_base& csi)
             continue;
         }
 
-        // TODO: Rgb/xterm256 support for terminals that support it.
+        // xterm's 256 colour and 24-bit colour extensions; "38;5;index" and
+        // "38;2;r;g;b", with 48 for the background.
+        if ((param == 38) | (param == 48))
+        {
+            bool is_fg = (param == 38);
+            int type = csi.get_param(i + 1);
+            if (type == 5 && i + 2 < csi.param_count)
+            {
+                unsigned char index = csi.get_param(i + 2) & 0xff;
+                is_fg ? attr.set_fg(index) : attr.set_bg(index);
+                i += 2;
+            }
+            else if (type == 2 && i + 4 < csi.param_count)
+            {
+                unsigned char r = csi.get_param(i + 2) & 0xff;
+                unsigned char g = csi.get_param(i + 3) & 0xff;
+                unsigned char b = csi.get_param(i + 4) & 0xff;
+                is_fg ? attr.set_fg(r, g, b) : attr.set_bg(r, g, b);
+                i += 4;
+            }
+            else
+                break; // malformed; nothing after it can be trusted.
+
+            continue;
+        }
     }
 
-    m_screen.set_attributes(attr);
+    m_attr = attributes::merge(m_attr, attr);
 }
 
 //------------------------------------------------------------------------------
@@ -189,6 +330,8 @@ void ecma48_terminal_out::erase_in_display(const ecma48_code::csi_base& csi)
             Ps = 2  -> Selective Erase All.
             Ps = 3  -> Selective Erase Saved Lines (xterm). */
 
+    flush_all();
+
     switch (csi.get_param(0))
     {
     case 0: m_screen.clear(screen_buffer::clear_type_after);    break;
@@ -205,6 +348,8 @@ void ecma48_terminal_out::erase_in_line(const ecma48_code::csi_base& csi)
             Ps = 1  -> Erase to Left.
             Ps = 2  -> Erase All. */
 
+    flush_all();
+
     switch (csi.get_param(0))
     {
     case 0: m_screen.clear_line(screen_buffer::clear_type_after);   break;
@@ -219,6 +364,7 @@ void ecma48_terminal_out::set_cursor(const ecma48_code::csi_base& csi)
     /* CSI Ps ; Ps H : Cursor Position [row;column] (default = [1,1]) (CUP). */
     int row = csi.get_param(0, 1);
     int column = csi.get_param(1, 1);
+    flush_all();
     m_screen.set_cursor(column - 1, row - 1);
 }
 
@@ -227,6 +373,7 @@ void ecma48_terminal_out::insert_chars(const ecma48_code::csi_base& csi)
 {
     /* CSI Ps @  Insert Ps (Blank) Character(s) (default = 1) (ICH). */
     int count = csi.get_param(0, 1);
+    flush_all();
     m_screen.insert_chars(count);
 }
 
@@ -235,6 +382,7 @@ void ecma48_terminal_out::delete_chars(const ecma48_code::csi_base& csi)
 {
     /* CSI Ps P : Delete Ps Character(s) (default = 1) (DCH). */
     int count = csi.get_param(0, 1);
+    flush_all();
     m_screen.delete_chars(count);
 }
 
@@ -3,9 +3,12 @@
 
 #pragma once
 
+#include "attributes.h"
 #include "ecma48_iter.h"
 #include "terminal_out.h"
 
+#include <core/str.h>
+
 class screen_buffer;
 
 //------------------------------------------------------------------------------
@@ -22,6 +25,11 @@ public:
     virtual int         get_rows() const override;
 
 private:
+    void                flush_text();
+    void                flush_cursor();
+    void                flush_attributes();
+    void                flush_all();
+    void                move_cursor(int dx, int dy);
     void                write_c1(const ecma48_code& code);
     void                write_c0(int c0);
     void                set_attributes(const ecma48_code::csi_base& csi);
@@ -34,4 +42,10 @@ private:
     void                reset_private_mode(const ecma48_code::csi_base& csi);
     ecma48_state        m_state;
     screen_buffer&      m_screen;
+    str<1024>           m_text;             // not yet written to m_screen
+    attributes          m_attr;             // not yet set on m_screen
+    attributes          m_screen_attr;      // what's been set since begin()
+    int                 m_dx = 0;           // relative cursor move pending...
+    int                 m_dy = 0;
+    bool                m_home = false;     // ...after moving to column zero
 };
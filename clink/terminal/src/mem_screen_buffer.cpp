@@ -0,0 +1,327 @@
+// Copyright (c) 2018 Martin Ridgers
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "mem_screen_buffer.h"
+
+#include <core/base.h>
+#include <core/str.h>
+#include <core/str_iter.h>
+
+extern "C" int wcwidth(int);
+
+//------------------------------------------------------------------------------
+mem_screen_buffer::mem_screen_buffer(int columns, int rows)
+: m_attr(attributes::defaults)
+, m_columns(max(columns, 1))
+, m_rows(max(rows, 1))
+{
+    m_cells.resize(m_columns * m_rows);
+    fill(0, 0, m_columns * m_rows);
+}
+
+//------------------------------------------------------------------------------
+void mem_screen_buffer::begin()
+{
+}
+
+//------------------------------------------------------------------------------
+void mem_screen_buffer::end()
+{
+}
+
+//------------------------------------------------------------------------------
+void mem_screen_buffer::write(const char* data, int length)
+{
+    ++m_calls;
+
+    str_iter iter(data, length);
+    while (iter.more())
+    {
+        int c = iter.next();
+        switch (c)
+        {
+        case '\n':
+            line_feed();
+            break;
+
+        case '\r':
+            m_cursor_x = 0;
+            break;
+
+        case '\b':
+            m_cursor_x = max(m_cursor_x - 1, 0);
+            break;
+
+        case '\t':
+            m_cursor_x = min((m_cursor_x + 8) & ~7, m_columns - 1);
+            break;
+
+        default:
+            if (c >= 0x20)
+                write_char(c);
+            break;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+void mem_screen_buffer::flush()
+{
+}
+
+//------------------------------------------------------------------------------
+int mem_screen_buffer::get_columns() const
+{
+    return m_columns;
+}
+
+//------------------------------------------------------------------------------
+int mem_screen_buffer::get_rows() const
+{
+    return m_rows;
+}
+
+//------------------------------------------------------------------------------
+void mem_screen_buffer::clear(clear_type type)
+{
+    ++m_calls;
+
+    int cursor = (m_cursor_y * m_columns) + m_cursor_x;
+    switch (type)
+    {
+    case clear_type_all:    fill(0, 0, m_columns * m_rows);                             break;
+    case clear_type_before: fill(0, 0, cursor + 1);                                     break;
+    case clear_type_after:  fill(m_cursor_x, m_cursor_y, (m_columns * m_rows) - cursor); break;
+    }
+}
+
+//------------------------------------------------------------------------------
+void mem_screen_buffer::clear_line(clear_type type)
+{
+    ++m_calls;
+
+    switch (type)
+    {
+    case clear_type_all:    fill(0, m_cursor_y, m_columns);                         break;
+    case clear_type_before: fill(0, m_cursor_y, m_cursor_x + 1);                    break;
+    case clear_type_after:  fill(m_cursor_x, m_cursor_y, m_columns - m_cursor_x);   break;
+    }
+}
+
+//------------------------------------------------------------------------------
+void mem_screen_buffer::set_cursor(int column, int row)
+{
+    ++m_calls;
+
+    m_cursor_x = clamp(column, 0, m_columns - 1);
+    m_cursor_y = clamp(row, 0, m_rows - 1);
+}
+
+//------------------------------------------------------------------------------
+void mem_screen_buffer::move_cursor(int dx, int dy)
+{
+    ++m_calls;
+
+    // INT_MIN is used to move to column zero.
+    if (dx == INT_MIN)
+        m_cursor_x = 0;
+    else
+        m_cursor_x = clamp(m_cursor_x + dx, 0, m_columns - 1);
+
+    m_cursor_y = clamp(m_cursor_y + dy, 0, m_rows - 1);
+}
+
+//------------------------------------------------------------------------------
+void mem_screen_buffer::insert_chars(int count)
+{
+    ++m_calls;
+
+    if (count <= 0)
+        return;
+
+    count = min(count, m_columns - m_cursor_x);
+    cell* row = get_cell(0, m_cursor_y);
+    for (int i = m_columns - 1; i >= m_cursor_x + count; --i)
+        row[i] = row[i - count];
+
+    fill(m_cursor_x, m_cursor_y, count);
+}
+
+//------------------------------------------------------------------------------
+void mem_screen_buffer::delete_chars(int count)
+{
+    ++m_calls;
+
+    if (count <= 0)
+        return;
+
+    count = min(count, m_columns - m_cursor_x);
+    cell* row = get_cell(0, m_cursor_y);
+    for (int i = m_cursor_x; i < m_columns - count; ++i)
+        row[i] = row[i + count];
+
+    fill(m_columns - count, m_cursor_y, count);
+}
+
+//------------------------------------------------------------------------------
+void mem_screen_buffer::set_attributes(const attributes attr)
+{
+    ++m_calls;
+    m_attr = attributes::merge(m_attr, attr);
+}
+
+//------------------------------------------------------------------------------
+void mem_screen_buffer::resize(int columns, int rows)
+{
+    // Like the console, content isn't reflowed. It's kept or cut at the edges.
+    columns = max(columns, 1);
+    rows = max(rows, 1);
+
+    cell blank = { ' ', attributes(attributes::defaults) };
+    std::vector<cell> cells(columns * rows, blank);
+    for (int y = 0, h = min(rows, m_rows); y < h; ++y)
+        for (int x = 0, w = min(columns, m_columns); x < w; ++x)
+            cells[(y * columns) + x] = *get_cell(x, y);
+
+    m_cells.swap(cells);
+    m_columns = columns;
+    m_rows = rows;
+    m_cursor_x = min(m_cursor_x, columns - 1);
+    m_cursor_y = min(m_cursor_y, rows - 1);
+}
+
+//------------------------------------------------------------------------------
+int mem_screen_buffer::get_cursor_column() const
+{
+    return m_cursor_x;
+}
+
+//------------------------------------------------------------------------------
+int mem_screen_buffer::get_cursor_row() const
+{
+    return m_cursor_y;
+}
+
+//------------------------------------------------------------------------------
+void mem_screen_buffer::get_line(int row, str_base& out) const
+{
+    // Trailing blanks aren't included.
+    out.clear();
+    if (row < 0 || row >= m_rows)
+        return;
+
+    const cell* cells = m_cells.data() + (row * m_columns);
+    int end = m_columns;
+    while (end > 0 && cells[end - 1].c == ' ')
+        --end;
+
+    for (int i = 0; i < end; ++i)
+    {
+        unsigned int c = cells[i].c;
+        if (!c)
+            continue;
+
+        char utf8[4];
+        int n;
+        if (c < 0x80)       { utf8[0] = char(c); n = 1; }
+        else if (c < 0x800) { utf8[0] = char(0xc0 | (c >> 6)); n = 2; }
+        else if (c < 0x10000) { utf8[0] = char(0xe0 | (c >> 12)); n = 3; }
+        else                { utf8[0] = char(0xf0 | (c >> 18)); n = 4; }
+
+        for (int j = n - 1; j > 0; --j, c >>= 6)
+            utf8[j] = char(0x80 | (c & 0x3f));
+
+        out.concat(utf8, n);
+    }
+}
+
+//------------------------------------------------------------------------------
+attributes mem_screen_buffer::get_cell_attributes(int column, int row) const
+{
+    column = clamp(column, 0, m_columns - 1);
+    row = clamp(row, 0, m_rows - 1);
+    return m_cells[(row * m_columns) + column].attr;
+}
+
+//------------------------------------------------------------------------------
+unsigned int mem_screen_buffer::get_call_count() const
+{
+    return m_calls;
+}
+
+//------------------------------------------------------------------------------
+unsigned int mem_screen_buffer::get_scroll_count() const
+{
+    return m_scrolls;
+}
+
+//------------------------------------------------------------------------------
+mem_screen_buffer::cell* mem_screen_buffer::get_cell(int column, int row)
+{
+    return m_cells.data() + (row * m_columns) + column;
+}
+
+//------------------------------------------------------------------------------
+void mem_screen_buffer::fill(int column, int row, int count)
+{
+    // Clears are filled with the current attributes as the console does.
+    cell* c = get_cell(column, row);
+    for (int i = 0; i < count; ++i, ++c)
+        *c = { ' ', m_attr };
+}
+
+//------------------------------------------------------------------------------
+void mem_screen_buffer::write_char(int c)
+{
+    int width = wcwidth(c);
+    if (width < 0)
+        width = 1;
+
+    // Zero width characters aren't modelled.
+    if (!width)
+        return;
+
+    // Wide characters that don't fit are moved on to the next line.
+    if (m_cursor_x + width > m_columns)
+    {
+        fill(m_cursor_x, m_cursor_y, m_columns - m_cursor_x);
+        line_feed();
+    }
+
+    // Overwriting half of a wide character blanks the other half.
+    cell* out = get_cell(m_cursor_x, m_cursor_y);
+    if (m_cursor_x > 0 && out->c == 0)
+        out[-1].c = ' ';
+
+    int end = m_cursor_x + width;
+    if (end < m_columns && out[width].c == 0)
+        out[width].c = ' ';
+
+    out[0] = { unsigned(c), m_attr };
+    if (width > 1)
+        out[1] = { 0, m_attr };
+
+    // The console moves to the next line as soon as the last column's written.
+    m_cursor_x = end;
+    if (m_cursor_x >= m_columns)
+        line_feed();
+}
+
+//------------------------------------------------------------------------------
+void mem_screen_buffer::line_feed()
+{
+    m_cursor_x = 0;
+    if (m_cursor_y < m_rows - 1)
+    {
+        ++m_cursor_y;
+        return;
+    }
+
+    // Scroll everything up a line.
+    ++m_scrolls;
+    for (int i = 0, n = m_columns * (m_rows - 1); i < n; ++i)
+        m_cells[i] = m_cells[i + m_columns];
+
+    fill(0, m_rows - 1, m_columns);
+}
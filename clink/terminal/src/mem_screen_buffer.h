@@ -0,0 +1,61 @@
+// Copyright (c) 2018 Martin Ridgers
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include "screen_buffer.h"
+
+#include <vector>
+
+class str_base;
+
+//------------------------------------------------------------------------------
+// A screen_buffer that's a grid of cells in memory. It behaves as the console
+// does (the cursor wraps as soon as the last column's written to and newlines
+// also return the cursor) so what's rendered can be checked without a console.
+class mem_screen_buffer
+    : public screen_buffer
+{
+public:
+                    mem_screen_buffer(int columns=80, int rows=25);
+    virtual void    begin() override;
+    virtual void    end() override;
+    virtual void    write(const char* data, int length) override;
+    virtual void    flush() override;
+    virtual int     get_columns() const override;
+    virtual int     get_rows() const override;
+    virtual void    clear(clear_type type) override;
+    virtual void    clear_line(clear_type type) override;
+    virtual void    set_cursor(int column, int row) override;
+    virtual void    move_cursor(int dx, int dy) override;
+    virtual void    insert_chars(int count) override;
+    virtual void    delete_chars(int count) override;
+    virtual void    set_attributes(const attributes attr) override;
+    void            resize(int columns, int rows);
+    int             get_cursor_column() const;
+    int             get_cursor_row() const;
+    void            get_line(int row, str_base& out) const;
+    attributes      get_cell_attributes(int column, int row) const;
+    unsigned int    get_call_count() const;
+    unsigned int    get_scroll_count() const;
+
+private:
+    struct cell
+    {
+        unsigned int    c;          // 0 = right half of a wide character
+        attributes      attr;
+    };
+
+    cell*           get_cell(int column, int row);
+    void            fill(int column, int row, int count);
+    void            write_char(int c);
+    void            line_feed();
+    std::vector<cell> m_cells;
+    attributes      m_attr;
+    int             m_columns;
+    int             m_rows;
+    int             m_cursor_x = 0;
+    int             m_cursor_y = 0;
+    unsigned int    m_calls = 0;
+    unsigned int    m_scrolls = 0;
+};
@@ -5,6 +5,7 @@
 #include "printer.h"
 #include "terminal_out.h"
 
+#include <core/base.h>
 #include <core/str.h>
 
 //------------------------------------------------------------------------------
@@ -13,6 +14,8 @@ printer::printer(terminal_out& terminal)
 , m_set_attr(attributes::defaults)
 , m_next_attr(attributes::defaults)
 {
+    for (auto& entry : m_sgr_cache)
+        entry.valid = false;
 }
 
 //------------------------------------------------------------------------------
@@ -35,6 +38,40 @@ void printer::print(const attributes attr, const char* data, int bytes)
     set_attributes(prev_attr);
 }
 
+//------------------------------------------------------------------------------
+void printer::print(const print_run* runs, int count)
+{
+    // The runs are gathered into one buffer and written in one go. Attributes
+    // are only emitted where they differ from the previous run's so adjacent
+    // runs that look the same are coalesced.
+    str<256> out;
+    attributes base_attr = m_next_attr;
+    for (int i = 0; i < count; ++i)
+    {
+        const print_run& run = runs[i];
+        if (run.bytes <= 0)
+            continue;
+
+        m_next_attr = attributes::merge(base_attr, run.attr);
+        if (m_next_attr != m_set_attr)
+            append_attributes(out);
+
+        if (run.data != nullptr)
+        {
+            out.concat(run.data, run.bytes);
+            continue;
+        }
+
+        static const char spaces[] = "                ";
+        for (int j = run.bytes; j > 0; j -= sizeof_array(spaces) - 1)
+            out.concat(spaces, min<int>(sizeof_array(spaces) - 1, j));
+    }
+
+    m_next_attr = base_attr;
+    if (!out.empty())
+        m_terminal.write(out.c_str(), out.length());
+}
+
 //------------------------------------------------------------------------------
 unsigned int printer::get_columns() const
 {
@@ -58,7 +95,51 @@ attributes printer::set_attributes(const attributes attr)
 //------------------------------------------------------------------------------
 void printer::flush_attributes()
 {
-    attributes diff = attributes::diff(m_set_attr, m_next_attr);
+    str<64, false> sgr;
+    append_attributes(sgr);
+    if (!sgr.empty())
+        m_terminal.write(sgr.c_str(), sgr.length());
+}
+
+//------------------------------------------------------------------------------
+void printer::append_attributes(str_base& out)
+{
+    // Formatting SGR parameters isn't free and the same few changes are made
+    // over and over (a prompt's colours on every redraw say), so the escape
+    // strings are kept keyed on the attributes they change between.
+    unsigned int hash = 2166136261;
+    auto hash_bytes = [&hash] (const attributes& attr) {
+        const unsigned char* bytes = (const unsigned char*)&attr;
+        for (int i = 0; i < int(sizeof(attr)); ++i)
+            hash = (hash ^ bytes[i]) * 16777619;
+    };
+
+    hash_bytes(m_set_attr);
+    hash_bytes(m_next_attr);
+
+    sgr_entry& entry = m_sgr_cache[hash % sizeof_array(m_sgr_cache)];
+    if (!entry.valid
+        || memcmp(&entry.from, &m_set_attr, sizeof(attributes)) != 0
+        || memcmp(&entry.to, &m_next_attr, sizeof(attributes)) != 0)
+    {
+        str_base sgr(entry.sgr);
+        sgr.clear();
+        format_sgr(m_set_attr, m_next_attr, sgr);
+
+        entry.from = m_set_attr;
+        entry.to = m_next_attr;
+        entry.length = (unsigned char)sgr.length();
+        entry.valid = true;
+    }
+
+    out.concat(entry.sgr, entry.length);
+    m_set_attr = m_next_attr;
+}
+
+//------------------------------------------------------------------------------
+void printer::format_sgr(const attributes from, const attributes to, str_base& out)
+{
+    attributes diff = attributes::diff(from, to);
 
     str<64, false> params;
     auto add_param = [&] (const char* x) {
@@ -67,9 +148,31 @@ void printer::flush_attributes()
         params << x;
     };
 
+    // 'base' is 30 for foreground colours and 40 for background ones.
+    auto add_colour = [&] (int base, const attributes::colour& colour) {
+        str<24, false> x;
+        if (colour.is_rgb)
+            x.format("%d;2;%d;%d;%d", base + 8, colour.r, colour.g, colour.b);
+        else if (colour.value < 8)
+            x.format("%d", base + colour.value);
+        else if (colour.value < 16)
+            x.format("%d", base + 60 + (colour.value & 0x07));
+        else
+            x.format("%d;5;%d", base + 8, colour.value);
+        add_param(x.c_str());
+    };
+
+    // A reset is the shortest way back to the defaults. It resets everything
+    // though so it's only used when that's where the attributes are going.
+    auto to_fg = to.get_fg();
+    auto to_bg = to.get_bg();
+    bool to_defaults = (to_fg.is_default & to_bg.is_default);
+    to_defaults &= !to.get_bold().value;
+    to_defaults &= !to.get_underline().value;
+
     auto fg = diff.get_fg();
     auto bg = diff.get_bg();
-    if (fg.is_default & bg.is_default)
+    if (to_defaults)
     {
         add_param("0");
     }
@@ -78,12 +181,7 @@ void printer::flush_attributes()
         if (fg)
         {
             if (!fg.is_default)
-            {
-                char x[] = "30";
-                x[0] += (fg->value > 7) ? 6 : 0;
-                x[1] += fg->value & 0x07;
-                add_param(x);
-            }
+                add_colour(30, fg.value);
             else
                 add_param("39");
         }
@@ -91,31 +189,24 @@ void printer::flush_attributes()
         if (bg)
         {
             if (!bg.is_default)
-            {
-                char x[] = "100";
-                x[1] += (bg->value > 7) ? 0 : 4;
-                x[2] += bg->value & 0x07;
-                add_param((bg->value > 7) ? x : x + 1);
-            }
+                add_colour(40, bg.value);
             else
                 add_param("49");
         }
-    }
 
-    if (auto bold = diff.get_bold())
-        add_param(bold.value ? "1" : "22");
+        if (auto bold = diff.get_bold())
+            add_param(bold.value ? "1" : "22");
 
-    if (auto underline = diff.get_underline())
-        add_param(underline.value ? "4" : "24");
+        if (auto underline = diff.get_underline())
+            add_param(underline.value ? "4" : "24");
+    }
 
     if (!params.empty())
     {
-        m_terminal.write("\x1b[");
-        m_terminal.write(params.c_str(), params.length());
-        m_terminal.write("m");
+        out << "\x1b[";
+        out << params;
+        out << "m";
     }
-
-    m_set_attr = m_next_attr;
 }
 
 //------------------------------------------------------------------------------
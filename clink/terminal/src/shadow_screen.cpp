@@ -0,0 +1,375 @@
+// Copyright (c) 2018 Martin Ridgers
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "shadow_screen.h"
+#include "printer.h"
+
+#include <core/base.h>
+#include <core/str_iter.h>
+
+extern "C" int wcwidth(int);
+
+//------------------------------------------------------------------------------
+// Unchanged cells shorter than this are rewritten rather than moved over.
+static const int max_span_gap = 4;
+
+
+
+//------------------------------------------------------------------------------
+void shadow_screen::reset()
+{
+    m_cursor = 0;
+    m_full = true;
+    m_valid = false;
+}
+
+//------------------------------------------------------------------------------
+const shadow_screen::frame& shadow_screen::get_front() const
+{
+    return m_frames[m_front];
+}
+
+//------------------------------------------------------------------------------
+int shadow_screen::get_cursor_row() const
+{
+    const frame& front = get_front();
+    return front.columns ? (m_cursor / front.columns) : 0;
+}
+
+//------------------------------------------------------------------------------
+int shadow_screen::get_cursor_column() const
+{
+    const frame& front = get_front();
+    return front.columns ? (m_cursor % front.columns) : 0;
+}
+
+//------------------------------------------------------------------------------
+int shadow_screen::get_row_count() const
+{
+    const frame& front = get_front();
+    if (!front.columns)
+        return 0;
+
+    int count = max<int>(int(front.cells.size()), m_cursor);
+    return (count / front.columns) + 1;
+}
+
+//------------------------------------------------------------------------------
+void shadow_screen::draw(
+    printer& printer,
+    const char* prompt,
+    const char* text,
+    int text_length,
+    int cursor)
+{
+    const frame& prev = m_frames[m_front];
+    frame& next = m_frames[m_front ^ 1];
+
+    next.columns = max<int>(printer.get_columns(), 2);
+    layout(next, prompt, text, text_length, cursor);
+
+    m_out.clear();
+
+    // A different prompt or screen width moves everything so it's all redrawn.
+    if (!m_full)
+        m_full = (prev.columns != next.columns) || !prev.prompt.equals(next.prompt.c_str());
+
+    bool full = m_full;
+    if (full)
+        write_prompt(next);
+
+    // Write the spans of cells that differ from the previous frame.
+    int count = int(next.cells.size());
+    for (int i = next.prompt_cells; i < count;)
+    {
+        if (!is_dirty(i))
+        {
+            ++i;
+            continue;
+        }
+
+        int end = i + 1;
+        for (int j = end; j < count && j - end < max_span_gap; ++j)
+            if (is_dirty(j))
+                end = j + 1;
+
+        write_span(next, i, end);
+        i = end;
+    }
+
+    // Clear what's left of the previous frame.
+    if (!full && int(prev.cells.size()) > count)
+    {
+        move_to(count, next.columns);
+        m_out << "\x1b[J";
+    }
+
+    move_to(next.cursor, next.columns);
+
+    m_front ^= 1;
+    m_full = false;
+    m_valid = true;
+
+    printer.print(m_out.c_str(), m_out.length());
+}
+
+//------------------------------------------------------------------------------
+void shadow_screen::layout(
+    frame& out,
+    const char* prompt,
+    const char* text,
+    int text_length,
+    int cursor)
+{
+    out.cells.clear();
+    out.chars.clear();
+    out.prompt.copy(prompt);
+    out.prompt_cells = 0;
+
+    // Bytes between 0x01 and 0x02 are invisible (escape sequences mostly) so
+    // they don't take up any cells.
+    bool visible = true;
+    for (const char* c = prompt; *c;)
+    {
+        switch (*c)
+        {
+        case '\x01':    visible = false;    ++c;    continue;
+        case '\x02':    visible = true;     ++c;    continue;
+        case '\r':                          ++c;    continue;
+        }
+
+        if (!visible)
+        {
+            ++c;
+            continue;
+        }
+
+        if (*c == '\n')
+        {
+            while (int(out.cells.size()) % out.columns)
+                add_cell(out, " ", 1, 1);
+
+            ++c;
+            continue;
+        }
+
+        c += add_char(out, c, int(strlen(c)));
+    }
+
+    out.prompt_cells = int(out.cells.size());
+    out.cursor = -1;
+
+    // Control characters are shown as ^X and tabs as spaces as Readline does.
+    for (int i = 0; i < text_length;)
+    {
+        if (i == cursor)
+            out.cursor = int(out.cells.size());
+
+        unsigned char c = text[i];
+        if (c == '\t')
+        {
+            do
+                add_cell(out, " ", 1, 1);
+            while (out.cells.size() & 7);
+        }
+        else if (c < 0x20 || c == 0x7f)
+        {
+            char caret[] = { '^', char(c ^ 0x40) };
+            add_cell(out, caret, 1, 1);
+            add_cell(out, caret + 1, 1, 1);
+        }
+        else
+        {
+            i += add_char(out, text + i, text_length - i);
+            continue;
+        }
+
+        ++i;
+    }
+
+    if (out.cursor < 0)
+        out.cursor = int(out.cells.size());
+}
+
+//------------------------------------------------------------------------------
+int shadow_screen::add_char(frame& out, const char* chars, int length)
+{
+    str_iter iter(chars, length);
+    int c = iter.next();
+    int bytes = max<int>(int(iter.get_pointer() - chars), 1);
+
+    int width = wcwidth(c);
+    if (width < 0)
+        width = 1;
+
+    // Zero width characters combine with the one before.
+    if (!width)
+    {
+        int lead = int(out.cells.size()) - 1;
+        while (lead > out.prompt_cells && !out.cells[lead].width)
+            --lead;
+
+        if (lead < out.prompt_cells || out.cells.empty())
+            return bytes;
+
+        cell& prev = out.cells[lead];
+        out.chars.concat(chars, bytes);
+        prev.length += bytes;
+        prev.key = ~0u;
+        if (prev.length <= sizeof(prev.key))
+        {
+            prev.key = 0;
+            memcpy(&prev.key, out.chars.c_str() + prev.offset, prev.length);
+        }
+
+        return bytes;
+    }
+
+    // Wide characters don't straddle the edge of the terminal.
+    if (width > 1 && (int(out.cells.size()) % out.columns) == out.columns - 1)
+        add_cell(out, " ", 1, 1);
+
+    add_cell(out, chars, bytes, width);
+    return bytes;
+}
+
+//------------------------------------------------------------------------------
+void shadow_screen::add_cell(frame& out, const char* chars, int length, int width)
+{
+    cell c = { ~0u, out.chars.length(), (unsigned char)length, (unsigned char)width };
+    if (length <= sizeof(c.key))
+    {
+        c.key = 0;
+        memcpy(&c.key, chars, length);
+    }
+
+    out.chars.concat(chars, length);
+    out.cells.push_back(c);
+
+    if (width > 1)
+        out.cells.push_back({ 0, out.chars.length(), 0, 0 });
+}
+
+//------------------------------------------------------------------------------
+bool shadow_screen::is_dirty(int index) const
+{
+    if (m_full)
+        return true;
+
+    const frame& prev = m_frames[m_front];
+    const frame& next = m_frames[m_front ^ 1];
+    if (unsigned(index) >= prev.cells.size())
+        return true;
+
+    unsigned int key = next.cells[index].key;
+    return (key != prev.cells[index].key || key == ~0u);
+}
+
+//------------------------------------------------------------------------------
+void shadow_screen::write_prompt(const frame& next)
+{
+    // Go back to where the previous frame started and clear everything from
+    // there down. After a reset the cursor's already at the start.
+    if (m_valid)
+    {
+        if (int row = get_cursor_row())
+        {
+            str<16> move;
+            move.format("\x1b[%dA", row);
+            m_out << move;
+        }
+
+        m_out << "\r\x1b[J";
+    }
+
+    bool visible = true;
+    for (const char* c = next.prompt.c_str(); *c; ++c)
+    {
+        switch (*c)
+        {
+        case '\x01':    visible = false;    continue;
+        case '\x02':    visible = true;     continue;
+        case '\r':                          continue;
+        case '\n':      if (visible) m_out << "\r"; break;
+        }
+
+        m_out.concat(c, 1);
+    }
+
+    m_cursor = next.prompt_cells;
+
+    // Some terminals wrap as soon as the last column's written and others when
+    // the next character is. The next cell's written to remove the ambiguity.
+    if (m_cursor && !(m_cursor % next.columns))
+        write_span(next, m_cursor, m_cursor);
+}
+
+//------------------------------------------------------------------------------
+void shadow_screen::write_span(const frame& next, int from, int to)
+{
+    int count = int(next.cells.size());
+    int columns = next.columns;
+
+    // Spans shouldn't start or end part way through a wide character.
+    while (from > 0 && from < count && !next.cells[from].width)
+        --from;
+
+    while (to < count && !next.cells[to].width)
+        ++to;
+
+    // Nor should they end in the last column (see write_prompt()).
+    if (to && !(to % columns))
+        for (++to; to < count && !next.cells[to].width; ++to);
+
+    if (m_cursor != from)
+        move_to(from, columns);
+
+    for (int i = from, n = min(to, count); i < n; ++i)
+    {
+        const cell& c = next.cells[i];
+        m_out.concat(next.chars.c_str() + c.offset, c.length);
+    }
+
+    if (to > count)
+        m_out << " ";
+
+    m_cursor = to;
+}
+
+//------------------------------------------------------------------------------
+void shadow_screen::move_to(int index, int columns)
+{
+    int row = index / columns;
+    int column = index % columns;
+    int cursor_row = m_cursor / columns;
+    int cursor_column = m_cursor % columns;
+
+    str<16> move;
+    if (row < cursor_row)
+    {
+        move.format("\x1b[%dA", cursor_row - row);
+        m_out << move;
+    }
+
+    // Newlines are used to go down so the terminal scrolls if it needs to.
+    for (; cursor_row < row; ++cursor_row, cursor_column = 0)
+        m_out << "\r\n";
+
+    if (column == cursor_column)
+        ;
+    else if (!column)
+        m_out << "\r";
+    else if (column == cursor_column - 1)
+        m_out << "\b";
+    else
+    {
+        if (column > cursor_column)
+            move.format("\x1b[%dC", column - cursor_column);
+        else
+            move.format("\x1b[%dD", cursor_column - column);
+        m_out << move;
+    }
+
+    m_cursor = index;
+}
@@ -4,21 +4,40 @@
 #include "pch.h"
 #include "terminal.h"
 #include "ecma48_terminal_out.h"
+#include "vt_terminal_out.h"
 #include "win_screen_buffer.h"
 #include "win_terminal_in.h"
 
 #include <core/base.h>
+#include <core/settings.h>
+
+//------------------------------------------------------------------------------
+static setting_bool g_terminal_emulate(
+    "terminal.emulate",
+    "Always emulate VT sequences",
+    "Clink's output is passed straight to consoles that understand VT\n"
+    "sequences. Other consoles have the sequences translated into console\n"
+    "API calls. When enabled the sequences are always translated.",
+    false);
 
 //------------------------------------------------------------------------------
 terminal terminal_create(screen_buffer* screen)
 {
 #if defined(PLATFORM_WINDOWS)
-    if (screen == nullptr)
-        screen = new win_screen_buffer(); // TODO: this leaks.
+    terminal_out* out;
+    if (screen == nullptr && !g_terminal_emulate.get() && vt_terminal_out::is_supported())
+        out = new vt_terminal_out();
+    else
+    {
+        if (screen == nullptr)
+            screen = new win_screen_buffer(); // TODO: this leaks.
+
+        out = new ecma48_terminal_out(*screen);
+    }
 
     return {
         new win_terminal_in(),
-        new ecma48_terminal_out(*screen),
+        out,
     };
 #else
     return {};
@@ -0,0 +1,114 @@
+// Copyright (c) 2016 Martin Ridgers
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "vt_terminal_out.h"
+
+#include <core/base.h>
+#include <core/str_iter.h>
+
+#include <Windows.h>
+
+#if !defined(ENABLE_VIRTUAL_TERMINAL_PROCESSING)
+#   define ENABLE_VIRTUAL_TERMINAL_PROCESSING 0x0004
+#endif
+
+//------------------------------------------------------------------------------
+bool vt_terminal_out::is_supported()
+{
+    // Older consoles refuse the mode.
+    HANDLE handle = GetStdHandle(STD_OUTPUT_HANDLE);
+    DWORD mode;
+    if (!GetConsoleMode(handle, &mode))
+        return false;
+
+    if (mode & ENABLE_VIRTUAL_TERMINAL_PROCESSING)
+        return true;
+
+    if (!SetConsoleMode(handle, mode|ENABLE_VIRTUAL_TERMINAL_PROCESSING))
+        return false;
+
+    SetConsoleMode(handle, mode);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+void vt_terminal_out::begin()
+{
+    m_handle = GetStdHandle(STD_OUTPUT_HANDLE);
+    GetConsoleMode(m_handle, &m_prev_mode);
+    SetConsoleMode(m_handle, m_prev_mode|ENABLE_PROCESSED_OUTPUT|ENABLE_VIRTUAL_TERMINAL_PROCESSING);
+
+    CONSOLE_SCREEN_BUFFER_INFO csbi;
+    GetConsoleScreenBufferInfo(m_handle, &csbi);
+    m_default_attr = csbi.wAttributes;
+}
+
+//------------------------------------------------------------------------------
+void vt_terminal_out::end()
+{
+    write_out();
+
+    SetConsoleTextAttribute(m_handle, m_default_attr);
+    SetConsoleMode(m_handle, m_prev_mode);
+    m_handle = nullptr;
+}
+
+//------------------------------------------------------------------------------
+void vt_terminal_out::write(const char* chars, int length)
+{
+    m_buffer.concat(chars, length);
+}
+
+//------------------------------------------------------------------------------
+void vt_terminal_out::flush()
+{
+    write_out();
+
+    // When writing to the console conhost.exe will restart the cursor blink
+    // timer and hide it which can be disorientating, especially when moving
+    // around a line. The below will make sure it stays visible.
+    CONSOLE_SCREEN_BUFFER_INFO csbi;
+    GetConsoleScreenBufferInfo(m_handle, &csbi);
+    SetConsoleCursorPosition(m_handle, csbi.dwCursorPosition);
+}
+
+//------------------------------------------------------------------------------
+void vt_terminal_out::write_out()
+{
+    const char* chars = m_buffer.c_str();
+    int length = m_buffer.length();
+
+    str_iter iter(chars, length);
+    while (length > 0)
+    {
+        wchar_t wbuf[1024];
+        int n = min<int>(sizeof_array(wbuf), length + 1);
+        n = to_utf16(wbuf, n, iter);
+
+        DWORD written;
+        WriteConsoleW(m_handle, wbuf, n, &written, nullptr);
+
+        n = int(iter.get_pointer() - chars);
+        length -= n;
+        chars += n;
+    }
+
+    m_buffer.clear();
+}
+
+//------------------------------------------------------------------------------
+int vt_terminal_out::get_columns() const
+{
+    CONSOLE_SCREEN_BUFFER_INFO csbi;
+    GetConsoleScreenBufferInfo(m_handle, &csbi);
+    return csbi.dwSize.X;
+}
+
+//------------------------------------------------------------------------------
+int vt_terminal_out::get_rows() const
+{
+    CONSOLE_SCREEN_BUFFER_INFO csbi;
+    GetConsoleScreenBufferInfo(m_handle, &csbi);
+    return (csbi.srWindow.Bottom - csbi.srWindow.Top) + 1;
+}
@@ -5,11 +5,17 @@
 
 #include "terminal_out.h"
 
+#include <core/str.h>
+
 //------------------------------------------------------------------------------
-class win_terminal_out
+// Passes output straight through to a console that understands VT sequences
+// itself (i.e. one with ENABLE_VIRTUAL_TERMINAL_PROCESSING). Output is buffered
+// until it's flushed.
+class vt_terminal_out
     : public terminal_out
 {
 public:
+    static bool     is_supported();
     virtual void    begin() override;
     virtual void    end() override;
     virtual void    write(const char* chars, int length) override;
@@ -18,7 +24,9 @@ public:
     virtual int     get_rows() const override;
 
 private:
-    void*           m_stdout = nullptr;
+    void            write_out();
+    str<1024>       m_buffer;
+    void*           m_handle = nullptr;
     unsigned long   m_prev_mode = 0;
     unsigned short  m_default_attr = 0x07;
 };
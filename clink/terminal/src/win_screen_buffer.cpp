@@ -267,7 +267,7 @@ void win_screen_buffer::set_attributes(const attributes attr)
     bool bold = m_bold;
     if (auto fg = attr.get_fg())
     {
-        int value = fg.is_default ? m_default_attr : swizzle(fg->value);
+        int value = fg.is_default ? m_default_attr : swizzle(fg->as_16());
         value &= attr_mask_fg;
         out_attr = (out_attr & attr_mask_bg) | value;
         bold |= (value > 7);
@@ -283,11 +283,12 @@ void win_screen_buffer::set_attributes(const attributes attr)
     // Background colour
     if (auto bg = attr.get_bg())
     {
-        int value = bg.is_default ? m_default_attr : (swizzle(bg->value) << 4);
+        int value = bg.is_default ? m_default_attr : (swizzle(bg->as_16()) << 4);
         out_attr = (out_attr & attr_mask_fg) | (value & attr_mask_bg);
     }
 
-    // TODO: add rgb/xterm256 support back.
+    // The console only has 16 colours. 256 colour and RGB values are mapped to
+    // whichever of those is nearest (see colour::as_16()).
 
     out_attr |= csbi.wAttributes & ~attr_mask_all;
     SetConsoleTextAttribute(m_handle, short(out_attr));
@@ -57,19 +57,13 @@ enum : unsigned char
     input_abort_byte    = 0xff,
     input_none_byte     = 0xfe,
     input_timeout_byte  = 0xfd,
+    input_resize_byte   = 0xfc,
 };
 
+// The most bytes a single key event can expand to (e.g. ESC + "\x1b[15;6~").
+static const int max_record_bytes = 16;
 
 
-//------------------------------------------------------------------------------
-static unsigned int get_dimensions()
-{
-    CONSOLE_SCREEN_BUFFER_INFO csbi;
-    GetConsoleScreenBufferInfo(GetStdHandle(STD_OUTPUT_HANDLE), &csbi);
-    auto cols = short(csbi.dwSize.X);
-    auto rows = short(csbi.srWindow.Bottom - csbi.srWindow.Top) + 1;
-    return (cols << 16) | rows;
-}
 
 //------------------------------------------------------------------------------
 static void set_cursor_visibility(bool state)
@@ -107,9 +101,23 @@ static void adjust_cursor_on_resize(COORD prev_position)
 void win_terminal_in::begin()
 {
     m_buffer_count = 0;
+    m_record_count = 0;
     m_stdin = GetStdHandle(STD_INPUT_HANDLE);
+
+    // Clear 'processed input' flag so key presses such as Ctrl-C and Ctrl-S
+    // aren't swallowed. We also want events about window size changes.
     GetConsoleMode(m_stdin, &m_prev_mode);
+    SetConsoleMode(m_stdin, ENABLE_WINDOW_INPUT);
     set_cursor_visibility(false);
+
+    // Resizes while the line wasn't being edited didn't arrive as input
+    // records so they're checked for here, once.
+    unsigned int dimensions = get_dimensions();
+    if (dimensions != m_dimensions)
+    {
+        m_dimensions = dimensions;
+        push_marker(input_resize_byte);
+    }
 }
 
 //------------------------------------------------------------------------------
@@ -121,21 +129,52 @@ void win_terminal_in::end()
 }
 
 //------------------------------------------------------------------------------
-void win_terminal_in::select()
+void win_terminal_in::select(int timeout)
 {
     if (!m_buffer_count)
-        read_console();
+        process_records();
+
+    if (m_buffer_count)
+        return;
+
+    if (timeout < 0)
+        return read_console();
+
+    // Give up waiting for input if the timeout expires. read() will then return
+    // an input_timeout so callers can do some work before selecting again.
+    // Records that don't make any input (key-ups, focus and mouse events) also
+    // end a wait, so waiting resumes for whatever time is left. Only records
+    // that are already queued are read so nothing here blocks.
+    DWORD start = GetTickCount();
+    while (!m_buffer_count)
+    {
+        DWORD elapsed = GetTickCount() - start;
+        DWORD remaining = (elapsed < DWORD(timeout)) ? DWORD(timeout) - elapsed : 0;
+        if (WaitForSingleObject(m_stdin, remaining) != WAIT_OBJECT_0)
+        {
+            push_marker(input_timeout_byte);
+            return;
+        }
+
+        if (read_queued_records() < 0)
+        {
+            // Handle's probably invalid if ReadConsoleInput() failed.
+            push_marker(input_abort_byte);
+            return;
+        }
+    }
 }
 
 //------------------------------------------------------------------------------
 int win_terminal_in::read()
 {
-    unsigned int dimensions = get_dimensions();
-    if (dimensions != m_dimensions)
-    {
-        m_dimensions = dimensions;
-        return terminal_in::input_terminal_resize;
-    }
+    if (!m_buffer_count)
+        process_records();
+
+    // Keep going with records that have arrived since the last read so callers
+    // reading until there's no input (e.g. to gather a paste) see all of what's
+    // queued and not just what was fetched in one go. Nothing here blocks.
+    while (!m_buffer_count && read_queued_records() > 0);
 
     if (!m_buffer_count)
         return terminal_in::input_none;
@@ -146,6 +185,7 @@ int win_terminal_in::read()
     case input_none_byte:       return terminal_in::input_none;
     case input_timeout_byte:    return terminal_in::input_timeout;
     case input_abort_byte:      return terminal_in::input_abort;
+    case input_resize_byte:     return terminal_in::input_terminal_resize;
     default:                    return c;
     }
 }
@@ -153,23 +193,71 @@ int win_terminal_in::read()
 //------------------------------------------------------------------------------
 void win_terminal_in::read_console()
 {
-    // Clear 'processed input' flag so key presses such as Ctrl-C and Ctrl-S
-    // aren't swallowed. We also want events about window size changes.
-    struct mode_scope {
-        HANDLE  handle;
-        DWORD   prev_mode;
-
-        mode_scope(HANDLE handle) : handle(handle)
+    // Read input records sent from the terminal (aka conhost) until some
+    // input has beeen buffered. Records are read in bulk and any that don't
+    // fit in the buffer are kept for later reads.
+    while (!m_buffer_count)
+    {
+        int count = read_records(m_records, sizeof_array(m_records));
+        if (count <= 0)
         {
-            GetConsoleMode(handle, &prev_mode);
-            SetConsoleMode(handle, ENABLE_WINDOW_INPUT);
+            // Handle's probably invalid if ReadConsoleInput() failed.
+            push_marker(input_abort_byte);
+            return;
         }
 
-        ~mode_scope()
+        m_record_head = 0;
+        m_record_count = count;
+        process_records();
+    }
+}
+
+//------------------------------------------------------------------------------
+// Reads and processes the records that are already queued without waiting for
+// more to arrive. Returns how many were read, or -1 if reading failed.
+int win_terminal_in::read_queued_records()
+{
+    if (m_record_count || !has_queued_records())
+        return 0;
+
+    int count = read_records(m_records, sizeof_array(m_records));
+    if (count < 0)
+        return -1;
+
+    m_record_head = 0;
+    m_record_count = count;
+    process_records();
+    return count;
+}
+
+//------------------------------------------------------------------------------
+int win_terminal_in::read_records(INPUT_RECORD* records, int max_count)
+{
+    HANDLE stdout_handle = GetStdHandle(STD_OUTPUT_HANDLE);
+
+    // Only dress the cursor up when there's a wait ahead. Records that are
+    // already queued (e.g. a paste) are read straight away.
+    CONSOLE_SCREEN_BUFFER_INFO csbi;
+    DWORD count = 0;
+    if (has_queued_records())
+    {
+        if (!ReadConsoleInputW(m_stdin, records, max_count, &count))
+            return -1;
+
+        // Resizes with input already queued are rare, so the cursor position
+        // is only fetched if one turns up.
+        for (DWORD i = 0; i < count; ++i)
         {
-            SetConsoleMode(handle, prev_mode);
+            if (records[i].EventType == WINDOW_BUFFER_SIZE_EVENT)
+            {
+                GetConsoleScreenBufferInfo(stdout_handle, &csbi);
+                adjust_cursor_on_resize(csbi.dwCursorPosition);
+                break;
+            }
         }
-    } _ms(m_stdin);
+
+        return int(count);
+    }
 
     // Hide the cursor unless we're accepting input so we don't have to see it
     // jump around as the screen's drawn.
@@ -181,26 +269,54 @@ void win_terminal_in::read_console()
     // Conhost restarts the cursor blink when writing to the console. It restarts
     // hidden which means that if you type faster than the blink the cursor turns
     // invisible. Fortunately, moving the cursor restarts the blink on visible.
-    HANDLE stdout_handle = GetStdHandle(STD_OUTPUT_HANDLE);
-    CONSOLE_SCREEN_BUFFER_INFO csbi;
     GetConsoleScreenBufferInfo(stdout_handle, &csbi);
     SetConsoleCursorPosition(stdout_handle, csbi.dwCursorPosition);
 
-    // Read input records sent from the terminal (aka conhost) until some
-    // input has beeen buffered.
-    unsigned int buffer_count = m_buffer_count;
-    while (buffer_count == m_buffer_count)
+    if (!ReadConsoleInputW(m_stdin, records, max_count, &count))
+        return -1;
+
+    for (DWORD i = 0; i < count; ++i)
     {
-        DWORD count;
-        INPUT_RECORD record;
-        if (!ReadConsoleInputW(m_stdin, &record, 1, &count))
+        if (records[i].EventType == WINDOW_BUFFER_SIZE_EVENT)
         {
-            // Handle's probably invalid if ReadConsoleInput() failed.
-            m_buffer_count = 1;
-            m_buffer[0] = input_abort_byte;
-            return;
+            // Windows will move the cursor onto a new line when it gets
+            // clipped on buffer resize. Other terminals clamp along the X axis.
+            adjust_cursor_on_resize(csbi.dwCursorPosition);
+            break;
         }
+    }
+
+    return int(count);
+}
+
+//------------------------------------------------------------------------------
+bool win_terminal_in::has_queued_records()
+{
+    DWORD pending = 0;
+    GetNumberOfConsoleInputEvents(m_stdin, &pending);
+    return (pending != 0);
+}
+
+//------------------------------------------------------------------------------
+unsigned int win_terminal_in::get_dimensions()
+{
+    CONSOLE_SCREEN_BUFFER_INFO csbi;
+    GetConsoleScreenBufferInfo(GetStdHandle(STD_OUTPUT_HANDLE), &csbi);
+    auto cols = short(csbi.dwSize.X);
+    auto rows = short(csbi.srWindow.Bottom - csbi.srWindow.Top) + 1;
+    return (cols << 16) | rows;
+}
 
+//------------------------------------------------------------------------------
+void win_terminal_in::process_records()
+{
+    // Drain as many records as the buffer has room for in one pass.
+    for (; m_record_count; ++m_record_head, --m_record_count)
+    {
+        if (m_buffer_count > sizeof_array(m_buffer) - max_record_bytes)
+            break;
+
+        INPUT_RECORD& record = m_records[m_record_head];
         switch (record.EventType)
         {
         case KEY_EVENT:
@@ -223,10 +339,19 @@ void win_terminal_in::read_console()
             break;
 
         case WINDOW_BUFFER_SIZE_EVENT:
-            // Windows will move the cursor onto a new line when it gets clipped
-            // on buffer resize. Other terminals
-            adjust_cursor_on_resize(csbi.dwCursorPosition);
-            return;
+            {
+                // Remember the new size so the next begin() doesn't report
+                // this resize again.
+                m_dimensions = get_dimensions();
+
+                // Dragging a window's edge sends a stream of these so they're
+                // coalesced into one resize.
+                unsigned int mask = sizeof_array(m_buffer) - 1;
+                unsigned int tail = (m_buffer_head + m_buffer_count - 1) & mask;
+                if (!m_buffer_count || m_buffer[tail] != input_resize_byte)
+                    push_marker(input_resize_byte);
+            }
+            break;
         }
     }
 }
@@ -268,8 +393,10 @@ void win_terminal_in::process_input(KEY_EVENT_RECORD const& record)
             key_flags &= ~LEFT_ALT_PRESSED;
     }
 
-    // Special case for shift-tab (aka. back-tab or kcbt).
-    if (key_char == '\t' && !m_buffer_count && (key_flags & SHIFT_PRESSED))
+    // Special case for shift-tab (aka. back-tab or kcbt). Records are read in
+    // bulk so earlier keys from the same read may still be buffered; that
+    // mustn't change what shift-tab sends.
+    if (key_char == '\t' && (key_flags & SHIFT_PRESSED))
         return push(terminfo::kcbt);
 
     // Function keys (kf1-kf48 from xterm+pcf2)
@@ -399,15 +526,29 @@ void win_terminal_in::push(unsigned int value)
     }
 
     wchar_t wc[2] = { (wchar_t)value, 0 };
-    char utf8[mask + 1];
+    char utf8[8];
     unsigned int n = to_utf8(utf8, sizeof_array(utf8), wc);
-    if (n <= unsigned(mask - m_buffer_count))
-        for (unsigned int i = 0; i < n; ++i, ++index)
-            m_buffer[index & mask] = utf8[i];
+    if (n > unsigned(sizeof_array(m_buffer) - m_buffer_count))
+        return;
+
+    for (unsigned int i = 0; i < n; ++i, ++index)
+        m_buffer[index & mask] = utf8[i];
 
     m_buffer_count += n;
 }
 
+//------------------------------------------------------------------------------
+void win_terminal_in::push_marker(unsigned char value)
+{
+    // Markers are bytes that can't appear in UTF-8 so they're not encoded.
+    if (m_buffer_count >= sizeof_array(m_buffer))
+        return;
+
+    int index = m_buffer_head + m_buffer_count;
+    m_buffer[index & (sizeof_array(m_buffer) - 1)] = value;
+    ++m_buffer_count;
+}
+
 //------------------------------------------------------------------------------
 unsigned char win_terminal_in::pop()
 {
@@ -12,19 +12,30 @@ class win_terminal_in
 public:
     virtual void    begin() override;
     virtual void    end() override;
-    virtual void    select() override;
+    virtual void    select(int timeout=-1) override;
     virtual int     read() override;
 
+protected:
+    virtual int     read_records(INPUT_RECORD* records, int max_count);
+    virtual bool    has_queued_records();
+    virtual unsigned int get_dimensions();
+
 private:
     void            read_console();
+    int             read_queued_records();
+    void            process_records();
     void            process_input(const KEY_EVENT_RECORD& key_event);
     void            push(unsigned int value);
     void            push(const char* seq);
+    void            push_marker(unsigned char value);
     unsigned char   pop();
     void*           m_stdin = nullptr;
     unsigned int    m_dimensions = 0;
     unsigned long   m_prev_mode = 0;
-    unsigned char   m_buffer_head = 0;
-    unsigned char   m_buffer_count = 0;
-    unsigned char   m_buffer[16]; // must be power of two.
+    unsigned short  m_record_head = 0;
+    unsigned short  m_record_count = 0;
+    unsigned short  m_buffer_head = 0;
+    unsigned short  m_buffer_count = 0;
+    unsigned char   m_buffer[256]; // must be power of two.
+    INPUT_RECORD    m_records[64];
 };
@@ -119,12 +119,12 @@ TEST_CASE("attributes : merge")
         if (pass)
         {
             unsigned char rgb[] = { 0, 127, 255, 0 };
-            REQUIRE(fg->r == rgb[0] >> 3);
-            REQUIRE(fg->g == rgb[1] >> 3);
-            REQUIRE(fg->b == rgb[2] >> 3);
-            REQUIRE(bg->r == rgb[1] >> 3);
-            REQUIRE(bg->g == rgb[2] >> 3);
-            REQUIRE(bg->b == rgb[3] >> 3);
+            REQUIRE(fg->r == rgb[0]);
+            REQUIRE(fg->g == rgb[1]);
+            REQUIRE(fg->b == rgb[2]);
+            REQUIRE(bg->r == rgb[1]);
+            REQUIRE(bg->g == rgb[2]);
+            REQUIRE(bg->b == rgb[3]);
         }
     });
 }
@@ -144,3 +144,31 @@ TEST_CASE("attributes : diff")
     REQUIRE(diff.get_fg()->value == 1);
     REQUIRE(!diff.get_bg());
 }
+
+TEST_CASE("attributes : extended colours")
+{
+    attributes attr;
+    attr.set_fg(196);
+    attr.set_bg(231);
+    REQUIRE(attr.get_fg()->value == 196);
+    REQUIRE(!attr.get_fg().is_default);
+    REQUIRE(!attr.get_bg().is_default);
+
+    unsigned char rgb[3];
+    attr.get_fg()->as_888(rgb);
+    REQUIRE((rgb[0] == 255) & (rgb[1] == 0) & (rgb[2] == 0));
+    REQUIRE(attr.get_fg()->as_16() == colour_light_red);
+    REQUIRE(attr.get_bg()->as_16() == colour_white);
+
+    attr.set_fg(244);
+    attr.get_fg()->as_888(rgb);
+    REQUIRE((rgb[0] == 128) & (rgb[1] == 128) & (rgb[2] == 128));
+    REQUIRE(attr.get_fg()->as_16() == colour_dark_grey);
+
+    attr.set_fg(3);
+    REQUIRE(attr.get_fg()->as_16() == colour_yellow);
+
+    attr.set_bg(0, 0, 150);
+    REQUIRE(attr.get_bg()->is_rgb);
+    REQUIRE(attr.get_bg()->as_16() == colour_blue);
+}
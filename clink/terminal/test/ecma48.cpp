@@ -4,6 +4,7 @@
 #include "pch.h"
 
 #include <core/base.h>
+#include <core/str.h>
 #include <terminal/ecma48_iter.h>
 
 #include <new>
@@ -364,3 +365,93 @@ TEST_CASE("ecma48 utf8")
     REQUIRE(csi.param_count == 0);
     REQUIRE(csi.final == 'z');
 }
+
+//------------------------------------------------------------------------------
+TEST_CASE("ecma48 chars (runs)")
+{
+    const ecma48_code* code;
+
+    // Runs of characters are found in bulk so try each alignment and length.
+    align_to(16) char buffer[96];
+    for (int offset = 0; offset < 16; ++offset)
+    {
+        for (int length = 1; length < 48; ++length)
+        {
+            char* input = buffer + offset;
+            memset(input, 'a', length);
+            input[length] = '\n';
+            input[length + 1] = '\0';
+
+            ecma48_iter iter(input, g_state);
+            code = &iter.next();
+            REQUIRE(code->get_type() == ecma48_code::type_chars);
+            REQUIRE(code->get_pointer() == input);
+            REQUIRE(code->get_length() == length);
+
+            code = &iter.next();
+            REQUIRE(code->get_type() == ecma48_code::type_c0);
+
+            // Bounded by a length instead.
+            new (&iter) ecma48_iter(input, g_state, length - (length > 1));
+            code = &iter.next();
+            REQUIRE(code->get_type() == ecma48_code::type_chars);
+            REQUIRE(code->get_length() == length - (length > 1));
+            REQUIRE(!iter.next());
+        }
+    }
+
+    // C1 codes part way through a run are characters.
+    ecma48_iter iter("ab\xc2\x9c" "cd\x1b[m", g_state);
+    code = &iter.next();
+    REQUIRE(code->get_type() == ecma48_code::type_chars);
+    REQUIRE(code->get_length() == 6);
+
+    code = &iter.next();
+    REQUIRE(code->get_type() == ecma48_code::type_c1);
+    REQUIRE(code->get_code() == ecma48_code::c1_csi);
+    REQUIRE(!iter.next());
+}
+
+//------------------------------------------------------------------------------
+TEST_CASE("ecma48 mixed")
+{
+    // Something like a coloured prompt and a page of a match list.
+    str<> prompt;
+    for (int i = 0; i < 32; ++i)
+        prompt << "\x1b[1;32mc:\\some\\directory\x1b[0m \x1b[33m(master)\x1b[0m > \r\n";
+
+    str<> matches;
+    for (int i = 0; i < 64; ++i)
+        matches << "\x1b[37mfile_\x1b[41;97mn\x1b[0;97mame_number_one.txt\x1b[0m  \x1b[37msome_directory\\\x1b[0m\n";
+
+    // And a long line of plain text, which is one run of characters.
+    str<> line;
+    for (int i = 0; i < 3000; ++i)
+        line.concat("echo %path% " + (i % 12), 1);
+
+    // Iterating by terminator and by length finds the same codes.
+    auto check = [] (const str_base& input, int expected_codes) {
+        ecma48_state state;
+        ecma48_state bounded_state;
+        ecma48_iter iter(input.c_str(), state);
+        ecma48_iter bounded_iter(input.c_str(), bounded_state, input.length());
+
+        int codes = 0;
+        while (const ecma48_code& code = iter.next())
+        {
+            const ecma48_code& bounded_code = bounded_iter.next();
+            REQUIRE(bounded_code);
+            REQUIRE(code.get_type() == bounded_code.get_type());
+            REQUIRE(code.get_length() == bounded_code.get_length());
+            REQUIRE(memcmp(code.get_pointer(), bounded_code.get_pointer(), code.get_length()) == 0);
+            ++codes;
+        }
+
+        REQUIRE(!bounded_iter.next());
+        REQUIRE(codes == expected_codes);
+    };
+
+    check(prompt, 32 * 10);
+    check(matches, 64 * 12);
+    check(line, 1);
+}
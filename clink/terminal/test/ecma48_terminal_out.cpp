@@ -0,0 +1,128 @@
+// Copyright (c) 2016 Martin Ridgers
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "ecma48_terminal_out.h"
+#include "screen_buffer.h"
+
+#include <core/str.h>
+
+//------------------------------------------------------------------------------
+// Counts the calls made to it (each would be at least one console API call for
+// a win_screen_buffer) and logs what they were.
+class counting_screen_buffer
+    : public screen_buffer
+{
+public:
+    virtual void    begin() override                            {}
+    virtual void    end() override                              {}
+    virtual void    write(const char* data, int length) override { add("", data, length); }
+    virtual void    flush() override                            {}
+    virtual int     get_columns() const override                { return 80; }
+    virtual int     get_rows() const override                   { return 25; }
+    virtual void    clear(clear_type type) override             { add("{J}"); }
+    virtual void    clear_line(clear_type type) override        { add("{K}"); }
+    virtual void    set_cursor(int column, int row) override    { add("{H}"); }
+    virtual void    insert_chars(int count) override            { add("{@}"); }
+    virtual void    delete_chars(int count) override            { add("{P}"); }
+    virtual void    set_attributes(const attributes attr) override { add("{m}"); }
+
+    virtual void move_cursor(int dx, int dy) override
+    {
+        str<32> move;
+        if (dx == INT_MIN)
+            move.format("{%s,%d}", "cr", dy);
+        else
+            move.format("{%d,%d}", dx, dy);
+        add(move.c_str());
+    }
+
+    void add(const char* op, const char* text=nullptr, int length=0)
+    {
+        log << op;
+        log.concat(text, length);
+        ++calls;
+    }
+
+    str<>           log;
+    int             calls = 0;
+};
+
+
+
+//------------------------------------------------------------------------------
+TEST_CASE("ecma48 terminal out")
+{
+    counting_screen_buffer screen;
+    ecma48_terminal_out out(screen);
+    out.begin();
+
+    auto write = [&] (const char* chars) { out.write(chars, int(strlen(chars))); };
+
+    SECTION("Text")
+    {
+        write("a");
+        write("b");
+        write("c\td");
+        REQUIRE(screen.calls == 0);
+
+        out.flush();
+        REQUIRE(screen.calls == 1);
+        REQUIRE(screen.log.equals("abc\td"));
+    }
+
+    SECTION("Attributes")
+    {
+        write("\x1b[31m");
+        write("\x1b[1m");
+        write("a");
+        write("\x1b[31mb");
+        write("\x1b[32mc\x1b[m");
+        out.flush();
+        REQUIRE(screen.log.equals("{m}ab{m}c{m}"));
+    }
+
+    SECTION("Cursor")
+    {
+        write("\x1b[D\x1b[D\x1b[2D");
+        write("\x1b[C\x1b[A\x1b[A");
+        write("x\r\x1b[D\x1b[3C\b");
+        out.flush();
+        REQUIRE(screen.log.equals("{-4,0}{1,-2}x{cr,0}{3,0}{-1,0}"));
+    }
+
+    SECTION("Flushed before other changes")
+    {
+        write("a\x1b[K");
+        write("\x1b[31m\x1b[D\x1b[P");
+        write("\x1b[1;1Hb");
+        REQUIRE(screen.log.equals("a{K}{-1,0}{m}{P}{H}"));
+    }
+
+    SECTION("Redraw")
+    {
+        // Something like Readline redrawing a line and listing coloured
+        // matches, a character or escape sequence at a time.
+        const char* prompt = "c:\\dir>";
+        for (const char* c = prompt; *c; ++c)
+            out.write(c, 1);
+
+        for (int i = 0; i < 10; ++i)
+        {
+            write("\r\n");
+            write("\x1b[32m");
+            for (const char* c = "match"; *c; ++c)
+                out.write(c, 1);
+            write("\x1b[0m");
+            write(" ");
+            write("\x1b[K");
+        }
+        out.flush();
+
+        // Unbuffered this is a call for each character, escape sequence and
+        // control code; 117 calls.
+        REQUIRE(screen.calls == 71);
+    }
+
+    out.end();
+}
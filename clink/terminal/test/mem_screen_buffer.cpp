@@ -0,0 +1,137 @@
+// Copyright (c) 2018 Martin Ridgers
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "ecma48_terminal_out.h"
+#include "mem_screen_buffer.h"
+
+#include <core/str.h>
+
+//------------------------------------------------------------------------------
+TEST_CASE("mem_screen_buffer")
+{
+    mem_screen_buffer screen(10, 4);
+    ecma48_terminal_out out(screen);
+    out.begin();
+
+    auto write = [&] (const char* chars) {
+        out.write(chars, int(strlen(chars)));
+        out.flush();
+    };
+
+    auto line_is = [&] (int row, const char* expected) {
+        str<> text;
+        screen.get_line(row, text);
+        return text.equals(expected);
+    };
+
+    SECTION("Text")
+    {
+        write("abc");
+        REQUIRE(line_is(0, "abc"));
+        REQUIRE(screen.get_cursor_column() == 3);
+
+        write("\rx\n\ty");
+        REQUIRE(line_is(0, "xbc"));
+        REQUIRE(line_is(1, "        y"));
+        REQUIRE(screen.get_cursor_row() == 1);
+    }
+
+    SECTION("Wrap and scroll")
+    {
+        write("0123456789");
+        REQUIRE(screen.get_cursor_row() == 1);
+        REQUIRE(screen.get_cursor_column() == 0);
+
+        write("a\nb\nc\nd");
+        REQUIRE(line_is(0, "a"));
+        REQUIRE(line_is(3, "d"));
+        REQUIRE(screen.get_scroll_count() == 1);
+    }
+
+    SECTION("Cursor")
+    {
+        write("abcdef\x1b[3D" "x");
+        REQUIRE(line_is(0, "abcxef"));
+
+        write("\x1b[2;3H" "y\x1b[A\x1b[5C" "z");
+        REQUIRE(line_is(0, "abcxef  z"));
+        REQUIRE(line_is(1, "  y"));
+    }
+
+    SECTION("Clear")
+    {
+        write("abcdef\nghijkl\nmnopqr\x1b[2A\x1b[4D");
+        REQUIRE(screen.get_cursor_column() == 2);
+
+        write("\x1b[K");
+        REQUIRE(line_is(0, "ab"));
+
+        write("\x1b[B\x1b[1K");
+        REQUIRE(line_is(1, "   jkl"));
+
+        write("\x1b[J");
+        REQUIRE(line_is(0, "ab"));
+        REQUIRE(line_is(1, ""));
+        REQUIRE(line_is(2, ""));
+
+        write("\x1b[2J");
+        REQUIRE(line_is(0, ""));
+    }
+
+    SECTION("Insert and delete")
+    {
+        write("abcdef\r\x1b[2C\x1b[2@");
+        REQUIRE(line_is(0, "ab  cdef"));
+
+        write("\x1b[3P");
+        REQUIRE(line_is(0, "abdef"));
+    }
+
+    SECTION("Attributes")
+    {
+        write("a\x1b[1;31mb\x1b[0mc");
+
+        attributes attr = screen.get_cell_attributes(1, 0);
+        REQUIRE(attr.get_bold().value);
+        REQUIRE(attr.get_fg()->value == 1);
+
+        attr = screen.get_cell_attributes(2, 0);
+        REQUIRE(attr.get_fg().is_default);
+
+        // xterm's 256 colour and 24-bit colour extensions.
+        write("\x1b[38;5;208md\x1b[48;2;1;2;3;1me\x1b[38;5mf");
+        attr = screen.get_cell_attributes(3, 0);
+        REQUIRE(!attr.get_fg()->is_rgb);
+        REQUIRE(attr.get_fg()->value == 208);
+
+        attr = screen.get_cell_attributes(4, 0);
+        REQUIRE(attr.get_bg()->is_rgb);
+        REQUIRE((attr.get_bg()->r == 1) & (attr.get_bg()->g == 2) & (attr.get_bg()->b == 3));
+        REQUIRE(attr.get_bold().value);
+
+        // A malformed one doesn't change anything.
+        REQUIRE(screen.get_cell_attributes(5, 0) == attr);
+    }
+
+    SECTION("Wide characters")
+    {
+        write("abcdefghi\xe4\xb8\x80");
+        REQUIRE(line_is(0, "abcdefghi"));
+        REQUIRE(line_is(1, "\xe4\xb8\x80"));
+        REQUIRE(screen.get_cursor_column() == 2);
+
+        write("\rx");
+        REQUIRE(line_is(1, "x"));
+    }
+
+    SECTION("Resize")
+    {
+        write("abcdef\nghijkl");
+        screen.resize(4, 2);
+        REQUIRE(screen.get_columns() == 4);
+        REQUIRE(line_is(0, "abcd"));
+        REQUIRE(line_is(1, "ghij"));
+        REQUIRE(screen.get_cursor_column() == 3);
+    }
+}
@@ -0,0 +1,231 @@
+// Copyright (c) 2018 Martin Ridgers
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "printer.h"
+#include "terminal_out.h"
+
+#include <core/base.h>
+#include <core/str.h>
+
+#include <vector>
+
+//------------------------------------------------------------------------------
+// Collects what's written to it and counts the writes. Long output is too
+// much for a str<> so a hash of it is kept too.
+class counting_terminal_out
+    : public terminal_out
+{
+public:
+    virtual void    begin() override                            {}
+    virtual void    end() override                              {}
+    virtual void    flush() override                            {}
+    virtual int     get_columns() const override                { return 80; }
+    virtual int     get_rows() const override                   { return 25; }
+
+    virtual void write(const char* chars, int length) override
+    {
+        if (capture)
+            out.concat(chars, length);
+
+        for (int i = 0; i < length; ++i)
+            hash = (hash ^ (unsigned char)chars[i]) * 16777619;
+
+        ++writes;
+    }
+
+    void reset()
+    {
+        out.clear();
+        hash = 2166136261;
+        writes = 0;
+    }
+
+    str<>           out;
+    unsigned int    hash = 2166136261;
+    int             writes = 0;
+    bool            capture = true;
+};
+
+
+
+//------------------------------------------------------------------------------
+TEST_CASE("printer runs")
+{
+    counting_terminal_out terminal;
+    printer printer(terminal);
+
+    attributes red;
+    red.set_fg(colour_red);
+
+    attributes bold;
+    bold.set_bold();
+
+    SECTION("Coalesce")
+    {
+        print_run runs[] = {
+            { red, "ab", 2 },
+            { red, "cd", 2 },
+            { attributes(), nullptr, 3 },
+            { bold, "ef", 2 },
+        };
+
+        printer.print(runs, sizeof_array(runs));
+        REQUIRE(terminal.writes == 1);
+        REQUIRE(terminal.out.equals("\x1b[31mabcd\x1b[0m   \x1b[1mef"));
+
+        // Attributes set by the runs don't stick, and going back to the
+        // defaults is a reset.
+        terminal.out.clear();
+        printer.print("x", 1);
+        REQUIRE(terminal.out.equals("\x1b[0mx"));
+
+        // Only what's changed is emitted otherwise; bold stays on here.
+        terminal.out.clear();
+        attributes bold_red = bold;
+        bold_red.set_fg(colour_red);
+        print_run more[] = {
+            { bold, "a", 1 },
+            { bold_red, "b", 1 },
+            { bold, "c", 1 },
+        };
+        printer.print(more, sizeof_array(more));
+        REQUIRE(terminal.out.equals("\x1b[1ma\x1b[31mb\x1b[39mc"));
+    }
+
+    SECTION("Padding")
+    {
+        print_run runs[] = {
+            { attributes(), nullptr, 40 },
+            { attributes(), "x", 1 },
+            { attributes(), nullptr, 0 },
+            { attributes(), "", 0 },
+        };
+
+        printer.print(runs, sizeof_array(runs));
+        REQUIRE(terminal.out.length() == 41);
+        REQUIRE(terminal.out.c_str()[39] == ' ');
+        REQUIRE(terminal.out.c_str()[40] == 'x');
+    }
+
+    SECTION("Extended colours")
+    {
+        attributes attr;
+        attr.set_fg(208);
+        attr.set_bg(12, 34, 56);
+        printer.print(attr, "a", 1);
+        REQUIRE(terminal.out.equals("\x1b[38;5;208;48;2;12;34;56ma"));
+
+        terminal.out.clear();
+        attr = bold;
+        attr.set_fg(colour_light_cyan);
+        attr.set_bg(colour_grey);
+        printer.print(attr, "b", 1);
+        REQUIRE(terminal.out.equals("\x1b[96;47;1mb"));
+    }
+
+    SECTION("Repaint")
+    {
+        // A prompt with a few 24-bit colour segments, printed repeatedly as a
+        // redraw would. After the first the escape strings come from a cache.
+        attributes segments[4];
+        segments[0].set_fg(255, 255, 255);
+        segments[0].set_bg(38, 139, 210);
+        segments[1].set_fg(38, 139, 210);
+        segments[1].set_bg(133, 153, 0);
+        segments[2].set_fg(0, 0, 0);
+        segments[2].set_bg(133, 153, 0);
+        segments[2].set_bold();
+        segments[3].set_fg(133, 153, 0);
+
+        print_run runs[] = {
+            { segments[0], " c:\\projects\\clink ", 20 },
+            { segments[1], "\xee\x82\xb0", 3 },
+            { segments[2], " master ", 8 },
+            { segments[3], "\xee\x82\xb0 ", 4 },
+        };
+
+        printer.print(runs, sizeof_array(runs));
+        printer.print("", 0);
+        str<> first;
+        first << terminal.out;
+
+        // Repaints come from the cache and match the first paint exactly, after
+        // the carriage return that resets the attributes to print it.
+        str<> expected;
+        expected << "\x1b[0m\r" << first;
+        for (int i = 0; i < 3; ++i)
+        {
+            terminal.reset();
+            printer.print("\r", 1);
+            printer.print(runs, sizeof_array(runs));
+            printer.print("", 0);
+            REQUIRE(terminal.out.equals(expected.c_str()), [&] () {
+                printf("repaint %d; %s\n", i, terminal.out.c_str());
+            });
+        }
+
+        REQUIRE(strstr(first.c_str(), "\x1b[38;2;255;255;255;48;2;38;139;210m") == first.c_str());
+    }
+
+    SECTION("Match list")
+    {
+        // Rows of matches as tab completion prints them; three differently
+        // coloured fragments per match and padding between columns.
+        attributes minor, major, highlight;
+        minor.set_fg(colour_grey);
+        major.set_fg(colour_white);
+        highlight.set_fg(colour_white);
+        highlight.set_bg(colour_red);
+
+        static const int match_count = 2000;
+        static const int columns = 6;
+        str<16> matches[columns];
+        for (int i = 0; i < columns; ++i)
+            matches[i].format("%04d_match", i * 17);
+
+        terminal.capture = false;
+
+        // One print() call per fragment.
+        for (int i = 0; i < match_count; i += columns)
+        {
+            for (int x = 0; x < columns; ++x)
+            {
+                const char* match = matches[x].c_str();
+                printer.print(minor, match, 2);
+                printer.print(highlight, match + 2, 1);
+                printer.print(major, match + 3, 7);
+                if (x < columns - 1)
+                    printer.print("  ", 2);
+            }
+            printer.print("\n", 1);
+        }
+
+        int fragment_writes = terminal.writes;
+        unsigned int fragment_hash = terminal.hash;
+
+        // One list of runs per row.
+        terminal.reset();
+        std::vector<print_run> runs;
+        for (int i = 0; i < match_count; i += columns)
+        {
+            runs.clear();
+            for (int x = 0; x < columns; ++x)
+            {
+                const char* match = matches[x].c_str();
+                runs.push_back({ minor, match, 2 });
+                runs.push_back({ highlight, match + 2, 1 });
+                runs.push_back({ major, match + 3, 7 });
+                if (x < columns - 1)
+                    runs.push_back({ attributes(), nullptr, 2 });
+            }
+            runs.push_back({ attributes(), "\n", 1 });
+            printer.print(runs.data(), int(runs.size()));
+        }
+
+        int run_writes = terminal.writes;
+        REQUIRE(terminal.hash == fragment_hash);
+        REQUIRE(run_writes == (match_count + columns - 1) / columns);
+        REQUIRE(run_writes * 10 < fragment_writes);
+    }
+}
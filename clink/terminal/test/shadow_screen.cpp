@@ -0,0 +1,139 @@
+// Copyright (c) 2018 Martin Ridgers
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "printer.h"
+#include "shadow_screen.h"
+#include "terminal_out.h"
+
+#include <core/str.h>
+
+//------------------------------------------------------------------------------
+// Collects what's written to it so it can be compared with what's expected.
+class capture_terminal_out
+    : public terminal_out
+{
+public:
+    virtual void    begin() override                            {}
+    virtual void    end() override                              {}
+    virtual void    write(const char* chars, int length) override { out.concat(chars, length); total += length; }
+    virtual void    flush() override                            {}
+    virtual int     get_columns() const override                { return columns; }
+    virtual int     get_rows() const override                   { return 25; }
+
+    str<>           out;
+    int             total = 0;
+    int             columns = 80;
+};
+
+
+
+//------------------------------------------------------------------------------
+TEST_CASE("shadow_screen")
+{
+    capture_terminal_out terminal;
+    printer printer(terminal);
+    shadow_screen screen;
+
+    auto draw = [&] (const char* prompt, const char* text, int cursor=-1) {
+        int length = int(strlen(text));
+        terminal.out.clear();
+        screen.draw(printer, prompt, text, length, (cursor < 0) ? length : cursor);
+        return terminal.out.c_str();
+    };
+
+    REQUIRE(str<>(draw("> ", "")).equals("> "));
+
+    SECTION("Append")
+    {
+        REQUIRE(str<>(draw("> ", "a")).equals("a"));
+        REQUIRE(str<>(draw("> ", "ab")).equals("b"));
+        REQUIRE(str<>(draw("> ", "ab")).equals(""));
+    }
+
+    SECTION("Cursor")
+    {
+        draw("> ", "abc");
+        REQUIRE(str<>(draw("> ", "abc", 1)).equals("\x1b[2D"));
+        REQUIRE(str<>(draw("> ", "abc", 0)).equals("\b"));
+        REQUIRE(str<>(draw("> ", "abc", 3)).equals("\x1b[3C"));
+    }
+
+    SECTION("Insert")
+    {
+        draw("> ", "abc", 1);
+        REQUIRE(str<>(draw("> ", "aXbc", 2)).equals("Xbc\x1b[2D"));
+    }
+
+    SECTION("Delete")
+    {
+        draw("> ", "abc");
+        REQUIRE(str<>(draw("> ", "ab")).equals("\b\x1b[J"));
+        REQUIRE(str<>(draw("> ", "b", 0)).equals("\x1b[2Db\x1b[J\b"));
+    }
+
+    SECTION("Wrap")
+    {
+        terminal.columns = 10;
+        screen.reset();
+        draw("> ", "abcdefg");
+
+        // The space removes the ambiguity of where the cursor is.
+        REQUIRE(str<>(draw("> ", "abcdefgh")).equals("h \r"));
+        REQUIRE(str<>(draw("> ", "abcdefghi")).equals("i"));
+        REQUIRE(screen.get_cursor_row() == 1);
+        REQUIRE(screen.get_row_count() == 2);
+
+        REQUIRE(str<>(draw("> ", "abcdefgh", 0)).equals("\r\x1b[J\x1b[1A\x1b[2C"));
+    }
+
+    SECTION("Prompt")
+    {
+        draw("> ", "ab");
+        REQUIRE(str<>(draw("$ ", "ab")).equals("\r\x1b[J$ ab"));
+        REQUIRE(str<>(draw("\x01\x1b[1m\x02$\x01\x1b[m\x02 ", "ab")).equals("\r\x1b[J\x1b[1m$\x1b[m ab"));
+        REQUIRE(str<>(draw("\x01\x1b[1m\x02$\x01\x1b[m\x02 ", "abc")).equals("c"));
+        REQUIRE(str<>(draw("1\n2 ", "ab")).equals("\r\x1b[J1\r\n2 ab"));
+        REQUIRE(screen.get_cursor_row() == 1);
+        REQUIRE(str<>(draw("> ", "ab")).equals("\x1b[1A\r\x1b[J> ab"));
+    }
+
+    SECTION("Bytes per key")
+    {
+        // A long line that wraps a few times, typing at its end and then in
+        // the middle of it.
+        static const char prompt[] = "c:\\some\\long\\path\\to\\a\\directory> ";
+        draw(prompt, "");
+
+        str<> line;
+        terminal.total = 0;
+        for (int i = 0; i < 400; ++i)
+        {
+            char c = "echo %path%;"[i % 12];
+            line.concat(&c, 1);
+            draw(prompt, line.c_str());
+        }
+
+        int at_end = terminal.total;
+
+        // One byte per key and a " \r" each time the line wraps.
+        REQUIRE(at_end == 400 + (5 * 2));
+
+        terminal.total = 0;
+        int cursor = 200;
+        for (int i = 0; i < 50; ++i, ++cursor)
+        {
+            str<> next;
+            next.concat(line.c_str(), cursor);
+            next << "x";
+            next << (line.c_str() + cursor);
+            line.copy(next.c_str());
+            draw(prompt, line.c_str(), cursor + 1);
+        }
+
+        int in_middle = terminal.total;
+
+        // Everything after the cursor plus moving the cursor back.
+        REQUIRE(in_middle < 50 * (200 + 16));
+    }
+}
@@ -0,0 +1,61 @@
+// Copyright (c) 2018 Martin Ridgers
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+
+extern "C" int wcwidth(int);
+
+//------------------------------------------------------------------------------
+TEST_CASE("wcwidth")
+{
+    SECTION("ASCII")
+    {
+        REQUIRE(wcwidth(0) == 0);
+        REQUIRE(wcwidth('\t') == -1);
+        REQUIRE(wcwidth(0x1b) == -1);
+        REQUIRE(wcwidth(' ') == 1);
+        REQUIRE(wcwidth('a') == 1);
+        REQUIRE(wcwidth('~') == 1);
+        REQUIRE(wcwidth(0x7f) == -1);
+    }
+
+    SECTION("Controls")
+    {
+        REQUIRE(wcwidth(0x80) == -1);
+        REQUIRE(wcwidth(0x9b) == -1);
+        REQUIRE(wcwidth(0xa0) == 1);
+        REQUIRE(wcwidth(-1) == -1);
+    }
+
+    SECTION("Zero width")
+    {
+        REQUIRE(wcwidth(0x0301) == 0);      // combining acute accent
+        REQUIRE(wcwidth(0x20dd) == 0);      // combining enclosing circle
+        REQUIRE(wcwidth(0x200b) == 0);      // zero width space
+        REQUIRE(wcwidth(0x200d) == 0);      // zero width joiner
+        REQUIRE(wcwidth(0xfe0f) == 0);      // variation selector-16
+        REQUIRE(wcwidth(0x1160) == 0);      // Hangul Jamo medial vowel
+        REQUIRE(wcwidth(0xd7b0) == 0);
+        REQUIRE(wcwidth(0xe0020) == 0);     // tag space
+        REQUIRE(wcwidth(0x00ad) == 1);      // soft hyphen
+    }
+
+    SECTION("Wide")
+    {
+        REQUIRE(wcwidth(0x1100) == 2);      // Hangul Jamo initial consonant
+        REQUIRE(wcwidth(0x4e00) == 2);
+        REQUIRE(wcwidth(0xac00) == 2);
+        REQUIRE(wcwidth(0xff01) == 2);      // full-width exclamation mark
+        REQUIRE(wcwidth(0x1f600) == 2);     // grinning face
+        REQUIRE(wcwidth(0x1f680) == 2);     // rocket
+        REQUIRE(wcwidth(0x2fffd) == 2);
+        REQUIRE(wcwidth(0x303f) == 1);
+        REQUIRE(wcwidth(0xff61) == 1);      // half-width full stop
+    }
+
+    SECTION("Out of range")
+    {
+        REQUIRE(wcwidth(0x10ffff) == 1);
+        REQUIRE(wcwidth(0x110000) == 1);
+    }
+}
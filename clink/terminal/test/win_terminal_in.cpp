@@ -0,0 +1,206 @@
+// Copyright (c) 2018 Martin Ridgers
+// License: http://opensource.org/licenses/MIT
+
+#include "pch.h"
+#include "terminal_in.h"
+#include "win_terminal_in.h"
+
+#include <core/str.h>
+
+#include <vector>
+
+//------------------------------------------------------------------------------
+// Feeds canned input records to win_terminal_in instead of reading them from
+// the console, counting how many reads it took.
+class fake_terminal_in
+    : public win_terminal_in
+{
+public:
+    void add_key(wchar_t c, int flags=0)
+    {
+        INPUT_RECORD record = {};
+        record.EventType = KEY_EVENT;
+        record.Event.KeyEvent.bKeyDown = TRUE;
+        record.Event.KeyEvent.wRepeatCount = 1;
+        record.Event.KeyEvent.uChar.UnicodeChar = c;
+        record.Event.KeyEvent.dwControlKeyState = flags;
+        m_records.push_back(record);
+
+        record.Event.KeyEvent.bKeyDown = FALSE;
+        m_records.push_back(record);
+    }
+
+    void add_resize()
+    {
+        INPUT_RECORD record = {};
+        record.EventType = WINDOW_BUFFER_SIZE_EVENT;
+        m_records.push_back(record);
+    }
+
+    virtual int read_records(INPUT_RECORD* records, int max_count) override
+    {
+        if (m_next >= int(m_records.size()))
+            return -1;
+
+        int count = min(max_count, int(m_records.size()) - m_next);
+        memcpy(records, m_records.data() + m_next, count * sizeof(*records));
+        m_next += count;
+        ++reads;
+        return count;
+    }
+
+    virtual bool has_queued_records() override
+    {
+        return (m_next < int(m_records.size()));
+    }
+
+    int get_record_count() const
+    {
+        return int(m_records.size());
+    }
+
+    virtual unsigned int get_dimensions() override
+    {
+        return dimensions;
+    }
+
+    int                         reads = 0;
+    unsigned int                dimensions = (80 << 16) | 25;
+
+private:
+    std::vector<INPUT_RECORD>   m_records;
+    int                         m_next = 0;
+};
+
+
+
+//------------------------------------------------------------------------------
+TEST_CASE("win_terminal_in")
+{
+    fake_terminal_in in;
+
+    auto read_all = [&] (str_base& out) {
+        while (true)
+        {
+            in.select();
+            int c = in.read();
+            if (c == terminal_in::input_abort)
+                break;
+
+            if (c == terminal_in::input_terminal_resize)
+                out << "{resize}";
+            else if (c >= 0)
+                out.concat((const char*)&c, 1);
+        }
+    };
+
+    SECTION("Keys")
+    {
+        in.add_key('a');
+        in.add_key(0xe9);
+        in.add_key('b');
+
+        str<> out;
+        read_all(out);
+        REQUIRE(out.equals("a\xc3\xa9" "b"));
+        REQUIRE(in.reads == 1);
+    }
+
+    SECTION("Resize")
+    {
+        in.add_key('a');
+        in.add_resize();
+        in.add_resize();
+        in.add_resize();
+        in.add_key('b');
+        in.add_resize();
+
+        str<> out;
+        read_all(out);
+        REQUIRE(out.equals("a{resize}b{resize}"));
+    }
+
+    SECTION("Resize between lines")
+    {
+        // The first line always checks the size.
+        str<> out;
+        in.begin();
+        read_all(out);
+        in.end();
+        REQUIRE(out.equals("{resize}"));
+
+        in.add_key('a');
+        in.add_resize();
+        in.add_key('b');
+
+        out.clear();
+        in.begin();
+        in.dimensions = (100 << 16) | 25;
+        read_all(out);
+        in.end();
+        REQUIRE(out.equals("a{resize}b"));
+
+        // The resize was reported as it happened so the next line mustn't see
+        // it as a change.
+        out.clear();
+        in.begin();
+        read_all(out);
+        in.end();
+        REQUIRE(out.empty());
+    }
+
+    SECTION("Shift-tab")
+    {
+        // Still a back-tab when it follows other keys in the same read.
+        in.add_key('a');
+        in.add_key('\t', SHIFT_PRESSED);
+        in.add_key('\t');
+
+        str<> out;
+        read_all(out);
+        REQUIRE(out.equals("a\x1b[Z\t"));
+        REQUIRE(in.reads == 1);
+    }
+
+    SECTION("Queued")
+    {
+        // Reading without selecting picks up records that are queued but
+        // weren't fetched yet, so a burst of input can be read in one go.
+        str<> expected;
+        for (int i = 0; i < 100; ++i)
+        {
+            char c = 'a' + (i % 26);
+            in.add_key(c);
+            expected.concat(&c, 1);
+        }
+
+        in.select();
+
+        str<> out;
+        for (int c; (c = in.read()) >= 0;)
+            out.concat((const char*)&c, 1);
+
+        REQUIRE(out.equals(expected.c_str()));
+        REQUIRE(in.reads > 1);
+    }
+
+    SECTION("Paste")
+    {
+        // Something like pasting a 10KB script.
+        str<> expected;
+        for (int i = 0; i < 10 * 1024; ++i)
+        {
+            char c = "echo %path%\n"[i % 12];
+            in.add_key(c);
+            expected.concat(&c, 1);
+        }
+
+        str<> out;
+        read_all(out);
+        REQUIRE(out.equals(expected.c_str()));
+
+        // Records are read a full record buffer (64) at a time rather than one
+        // per read.
+        REQUIRE(in.reads == (in.get_record_count() + 63) / 64);
+    }
+}
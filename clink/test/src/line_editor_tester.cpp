@@ -5,11 +5,40 @@
 #include "line_editor_tester.h"
 
 #include <core/base.h>
+#include <core/str.h>
 #include <lib/editor_module.h>
 #include <lib/matches.h>
 
 #include <stdio.h>
 
+//------------------------------------------------------------------------------
+void test_terminal_in::set_resize(mem_screen_buffer* screen, int columns, int rows)
+{
+    m_screen = screen;
+    m_columns = columns;
+    m_rows = rows;
+}
+
+//------------------------------------------------------------------------------
+int test_terminal_in::read()
+{
+    if (!has_input())
+        return input_none;
+
+    int c = *(unsigned char*)m_read++;
+    if (c != (unsigned char)(DO_RESIZE[0]) || m_screen == nullptr)
+        return c;
+
+    int columns = m_screen->get_columns();
+    int rows = m_screen->get_rows();
+    m_screen->resize(m_columns, m_rows);
+    m_columns = columns;
+    m_rows = rows;
+    return input_terminal_resize;
+}
+
+
+
 //------------------------------------------------------------------------------
 class empty_module
     : public editor_module
@@ -71,12 +100,14 @@ void test_module::on_input(const input&, result& result, const context& context)
 
 //------------------------------------------------------------------------------
 line_editor_tester::line_editor_tester()
+: m_terminal_out(m_screen)
 {
     create_line_editor();
 }
 
 //------------------------------------------------------------------------------
 line_editor_tester::line_editor_tester(const line_editor::desc& desc)
+: m_terminal_out(m_screen)
 {
     create_line_editor(&desc);
 }
@@ -99,6 +130,7 @@ void line_editor_tester::create_line_editor(const line_editor::desc* desc)
 line_editor_tester::~line_editor_tester()
 {
     line_editor_destroy(m_editor);
+    delete m_match_catch;
 }
 
 //------------------------------------------------------------------------------
@@ -107,12 +139,24 @@ line_editor* line_editor_tester::get_editor() const
     return m_editor;
 }
 
+//------------------------------------------------------------------------------
+mem_screen_buffer& line_editor_tester::get_screen()
+{
+    return m_screen;
+}
+
 //------------------------------------------------------------------------------
 void line_editor_tester::set_input(const char* input)
 {
     m_input = input;
 }
 
+//------------------------------------------------------------------------------
+void line_editor_tester::set_resize(int columns, int rows)
+{
+    m_terminal_in.set_resize(&m_screen, columns, rows);
+}
+
 //------------------------------------------------------------------------------
 void line_editor_tester::set_expected_output(const char* expected)
 {
@@ -122,16 +166,19 @@ void line_editor_tester::set_expected_output(const char* expected)
 //------------------------------------------------------------------------------
 void line_editor_tester::run()
 {
-    bool has_expectations = m_has_matches || (m_expected_output != nullptr);
+    bool has_expectations = m_has_matches || m_has_screen || (m_expected_output != nullptr);
     REQUIRE(has_expectations);
 
     REQUIRE(m_input != nullptr);
     m_terminal_in.set_input(m_input);
 
     // If we're expecting some matches then add a module to catch the
-    // matches object.
-    test_module match_catch;
-    m_editor->add_module(match_catch);
+    // matches object. It's added once and kept for any further runs.
+    if (m_match_catch == nullptr)
+    {
+        m_match_catch = new test_module();
+        m_editor->add_module(*m_match_catch);
+    }
 
     // First update doesn't read input. We do however want to read at least one
     // character before bailing on the loop.
@@ -144,7 +191,7 @@ void line_editor_tester::run()
 
     if (m_has_matches)
     {
-        const matches* matches = match_catch.get_matches();
+        const matches* matches = m_match_catch->get_matches();
         REQUIRE(matches != nullptr);
 
         unsigned int match_count = matches->get_match_count();
@@ -190,9 +237,30 @@ void line_editor_tester::run()
         });
     }
 
+    // Check what's on the screen. Rows past those expected should be empty.
+    if (m_has_screen)
+    {
+        for (int i = 0, n = m_screen.get_rows(); i < n; ++i)
+        {
+            str<> row;
+            m_screen.get_line(i, row);
+
+            const char* expected = (i < int(m_expected_screen.size())) ? m_expected_screen[i] : "";
+            REQUIRE(row.equals(expected), [&] () {
+                printf("       input; %s#\n", m_input);
+                printf("         row; %d\n", i);
+                printf("row expected; %s#\n", expected);
+                printf("     row got; %s#\n", row.c_str());
+            });
+        }
+    }
+
     m_input = nullptr;
     m_expected_output = nullptr;
     m_expected_matches.clear();
+    m_expected_screen.clear();
+    m_has_matches = false;
+    m_has_screen = false;
 
     char t;
     m_editor->get_line(&t, 1);
@@ -212,3 +280,18 @@ void line_editor_tester::expected_matches_impl(int dummy, ...)
     va_end(arg);
     m_has_matches = true;
 }
+
+//------------------------------------------------------------------------------
+void line_editor_tester::expected_screen_impl(int dummy, ...)
+{
+    m_expected_screen.clear();
+
+    va_list arg;
+    va_start(arg, dummy);
+
+    while (const char* row = va_arg(arg, const char*))
+        m_expected_screen.push_back(row);
+
+    va_end(arg);
+    m_has_screen = true;
+}
@@ -3,15 +3,20 @@
 
 #pragma once
 
+#include "ecma48_terminal_out.h"
+#include "mem_screen_buffer.h"
+
 #include <lib/line_editor.h>
 #include <lib/line_buffer.h>
 #include <terminal/terminal_in.h>
-#include <terminal/terminal_out.h>
 
 #include <vector>
 
+class test_module;
+
 //------------------------------------------------------------------------------
 #define DO_COMPLETE "\x01"
+#define DO_RESIZE   "\xfc" // swaps the screen's size with set_resize()'s
 
 //------------------------------------------------------------------------------
 class test_terminal_in
@@ -20,28 +25,18 @@ class test_terminal_in
 public:
     bool                    has_input() const { return (m_read == nullptr) ? false : (*m_read != '\0'); }
     void                    set_input(const char* input) { m_input = m_read = input; }
+    void                    set_resize(mem_screen_buffer* screen, int columns, int rows);
     virtual void            begin() override {}
     virtual void            end() override {}
-    virtual void            select() override {}
-    virtual int             read() override { return *(unsigned char*)m_read++; }
+    virtual void            select(int timeout) override {}
+    virtual int             read() override;
 
 private:
     const char*             m_input = nullptr;
     const char*             m_read = nullptr;
-};
-
-//------------------------------------------------------------------------------
-class test_terminal_out
-    : public terminal_out
-{
-public:
-    virtual void            begin() override {}
-    virtual void            end() override {}
-    virtual void            write(const char* chars, int length) override {}
-    virtual void            flush() override {}
-    virtual int             get_columns() const override { return 80; }
-    virtual int             get_rows() const override { return 25; }
-    virtual void            set_attributes(const attributes attr) {}
+    mem_screen_buffer*      m_screen = nullptr;
+    int                     m_columns = 0;
+    int                     m_rows = 0;
 };
 
 
@@ -54,21 +49,29 @@ public:
                                 line_editor_tester(const line_editor::desc& desc);
                                 ~line_editor_tester();
     line_editor*                get_editor() const;
+    mem_screen_buffer&          get_screen();
     void                        set_input(const char* input);
+    void                        set_resize(int columns, int rows);
     template <class ...T> void  set_expected_matches(T... t); // T must be const char*
+    template <class ...T> void  set_expected_screen(T... t); // rows from the top
     void                        set_expected_output(const char* expected);
     void                        run();
 
 private:
     void                        create_line_editor(const line_editor::desc* desc=nullptr);
     void                        expected_matches_impl(int dummy, ...);
+    void                        expected_screen_impl(int dummy, ...);
     test_terminal_in            m_terminal_in;
-    test_terminal_out           m_terminal_out;
+    mem_screen_buffer           m_screen;
+    ecma48_terminal_out         m_terminal_out;
     std::vector<const char*>    m_expected_matches;
+    std::vector<const char*>    m_expected_screen;
     const char*                 m_input = nullptr;
     const char*                 m_expected_output = nullptr;
     line_editor*                m_editor = nullptr;
+    test_module*                m_match_catch = nullptr;
     bool                        m_has_matches = false;
+    bool                        m_has_screen = false;
 };
 
 //------------------------------------------------------------------------------
@@ -77,3 +80,10 @@ void line_editor_tester::set_expected_matches(T... t)
 {
     expected_matches_impl(0, t..., nullptr);
 }
+
+//------------------------------------------------------------------------------
+template <class ...T>
+void line_editor_tester::set_expected_screen(T... t)
+{
+    expected_screen_impl(0, t..., nullptr);
+}
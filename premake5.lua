@@ -308,7 +308,11 @@ clink_exe("clink_test")
     includedirs("clink/lib/src")
     includedirs("clink/lua/include")
     includedirs("clink/terminal/include")
+    includedirs("clink/terminal/include/terminal")
+    includedirs("clink/terminal/src")
     includedirs("lua/src")
+    includedirs("readline")
+    includedirs("readline/compat")
     files("clink/app/test/*.cpp")
     files("clink/core/test/*.cpp")
     files("clink/lua/test/*.cpp")
@@ -324,3 +328,4 @@ clink_exe("clink_test")
 dofile("docs/premake5.lua")
 dofile("installer/premake5.lua")
 dofile("embed.lua")
+dofile("wcwidth.lua")
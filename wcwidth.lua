@@ -0,0 +1,170 @@
+-- Copyright (c) 2018 Martin Ridgers
+-- License: http://opensource.org/licenses/MIT
+
+--------------------------------------------------------------------------------
+-- Reads 'UnicodeData.txt' and 'EastAsianWidth.txt' from the Unicode Character
+-- Database and writes the two-stage table that wcwidth() looks cell widths up
+-- in. Each stage two block covers 256 code points at two bits a code point.
+local block_shift = 8
+local block_size = 256
+
+--------------------------------------------------------------------------------
+local function for_each_line(file, func)
+    local file_in = io.open(file, "r")
+    if not file_in then
+        error("Unable to open '"..file.."'")
+    end
+
+    for line in file_in:lines() do
+        line = line:gsub("#.*", "")
+        if line:find("%S") then
+            func(line)
+        end
+    end
+
+    file_in:close()
+end
+
+--------------------------------------------------------------------------------
+local function read_widths(ucd)
+    local widths = {}
+    local function set(first, last, width)
+        for c = first, last do
+            widths[c] = width
+        end
+    end
+
+    -- Wide (W) and full-width (F) characters are two cells. Unassigned code
+    -- points in the CJK blocks are listed as wide too.
+    for_each_line(path.join(ucd, "EastAsianWidth.txt"), function (line)
+        local _, _, first, last, class = line:find("^(%x+)%.?%.?(%x*)%s*;%s*(%a+)")
+        if class == "W" or class == "F" then
+            first = tonumber(first, 16)
+            last = (last ~= "") and tonumber(last, 16) or first
+            set(first, last, 2)
+        end
+    end)
+
+    -- Non-spacing and enclosing marks and format characters don't take up
+    -- any cells. Ranges are given as a "<..., First>" and "<..., Last>" pair.
+    local range_first
+    for_each_line(path.join(ucd, "UnicodeData.txt"), function (line)
+        local _, _, c, name, cat = line:find("^(%x+);([^;]*);(%a+)")
+        c = tonumber(c, 16)
+        if name:find(", First>$") then
+            range_first = c
+            return
+        end
+
+        local first = range_first or c
+        range_first = nil
+        if cat == "Mn" or cat == "Me" or cat == "Cf" then
+            set(first, c, 0)
+        end
+    end)
+
+    -- Soft hyphen is printed. Hangul Jamo medial vowels and final consonants
+    -- combine with the initial consonant before them.
+    widths[0x00ad] = 1
+    set(0x1160, 0x11ff, 0)
+    set(0xd7b0, 0xd7ff, 0)
+
+    return widths
+end
+
+--------------------------------------------------------------------------------
+local function read_version(ucd)
+    local file_in = io.open(path.join(ucd, "EastAsianWidth.txt"), "r")
+    local line = file_in and file_in:read("*l") or ""
+    if file_in then
+        file_in:close()
+    end
+
+    return line:match("EastAsianWidth%-([%d.]+)%.txt") or "?"
+end
+
+--------------------------------------------------------------------------------
+local function do_wcwidth()
+    local ucd = _OPTIONS["ucd"]
+    if not ucd then
+        error("The Unicode data's directory must be given with --ucd=DIR")
+    end
+
+    local widths = read_widths(ucd)
+
+    -- Pack each block into bytes and share identical blocks.
+    local stage1 = {}
+    local stage2 = {}
+    local block_ids = {}
+    for base = 0, 0x10ffff, block_size do
+        local bytes = {}
+        for i = 0, block_size - 1, 4 do
+            local byte = 0
+            for j = 3, 0, -1 do
+                byte = (byte * 4) + (widths[base + i + j] or 1)
+            end
+            table.insert(bytes, string.format("0x%02x", byte))
+        end
+
+        local block = table.concat(bytes, ",")
+        local id = block_ids[block]
+        if not id then
+            id = #stage2
+            block_ids[block] = id
+            table.insert(stage2, bytes)
+        end
+
+        table.insert(stage1, id)
+    end
+
+    if #stage2 > 256 then
+        error("Too many unique blocks for an 8-bit index ("..#stage2..")")
+    end
+
+    local out_path = "clink/terminal/src/wcwidth_table.h"
+    local out = io.open(out_path, "w")
+    out:write("// Generated by 'premake5 wcwidth' from Unicode "..read_version(ucd).." data.\n")
+    out:write("// Don't edit it by hand.\n\n")
+    out:write("#pragma once\n\n")
+    out:write("static const int g_wcwidth_block_shift = "..block_shift..";\n\n")
+
+    out:write("static const unsigned char g_wcwidth_stage1[] = {\n")
+    for i = 1, #stage1, 16 do
+        local row = {}
+        for j = i, math.min(i + 15, #stage1) do
+            table.insert(row, string.format("%3d,", stage1[j]))
+        end
+        out:write("    "..table.concat(row, " ").."\n")
+    end
+    out:write("};\n\n")
+
+    out:write("static const unsigned char g_wcwidth_stage2[]["..string.format("%d", block_size / 4).."] = {\n")
+    for _, bytes in ipairs(stage2) do
+        out:write("    {\n")
+        for i = 1, #bytes, 16 do
+            out:write("        "..table.concat(bytes, ", ", i, i + 15)..",\n")
+        end
+        out:write("    },\n")
+    end
+    out:write("};\n")
+    out:close()
+
+    print(out_path)
+    print("   "..#stage1.." index bytes, "..#stage2.." blocks")
+end
+
+--------------------------------------------------------------------------------
+newoption {
+   trigger     = "ucd",
+   value       = "DIR",
+   description = "Directory containing the Unicode Character Database files"
+}
+
+--------------------------------------------------------------------------------
+newaction {
+    trigger = "wcwidth",
+    description = "Generates wcwidth()'s table from the Unicode Character Database",
+    execute = function ()
+        do_wcwidth()
+    end
+}